@@ -0,0 +1,67 @@
+#include "buoyancy.hpp"
+#include "sim_clock.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+namespace
+{
+
+// One physics tick: advance the geometric waves, rebuild the grids around state.range(0)
+// bodies over a beach that shoals towards +x, then sample 10k hull points split among them.
+// The budget in buoyancy.hpp is for the whole tick.
+void BM_BuoyancyTick(benchmark::State& state)
+{
+    const size_t num_queries = 10000;
+    auto num_bodies = size_t(state.range(0));
+
+    std::vector<unsigned char> ramp(256 * 256);
+    for (size_t i = 0; i < ramp.size(); ++i)
+    {
+        ramp[i] = static_cast<unsigned char>(i % 256 * 3 / 4);
+    }
+
+    auto clock = msb::SimClock::fixedStep(1. / 60.);
+    msb::WaveRng rng(1);
+    msb::WaveBank bank(msb::makeGeomWaves(rng, clock.now()), 2);
+    msb::BuoyancyQueries queries{msb::Bathymetry(msb::PixelView{ramp.data(), 256, 256, 1})};
+
+    // 3 m hulls scattered over the water, each sampled on a disc around its center
+    std::vector<msb::BodyBounds> bodies;
+    std::vector<std::vector<float>> hull_x(num_bodies);
+    std::vector<std::vector<float>> hull_z(num_bodies);
+    for (size_t b = 0; b < num_bodies; ++b)
+    {
+        bodies.push_back({25.f + 40.f * rng.uniform(), -5.f - 40.f * rng.uniform(), 3.f});
+        for (size_t i = 0; i < num_queries / num_bodies; ++i)
+        {
+            hull_x[b].push_back(bodies[b].x + 6.f * rng.uniform() - 3.f);
+            hull_z[b].push_back(bodies[b].z + 6.f * rng.uniform() - 3.f);
+        }
+    }
+
+    msb::WaterSamples samples;
+    for (auto _ : state)
+    {
+        bank.update(clock.tick());
+        queries.update(bank, bodies);
+        for (size_t b = 0; b < num_bodies; ++b)
+        {
+            queries.sample(b, hull_x[b], hull_z[b], samples);
+            benchmark::DoNotOptimize(samples.height.data());
+        }
+    }
+
+    state.counters["grid_points"] = double(queries.gridPoints());
+    state.SetItemsProcessed(state.iterations() * num_queries);
+}
+BENCHMARK(BM_BuoyancyTick)
+    ->ArgName("bodies")
+    ->Arg(1)
+    ->Arg(20)
+    ->Arg(100)
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace
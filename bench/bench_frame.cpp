@@ -0,0 +1,87 @@
+#include "bench_gl.hpp"
+
+#include "offscreen.hpp"
+#include "scene.hpp"
+#include "sim_clock.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+
+namespace
+{
+
+// Camera for frame n of the scripted path: a slow pass along the shore that starts at main's
+// default view, dips toward the waterline and turns from the open sea onto the beach
+void scriptedCamera(CameraState& camera, int frame)
+{
+    auto angle = 6.2831853f * float(frame % 600) / 600.f;
+    auto yaw = glm::radians(-90.f + 30.f * std::sin(angle));
+    auto pitch = glm::radians(-20.f + 10.f * std::cos(angle));
+
+    camera.setCameraPosition(glm::vec3(8.f * std::sin(angle), 3.f - std::sin(angle), 3.f));
+    camera.setCameraFront(glm::vec3(std::cos(yaw) * std::cos(pitch), std::sin(pitch),
+                                    std::sin(yaw) * std::cos(pitch)));
+}
+
+// The frame from main.cpp at state.range(0) x state.range(1) pixels, finished with glFinish so
+// the GPU time is included.  Every run walks the same camera path at a fixed 60 Hz step.
+void BM_RenderFrame(benchmark::State& state)
+{
+    if (!msb::benchContext())
+    {
+        state.SkipWithError("could not create GL context");
+        return;
+    }
+
+    auto width = int(state.range(0));
+    auto height = int(state.range(1));
+
+    msb::TextureLoader textures;
+    auto clock = msb::SimClock::fixedStep(1. / 60.);
+    msb::Scene scene(textures, msb::VertexPacking::Compact, clock.now());
+    textures.finish();
+
+    msb::OffscreenTarget target(width, height);
+    if (!target.complete())
+    {
+        state.SkipWithError("offscreen framebuffer is incomplete");
+        return;
+    }
+    target.bind();
+
+    CameraState camera(nullptr);
+    camera.aspect = float(width) / float(height);
+
+    msb::Profiler profiler;
+    int frame = 0;
+    for (auto _ : state)
+    {
+        profiler.beginFrame();
+        scriptedCamera(camera, frame++);
+        clock.tick();
+        scene.draw(clock, camera, profiler);
+        glFinish();
+        profiler.endFrame();
+    }
+
+    state.counters["fps"] =
+        benchmark::Counter(double(state.iterations()), benchmark::Counter::kIsRate);
+    state.counters["frame_p95_ms"] = profiler.frameTimes().percentile(.95);
+    state.counters["beach_gpu_ms"] = profiler.zoneMedian("beach", true);
+    state.counters["ocean_gpu_ms"] = profiler.zoneMedian("ocean", true);
+    state.counters["wait_waves_ms"] = profiler.zoneMedian("wait waves", false);
+    state.counters["upload_frame_ms"] = profiler.zoneMedian("upload frame", false);
+    state.SetLabel(reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+BENCHMARK(BM_RenderFrame)
+    ->ArgNames({"width", "height"})
+    ->Args({800, 600})
+    ->Args({1280, 720})
+    ->Args({1920, 1080})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+} // namespace
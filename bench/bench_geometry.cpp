@@ -0,0 +1,79 @@
+#include "bench_gl.hpp"
+
+#include "clipmap.hpp"
+#include "terrain.hpp"
+
+#include <benchmark/benchmark.h>
+
+namespace
+{
+
+// Grid step for state.range(0) vertices per meter on the 65 x 50 ocean plane from main.cpp
+double planeStep(benchmark::State& state) { return 1. / double(state.range(0)); }
+
+// Ocean plane generation, reported in vertices per second
+void BM_GetPlane(benchmark::State& state)
+{
+    size_t vertices = 0;
+    for (auto _ : state)
+    {
+        auto plane = msb::getPlane(65, 50, planeStep(state), 10, msb::IndexMode::Strips16);
+        vertices = plane.first.size();
+        benchmark::DoNotOptimize(plane.second.indices16.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * int64_t(vertices));
+}
+BENCHMARK(BM_GetPlane)->Arg(5)->Arg(10)->Arg(20)->Arg(40)->Unit(benchmark::kMillisecond);
+
+// Camera-relative clipmap that replaced the plane in the app, state.range(0) cells per ring
+void BM_GetClipmap(benchmark::State& state)
+{
+    msb::ClipmapSettings settings;
+    settings.ring_quads = int(state.range(0));
+
+    size_t vertices = 0;
+    for (auto _ : state)
+    {
+        auto clipmap = msb::getClipmap(settings);
+        vertices = clipmap.first.size() / 3;
+        benchmark::DoNotOptimize(clipmap.second.indices32.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * int64_t(vertices));
+}
+BENCHMARK(BM_GetClipmap)->Arg(16)->Arg(32)->Arg(64)->Unit(benchmark::kMillisecond);
+
+// Mesh construction from a generated plane: vertex packing plus the buffer uploads, finished
+// with glFinish so the driver copy is included
+void BM_MeshConstruction(benchmark::State& state)
+{
+    if (!msb::benchContext())
+    {
+        state.SkipWithError("could not create GL context");
+        return;
+    }
+
+    auto packing = state.range(1) ? msb::VertexPacking::Compact : msb::VertexPacking::Float;
+    auto plane = msb::getPlane(65, 50, planeStep(state), 10, msb::IndexMode::Strips16);
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto vertices = plane.first;
+        auto indices = plane.second;
+        state.ResumeTiming();
+
+        msb::Mesh mesh(std::move(vertices), std::move(indices), {}, packing);
+        glFinish();
+        benchmark::DoNotOptimize(mesh);
+    }
+
+    state.SetItemsProcessed(state.iterations() * int64_t(plane.first.size()));
+}
+BENCHMARK(BM_MeshConstruction)
+    ->ArgNames({"per_meter", "compact"})
+    ->ArgsProduct({{5, 10, 20}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
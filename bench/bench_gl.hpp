@@ -0,0 +1,19 @@
+#pragma once
+
+#include "window_management.hpp"
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+namespace msb
+{
+
+// Hidden 3.3 core context shared by the GL benchmarks, nullptr if one cannot be created.  Without
+// a display this falls back to EGL or OSMesa, e.g. llvmpipe on a GPU-less node.
+inline GLFWwindow* benchContext()
+{
+    static GLFWwindow* window = initializeHeadless(64, 64);
+    return window;
+}
+
+} // namespace msb
@@ -0,0 +1,42 @@
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifndef BEACH_GIT_COMMIT
+#define BEACH_GIT_COMMIT "unknown"
+#endif
+
+// benchmark_main plus two defaults for tracking results across commits: the JSON report goes to
+// beach_bench.json unless --benchmark_out is given, and it records the commit that was built.
+int main(int argc, char** argv)
+{
+    std::vector<char*> args(argv, argv + argc);
+
+    auto has_out = false;
+    for (auto arg : args)
+    {
+        has_out = has_out || std::strncmp(arg, "--benchmark_out=", 16) == 0;
+    }
+
+    std::string out = "--benchmark_out=beach_bench.json";
+    std::string format = "--benchmark_out_format=json";
+    if (!has_out)
+    {
+        args.push_back(out.data());
+        args.push_back(format.data());
+    }
+
+    auto count = int(args.size());
+    benchmark::Initialize(&count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(count, args.data()))
+    {
+        return 1;
+    }
+
+    benchmark::AddCustomContext("git_commit", BEACH_GIT_COMMIT);
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include "mesh_optimize.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+// Cache + fetch optimization of a state.range(0)^2 grid whose triangles arrive in random order,
+// reported in triangles per second
+void BM_OptimizeMesh(benchmark::State& state)
+{
+    auto size = static_cast<size_t>(state.range(0));
+    std::vector<float> vertices;
+    for (size_t i = 0; i < size; ++i)
+    {
+        for (size_t j = 0; j < size; ++j)
+        {
+            vertices.insert(vertices.end(), {float(j), 0.f, -float(i)});
+        }
+    }
+
+    std::vector<std::array<unsigned int, 3>> triangles;
+    for (size_t i = 0; i + 1 < size; ++i)
+    {
+        for (size_t j = 0; j + 1 < size; ++j)
+        {
+            auto idx = static_cast<unsigned int>(i * size + j);
+            auto c = static_cast<unsigned int>(size);
+            triangles.push_back({idx, idx + c, idx + c + 1});
+            triangles.push_back({idx, idx + c + 1, idx + 1});
+        }
+    }
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(7));
+
+    std::vector<unsigned int> indices;
+    for (auto& tri : triangles)
+    {
+        indices.insert(indices.end(), tri.begin(), tri.end());
+    }
+
+    msb::CacheStats stats = {};
+    for (auto _ : state)
+    {
+        auto v = vertices;
+        auto f = indices;
+        stats = msb::optimizeMesh(v, 3, f);
+        benchmark::DoNotOptimize(f.data());
+    }
+
+    state.counters["acmr_before"] = stats.acmr_before;
+    state.counters["acmr_after"] = stats.acmr_after;
+    state.SetItemsProcessed(state.iterations() * int64_t(triangles.size()));
+}
+BENCHMARK(BM_OptimizeMesh)->Arg(128)->Arg(256)->Arg(512)->Unit(benchmark::kMillisecond);
+
+} // namespace
@@ -0,0 +1,48 @@
+#include "fft.hpp"
+#include "ocean_spectrum.hpp"
+#include "sim_clock.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <complex>
+#include <vector>
+
+namespace
+{
+
+// The three grids one spectrum frame transforms
+void BM_Fft2d(benchmark::State& state)
+{
+    auto n = size_t(state.range(0));
+    msb::Fft2d fft(n);
+    std::vector<std::complex<float>> data(3 * n * n, {1.f, -1.f});
+
+    for (auto _ : state)
+    {
+        fft.inverse(data.data(), 3);
+        benchmark::DoNotOptimize(data.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * 3 * state.range(0) * state.range(0));
+}
+BENCHMARK(BM_Fft2d)->Arg(128)->Arg(256)->Arg(512)->Unit(benchmark::kMicrosecond);
+
+// A whole frame on the CPU: spectrum advance, FFTs and map packing, without the upload
+void BM_OceanSpectrum(benchmark::State& state)
+{
+    msb::SpectrumSettings settings;
+    settings.size = int(state.range(0));
+    msb::OceanSpectrum spectrum(settings);
+    auto clock = msb::SimClock::fixedStep(1. / 60.);
+
+    for (auto _ : state)
+    {
+        spectrum.evaluate(clock.tick());
+        benchmark::DoNotOptimize(spectrum.displacement().data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(0));
+}
+BENCHMARK(BM_OceanSpectrum)->Arg(128)->Arg(256)->Arg(512)->Unit(benchmark::kMicrosecond);
+
+} // namespace
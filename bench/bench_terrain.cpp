@@ -0,0 +1,36 @@
+#include "terrain.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+namespace
+{
+
+// Terrain build from synthetic height/normal maps of state.range(0)^2 pixels, reported in
+// vertices per second
+void BM_GetTerrain(benchmark::State& state)
+{
+    auto size = static_cast<int>(state.range(0));
+    std::vector<unsigned char> height(size_t(size) * size * 3);
+    std::vector<unsigned char> normals(size_t(size) * size * 3);
+
+    for (size_t i = 0; i < height.size(); ++i)
+    {
+        height[i] = static_cast<unsigned char>((i * 7) % 255);
+        normals[i] = static_cast<unsigned char>(i % 3 == 2 ? 255 : 128);
+    }
+
+    for (auto _ : state)
+    {
+        msb::PixelView ht_img = {height.data(), size, size, 3};
+        msb::PixelView norm_img = {normals.data(), size, size, 3};
+        auto terrain = msb::getTerrain(ht_img, norm_img, 50, 50);
+        benchmark::DoNotOptimize(terrain.first.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * size * size);
+}
+BENCHMARK(BM_GetTerrain)->Arg(512)->Arg(1024)->Arg(2048)->Arg(4096)->Unit(benchmark::kMillisecond);
+
+} // namespace
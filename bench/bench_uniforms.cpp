@@ -0,0 +1,290 @@
+#include "bench_gl.hpp"
+
+#include "gl_helpers.hpp"
+#include "shader.hpp"
+#include "sim_clock.hpp"
+#include "wave.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+// Uniform traffic of one ocean frame from main.cpp: light/camera uniforms followed by the
+// geometric and texture wave arrays.  The legacy variant reproduces the old Shader setters
+// (glUseProgram + glGetUniformLocation per call, string keys built every frame, one uniform per
+// wave field); the streamed variant writes the camera block and the packed wave arrays into a
+// StreamBuffer and binds their ranges, as Scene does.  The legacy lookups now resolve to -1, but
+// the call pattern and its driver cost are the same.
+
+namespace
+{
+
+constexpr size_t num_tex_waves = 32;
+
+// Count GL calls made by the uniform path by wrapping the loaded glad entry points
+size_t gl_calls = 0;
+
+PFNGLUSEPROGRAMPROC real_use_program;
+PFNGLGETUNIFORMLOCATIONPROC real_get_uniform_location;
+PFNGLUNIFORM1FPROC real_uniform1f;
+PFNGLUNIFORM2FPROC real_uniform2f;
+PFNGLUNIFORM3FPROC real_uniform3f;
+PFNGLUNIFORMMATRIX4FVPROC real_uniform_matrix4fv;
+PFNGLBINDBUFFERPROC real_bind_buffer;
+PFNGLBUFFERDATAPROC real_buffer_data;
+PFNGLBINDBUFFERRANGEPROC real_bind_buffer_range;
+PFNGLMAPBUFFERRANGEPROC real_map_buffer_range;
+
+void APIENTRY countUseProgram(GLuint program)
+{
+    ++gl_calls;
+    real_use_program(program);
+}
+
+GLint APIENTRY countGetUniformLocation(GLuint program, const GLchar* name)
+{
+    ++gl_calls;
+    return real_get_uniform_location(program, name);
+}
+
+void APIENTRY countUniform1f(GLint location, GLfloat v0)
+{
+    ++gl_calls;
+    real_uniform1f(location, v0);
+}
+
+void APIENTRY countUniform2f(GLint location, GLfloat v0, GLfloat v1)
+{
+    ++gl_calls;
+    real_uniform2f(location, v0, v1);
+}
+
+void APIENTRY countUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2)
+{
+    ++gl_calls;
+    real_uniform3f(location, v0, v1, v2);
+}
+
+void APIENTRY countUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose,
+                                    const GLfloat* value)
+{
+    ++gl_calls;
+    real_uniform_matrix4fv(location, count, transpose, value);
+}
+
+void APIENTRY countBindBuffer(GLenum target, GLuint buffer)
+{
+    ++gl_calls;
+    real_bind_buffer(target, buffer);
+}
+
+void APIENTRY countBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+{
+    ++gl_calls;
+    real_buffer_data(target, size, data, usage);
+}
+
+void APIENTRY countBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset,
+                                   GLsizeiptr size)
+{
+    ++gl_calls;
+    real_bind_buffer_range(target, index, buffer, offset, size);
+}
+
+void* APIENTRY countMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length,
+                                   GLbitfield access)
+{
+    ++gl_calls;
+    return real_map_buffer_range(target, offset, length, access);
+}
+
+struct CallCounter
+{
+    CallCounter()
+    {
+        real_use_program = glad_glUseProgram;
+        real_get_uniform_location = glad_glGetUniformLocation;
+        real_uniform1f = glad_glUniform1f;
+        real_uniform2f = glad_glUniform2f;
+        real_uniform3f = glad_glUniform3f;
+        real_uniform_matrix4fv = glad_glUniformMatrix4fv;
+        real_bind_buffer = glad_glBindBuffer;
+        real_buffer_data = glad_glBufferData;
+        real_bind_buffer_range = glad_glBindBufferRange;
+        real_map_buffer_range = glad_glMapBufferRange;
+
+        glad_glUseProgram = countUseProgram;
+        glad_glGetUniformLocation = countGetUniformLocation;
+        glad_glUniform1f = countUniform1f;
+        glad_glUniform2f = countUniform2f;
+        glad_glUniform3f = countUniform3f;
+        glad_glUniformMatrix4fv = countUniformMatrix4fv;
+        glad_glBindBuffer = countBindBuffer;
+        glad_glBufferData = countBufferData;
+        glad_glBindBufferRange = countBindBufferRange;
+        glad_glMapBufferRange = countMapBufferRange;
+
+        gl_calls = 0;
+    }
+
+    ~CallCounter()
+    {
+        glad_glUseProgram = real_use_program;
+        glad_glGetUniformLocation = real_get_uniform_location;
+        glad_glUniform1f = real_uniform1f;
+        glad_glUniform2f = real_uniform2f;
+        glad_glUniform3f = real_uniform3f;
+        glad_glUniformMatrix4fv = real_uniform_matrix4fv;
+        glad_glBindBuffer = real_bind_buffer;
+        glad_glBufferData = real_buffer_data;
+        glad_glBindBufferRange = real_bind_buffer_range;
+        glad_glMapBufferRange = real_map_buffer_range;
+    }
+};
+
+void legacySetFloat(unsigned int id, const std::string& name, float value)
+{
+    glUseProgram(id);
+    Shader::resetBoundProgram();
+    glUniform1f(glGetUniformLocation(id, name.c_str()), value);
+}
+
+void legacySetVec2(unsigned int id, const std::string& name, glm::vec2 value)
+{
+    glUseProgram(id);
+    Shader::resetBoundProgram();
+    glUniform2f(glGetUniformLocation(id, name.c_str()), value.x, value.y);
+}
+
+void legacySetVec3(unsigned int id, const std::string& name, glm::vec3 value)
+{
+    glUseProgram(id);
+    Shader::resetBoundProgram();
+    glUniform3f(glGetUniformLocation(id, name.c_str()), value.x, value.y, value.z);
+}
+
+void legacySetMat4(unsigned int id, const std::string& name, const glm::mat4& value)
+{
+    glUseProgram(id);
+    Shader::resetBoundProgram();
+    glUniformMatrix4fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void legacyUpdateWaves(unsigned int id, std::vector<msb::Wave>& waves, std::string var_name,
+                       float total_chop, msb::WaveRng& rng, double t)
+{
+    for (size_t i = 0; i < waves.size(); ++i)
+    {
+        std::string idx = "[" + std::to_string(i) + "]";
+
+        auto amplitude = waves[i].amplitude(t);
+
+        if (!amplitude)
+        {
+            waves[i].resetWave(rng, t);
+            amplitude = waves[i].amplitude(t);
+            legacySetVec2(id, var_name + idx + ".wave_dirs", waves[i].direction());
+            legacySetFloat(id, var_name + idx + ".freq", waves[i].freq());
+        }
+
+        auto chop = total_chop / (waves[i].freq() * waves[i].amplitude(t) * waves.size());
+
+        legacySetFloat(id, var_name + idx + ".amplitude", amplitude);
+        legacySetFloat(id, var_name + idx + ".phase", waves[i].phase(t));
+        legacySetFloat(id, var_name + idx + ".phase_offset", waves[i].phase_offset());
+        legacySetFloat(id, var_name + idx + ".chop", chop);
+    }
+}
+
+void BM_OceanUniformsLegacy(benchmark::State& state)
+{
+    if (!msb::benchContext())
+    {
+        state.SkipWithError("could not create GL context");
+        return;
+    }
+
+    Shader shader("shaders/ocean.vert", "shaders/ocean_pbr2.frag");
+    auto clock = msb::SimClock::fixedStep(1. / 60.);
+    msb::WaveRng rng(1);
+    auto waves = msb::makeGeomWaves(rng, clock.now());
+    auto tx_waves = msb::makeTexWaves(num_tex_waves, rng, clock.now());
+    auto mat = glm::mat4(1.0f);
+    auto vec = glm::vec3(1.0f, -.25f, 0.f);
+
+    CallCounter counter;
+    for (auto _ : state)
+    {
+        legacySetVec3(shader.id, "dir_light.direction", vec);
+        legacySetMat4(shader.id, "model", mat);
+        legacySetMat4(shader.id, "view", mat);
+        legacySetMat4(shader.id, "projection", mat);
+        legacySetVec3(shader.id, "cam_pos", vec);
+        auto t = clock.tick();
+        legacyUpdateWaves(shader.id, waves, "geom_waves", 0.5f, rng, t);
+        legacyUpdateWaves(shader.id, tx_waves, "tex_waves", 0.f, rng, t);
+    }
+
+    state.counters["gl_calls_per_frame"] =
+        benchmark::Counter(double(gl_calls), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_OceanUniformsLegacy);
+
+void BM_OceanUniformsStreamed(benchmark::State& state)
+{
+    if (!msb::benchContext())
+    {
+        state.SkipWithError("could not create GL context");
+        return;
+    }
+
+    Shader shader("shaders/ocean.vert", "shaders/ocean_pbr2.frag");
+    auto clock = msb::SimClock::fixedStep(1. / 60.);
+    msb::WaveRng rng(1);
+    auto waves = msb::makeGeomWaves(rng, clock.now());
+    auto tx_waves = msb::makeTexWaves(num_tex_waves, rng, clock.now());
+    msb::WaveBank geom_bank(waves, 2);
+    msb::WaveBank tex_bank(tx_waves, 3);
+    msb::WaveBlock geom_block("GeomWaveBlock", waves.size(), 0);
+    msb::WaveBlock tex_block("TexWaveBlock", tx_waves.size(), 1);
+    geom_block.attach(shader);
+    tex_block.attach(shader);
+    msb::attachUniformBlock(shader, "FrameBlock", 2);
+    msb::StreamBuffer stream(8192);
+    std::vector<msb::WaveStd140> geom_packed;
+    std::vector<msb::WaveStd140> tex_packed;
+
+    // FrameBlock: projection, view, cam_pos and grid_center padded to 16 bytes each
+    struct
+    {
+        glm::mat4 projection = glm::mat4(1.0f);
+        glm::mat4 view = glm::mat4(1.0f);
+        glm::vec4 cam_pos = glm::vec4(1.0f, -.25f, 0.f, 0.f);
+        glm::vec4 grid_center = glm::vec4(0.f);
+    } constants;
+
+    CallCounter counter;
+    for (auto _ : state)
+    {
+        stream.beginFrame();
+        stream.bindUniform(2, &constants, sizeof(constants));
+        auto t = clock.tick();
+        geom_bank.update(t);
+        tex_bank.update(t);
+        msb::WaveBlock::pack(geom_bank, 0.5f, geom_packed);
+        msb::WaveBlock::pack(tex_bank, 0.f, tex_packed);
+        stream.bindUniform(geom_block.binding(), geom_packed.data(),
+                           geom_packed.size() * sizeof(msb::WaveStd140));
+        stream.bindUniform(tex_block.binding(), tex_packed.data(),
+                           tex_packed.size() * sizeof(msb::WaveStd140));
+        stream.endFrame();
+    }
+
+    state.counters["gl_calls_per_frame"] =
+        benchmark::Counter(double(gl_calls), benchmark::Counter::kAvgIterations);
+    state.counters["persistent"] = stream.persistent() ? 1 : 0;
+}
+BENCHMARK(BM_OceanUniformsStreamed);
+
+} // namespace
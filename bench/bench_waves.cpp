@@ -0,0 +1,84 @@
+#include "sim_clock.hpp"
+#include "wave.hpp"
+
+#include <benchmark/benchmark.h>
+
+namespace
+{
+
+// Scalar per-wave path: envelope and phase evaluated wave by wave
+void BM_WaveScalarUpdate(benchmark::State& state)
+{
+    auto clock = msb::SimClock::fixedStep(1. / 60.);
+    msb::WaveRng rng(1);
+    auto waves = msb::makeTexWaves(state.range(0), rng, clock.now());
+
+    for (auto _ : state)
+    {
+        auto t = clock.tick();
+        for (auto& wave : waves)
+        {
+            benchmark::DoNotOptimize(wave.amplitude(t));
+            benchmark::DoNotOptimize(wave.phase(t));
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_WaveScalarUpdate)->Arg(32)->Arg(256)->Arg(4096);
+
+void BM_WaveBankUpdate(benchmark::State& state)
+{
+    auto clock = msb::SimClock::fixedStep(1. / 60.);
+    msb::WaveRng rng(1);
+    msb::WaveBank bank(msb::makeTexWaves(state.range(0), rng, clock.now()), 2);
+
+    for (auto _ : state)
+    {
+        bank.update(clock.tick());
+        benchmark::DoNotOptimize(bank.amplitudes().data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_WaveBankUpdate)->Arg(32)->Arg(256)->Arg(4096);
+
+// Batched surface queries against the 32 texture waves, the largest bank the scene keeps
+void BM_WaveFieldQuery(benchmark::State& state)
+{
+    msb::WaveRng rng(1);
+    msb::WaveBank bank(msb::makeTexWaves(32, rng, 0.), 2);
+    bank.update(10.);
+    msb::WaveField field(bank);
+
+    msb::WavePoints points;
+    for (auto i = 0; i < state.range(0); ++i)
+    {
+        points.x.push_back(100.f * rng.uniform() - 50.f);
+        points.z.push_back(100.f * rng.uniform() - 50.f);
+        points.depth.push_back(5.f * rng.uniform());
+    }
+
+    msb::WaveSurface surface;
+    msb::WaveField::HeightScratch scratch;
+    for (auto _ : state)
+    {
+        if (state.range(1))
+        {
+            field.heights(points, surface, scratch);
+        }
+        else
+        {
+            field.evaluate(points, surface);
+        }
+        benchmark::DoNotOptimize(surface.dy.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_WaveFieldQuery)
+    ->ArgNames({"points", "heights"})
+    ->ArgsProduct({{256, 4096, 65536}, {0, 1}})
+    ->UseRealTime();
+
+} // namespace
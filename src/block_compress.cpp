@@ -0,0 +1,571 @@
+#include "block_compress.hpp"
+
+#include "mapped_file.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+namespace msb
+{
+
+namespace
+{
+
+constexpr unsigned char ktx_identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '1',
+                                              '1',  0xBB, '\r', '\n', 0x1A, '\n'};
+constexpr uint32_t ktx_endianness = 0x04030201;
+
+struct KtxHeader
+{
+    unsigned char identifier[12];
+    uint32_t endianness;
+    uint32_t gl_type;
+    uint32_t gl_type_size;
+    uint32_t gl_format;
+    uint32_t gl_internal_format;
+    uint32_t gl_base_internal_format;
+    uint32_t pixel_width;
+    uint32_t pixel_height;
+    uint32_t pixel_depth;
+    uint32_t array_elements;
+    uint32_t faces;
+    uint32_t mip_levels;
+    uint32_t key_value_bytes;
+};
+
+float srgbToLinear(float c)
+{
+    return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+float linearToSrgb(float c)
+{
+    return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.f / 2.4f) - 0.055f;
+}
+
+unsigned char toByte(float c)
+{
+    return static_cast<unsigned char>(std::lround(std::clamp(c, 0.f, 1.f) * 255.f));
+}
+
+uint16_t packRgb565(const float* rgb)
+{
+    auto r = uint16_t(std::lround(std::clamp(rgb[0], 0.f, 255.f) * 31.f / 255.f));
+    auto g = uint16_t(std::lround(std::clamp(rgb[1], 0.f, 255.f) * 63.f / 255.f));
+    auto b = uint16_t(std::lround(std::clamp(rgb[2], 0.f, 255.f) * 31.f / 255.f));
+    return uint16_t((r << 11) | (g << 5) | b);
+}
+
+std::array<int, 3> unpackRgb565(uint16_t c)
+{
+    int r = (c >> 11) & 31;
+    int g = (c >> 5) & 63;
+    int b = c & 31;
+    return {(r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)};
+}
+
+void storeLe16(unsigned char* out, uint16_t v)
+{
+    out[0] = static_cast<unsigned char>(v & 0xFF);
+    out[1] = static_cast<unsigned char>(v >> 8);
+}
+
+uint16_t loadLe16(const unsigned char* in)
+{
+    return uint16_t(in[0] | (in[1] << 8));
+}
+
+// BC4 palette for endpoints a0 > a1 (eight values) or a0 <= a1 (six values plus 0 and 255)
+std::array<int, 8> bc4Palette(int a0, int a1)
+{
+    std::array<int, 8> palette = {a0, a1};
+    if (a0 > a1)
+    {
+        for (int i = 2; i < 8; ++i)
+        {
+            palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+        }
+    }
+    else
+    {
+        for (int i = 2; i < 6; ++i)
+        {
+            palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+    return palette;
+}
+
+// 4x4 block at (bx, by) with edge pixels repeated past the image border
+void gatherBlock(const RgbaLevel& level, int bx, int by, unsigned char* block)
+{
+    for (int y = 0; y < 4; ++y)
+    {
+        auto sy = std::min(by * 4 + y, level.height - 1);
+        for (int x = 0; x < 4; ++x)
+        {
+            auto sx = std::min(bx * 4 + x, level.width - 1);
+            std::memcpy(block + 4 * (4 * y + x), &level.pixels[4 * (size_t(sy) * level.width + sx)],
+                        4);
+        }
+    }
+}
+
+void encodeBlock(BlockFormat format, const unsigned char* rgba, unsigned char* out)
+{
+    std::array<unsigned char, 16> channel;
+    auto extract = [&](int c) {
+        for (int i = 0; i < 16; ++i)
+        {
+            channel[i] = rgba[4 * i + c];
+        }
+        return channel.data();
+    };
+
+    switch (format)
+    {
+    case BlockFormat::BC1:
+        encodeBlockBC1(rgba, out);
+        break;
+    case BlockFormat::BC3:
+        encodeBlockBC4(extract(3), out);
+        encodeBlockBC1(rgba, out + 8);
+        break;
+    case BlockFormat::BC4:
+        encodeBlockBC4(extract(0), out);
+        break;
+    case BlockFormat::BC5:
+        encodeBlockBC4(extract(0), out);
+        encodeBlockBC4(extract(1), out + 8);
+        break;
+    }
+}
+
+} // namespace
+
+unsigned int glInternalFormat(BlockFormat format, bool srgb)
+{
+    switch (format)
+    {
+    case BlockFormat::BC1:
+        return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case BlockFormat::BC3:
+        return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case BlockFormat::BC4:
+        return GL_COMPRESSED_RED_RGTC1;
+    case BlockFormat::BC5:
+        return GL_COMPRESSED_RG_RGTC2;
+    }
+    return 0;
+}
+
+size_t blockBytes(BlockFormat format)
+{
+    return format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8 : 16;
+}
+
+std::vector<RgbaLevel> buildMipChain(const unsigned char* rgba, int width, int height, bool srgb,
+                                     bool normal_map)
+{
+    std::vector<RgbaLevel> levels;
+    levels.push_back({width, height, {rgba, rgba + 4 * size_t(width) * height}});
+
+    while (levels.back().width > 1 || levels.back().height > 1)
+    {
+        auto& src = levels.back();
+        RgbaLevel dst = {std::max(1, src.width / 2), std::max(1, src.height / 2), {}};
+        dst.pixels.resize(4 * size_t(dst.width) * dst.height);
+
+        parallelFor(0, size_t(dst.height), [&](size_t row_begin, size_t row_end) {
+            for (auto y = int(row_begin); y < int(row_end); ++y)
+            {
+                for (int x = 0; x < dst.width; ++x)
+                {
+                    float sum[4] = {};
+                    for (int k = 0; k < 4; ++k)
+                    {
+                        auto sx = std::min(2 * x + (k & 1), src.width - 1);
+                        auto sy = std::min(2 * y + (k >> 1), src.height - 1);
+                        auto px = &src.pixels[4 * (size_t(sy) * src.width + sx)];
+
+                        for (int c = 0; c < 4; ++c)
+                        {
+                            auto v = px[c] / 255.f;
+                            if (c < 3 && normal_map)
+                            {
+                                v = 2.f * v - 1.f;
+                            }
+                            else if (c < 3 && srgb)
+                            {
+                                v = srgbToLinear(v);
+                            }
+                            sum[c] += 0.25f * v;
+                        }
+                    }
+
+                    if (normal_map)
+                    {
+                        auto len = std::sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+                        for (int c = 0; c < 3; ++c)
+                        {
+                            sum[c] = len > 0.f ? 0.5f * sum[c] / len + 0.5f : 0.5f;
+                        }
+                    }
+                    else if (srgb)
+                    {
+                        for (int c = 0; c < 3; ++c)
+                        {
+                            sum[c] = linearToSrgb(sum[c]);
+                        }
+                    }
+
+                    auto out = &dst.pixels[4 * (size_t(y) * dst.width + x)];
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        out[c] = toByte(sum[c]);
+                    }
+                }
+            }
+        });
+
+        levels.push_back(std::move(dst));
+    }
+
+    return levels;
+}
+
+CompressedTexture compressTexture(const unsigned char* rgba, int width, int height,
+                                  BlockFormat format, bool srgb)
+{
+    auto normal_map = format == BlockFormat::BC5;
+    auto mips = buildMipChain(rgba, width, height, srgb && !normal_map, normal_map);
+
+    CompressedTexture texture;
+    texture.internal_format = glInternalFormat(format, srgb);
+
+    auto block_bytes = blockBytes(format);
+    for (auto& mip : mips)
+    {
+        auto blocks_x = (mip.width + 3) / 4;
+        auto blocks_y = (mip.height + 3) / 4;
+
+        CompressedLevel level = {mip.width, mip.height, {}};
+        level.data.resize(size_t(blocks_x) * blocks_y * block_bytes);
+
+        parallelFor(0, size_t(blocks_y), [&](size_t row_begin, size_t row_end) {
+            unsigned char block[64];
+            for (auto by = int(row_begin); by < int(row_end); ++by)
+            {
+                for (int bx = 0; bx < blocks_x; ++bx)
+                {
+                    gatherBlock(mip, bx, by, block);
+                    encodeBlock(format, block,
+                                &level.data[(size_t(by) * blocks_x + bx) * block_bytes]);
+                }
+            }
+        });
+
+        texture.levels.push_back(std::move(level));
+    }
+
+    return texture;
+}
+
+void encodeBlockBC1(const unsigned char* rgba, unsigned char* out)
+{
+    // principal axis of the block's colors by power iteration on the covariance
+    float mean[3] = {};
+    for (int i = 0; i < 16; ++i)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            mean[c] += rgba[4 * i + c] / 16.f;
+        }
+    }
+
+    float cov[6] = {};
+    for (int i = 0; i < 16; ++i)
+    {
+        float d[3] = {rgba[4 * i] - mean[0], rgba[4 * i + 1] - mean[1], rgba[4 * i + 2] - mean[2]};
+        cov[0] += d[0] * d[0];
+        cov[1] += d[0] * d[1];
+        cov[2] += d[0] * d[2];
+        cov[3] += d[1] * d[1];
+        cov[4] += d[1] * d[2];
+        cov[5] += d[2] * d[2];
+    }
+
+    float axis[3] = {1.f, 1.f, 1.f};
+    for (int iter = 0; iter < 8; ++iter)
+    {
+        float next[3] = {cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2],
+                         cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2],
+                         cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2]};
+        auto len = std::max({std::abs(next[0]), std::abs(next[1]), std::abs(next[2])});
+        if (len < 1e-6f)
+        {
+            break;
+        }
+        for (int c = 0; c < 3; ++c)
+        {
+            axis[c] = next[c] / len;
+        }
+    }
+
+    // extreme pixels along the axis, pulled in slightly to spend less range on outliers
+    int lo = 0;
+    int hi = 0;
+    float lo_t = 1e30f;
+    float hi_t = -1e30f;
+    for (int i = 0; i < 16; ++i)
+    {
+        auto t = rgba[4 * i] * axis[0] + rgba[4 * i + 1] * axis[1] + rgba[4 * i + 2] * axis[2];
+        if (t < lo_t)
+        {
+            lo_t = t;
+            lo = i;
+        }
+        if (t > hi_t)
+        {
+            hi_t = t;
+            hi = i;
+        }
+    }
+
+    float c_hi[3];
+    float c_lo[3];
+    for (int c = 0; c < 3; ++c)
+    {
+        auto inset = (rgba[4 * hi + c] - rgba[4 * lo + c]) / 16.f;
+        c_hi[c] = rgba[4 * hi + c] - inset;
+        c_lo[c] = rgba[4 * lo + c] + inset;
+    }
+
+    auto c0 = packRgb565(c_hi);
+    auto c1 = packRgb565(c_lo);
+
+    // c0 > c1 selects the four color mode
+    if (c0 < c1)
+    {
+        std::swap(c0, c1);
+    }
+
+    uint32_t indices = 0;
+    if (c0 != c1)
+    {
+        auto e0 = unpackRgb565(c0);
+        auto e1 = unpackRgb565(c1);
+        std::array<std::array<int, 3>, 4> palette;
+        for (int c = 0; c < 3; ++c)
+        {
+            palette[0][c] = e0[c];
+            palette[1][c] = e1[c];
+            palette[2][c] = (2 * e0[c] + e1[c]) / 3;
+            palette[3][c] = (e0[c] + 2 * e1[c]) / 3;
+        }
+
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0;
+            int best_dist = 1 << 30;
+            for (int p = 0; p < 4; ++p)
+            {
+                int dist = 0;
+                for (int c = 0; c < 3; ++c)
+                {
+                    auto d = rgba[4 * i + c] - palette[p][c];
+                    dist += d * d;
+                }
+                if (dist < best_dist)
+                {
+                    best_dist = dist;
+                    best = p;
+                }
+            }
+            indices |= uint32_t(best) << (2 * i);
+        }
+    }
+
+    storeLe16(out, c0);
+    storeLe16(out + 2, c1);
+    for (int k = 0; k < 4; ++k)
+    {
+        out[4 + k] = static_cast<unsigned char>(indices >> (8 * k));
+    }
+}
+
+void encodeBlockBC4(const unsigned char* values, unsigned char* out)
+{
+    auto [lo, hi] = std::minmax_element(values, values + 16);
+
+    // a0 > a1 selects the eight value mode
+    int a0 = *hi;
+    int a1 = *lo;
+    auto palette = bc4Palette(a0, a1);
+
+    uint64_t indices = 0;
+    if (a0 != a1)
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0;
+            for (int p = 1; p < 8; ++p)
+            {
+                if (std::abs(values[i] - palette[p]) < std::abs(values[i] - palette[best]))
+                {
+                    best = p;
+                }
+            }
+            indices |= uint64_t(best) << (3 * i);
+        }
+    }
+
+    out[0] = static_cast<unsigned char>(a0);
+    out[1] = static_cast<unsigned char>(a1);
+    for (int k = 0; k < 6; ++k)
+    {
+        out[2 + k] = static_cast<unsigned char>(indices >> (8 * k));
+    }
+}
+
+void decodeBlockBC1(const unsigned char* block, unsigned char* rgba)
+{
+    auto c0 = loadLe16(block);
+    auto c1 = loadLe16(block + 2);
+    auto e0 = unpackRgb565(c0);
+    auto e1 = unpackRgb565(c1);
+
+    std::array<std::array<int, 4>, 4> palette;
+    for (int c = 0; c < 3; ++c)
+    {
+        palette[0][c] = e0[c];
+        palette[1][c] = e1[c];
+        palette[2][c] = c0 > c1 ? (2 * e0[c] + e1[c]) / 3 : (e0[c] + e1[c]) / 2;
+        palette[3][c] = c0 > c1 ? (e0[c] + 2 * e1[c]) / 3 : 0;
+    }
+    palette[0][3] = palette[1][3] = palette[2][3] = 255;
+    palette[3][3] = c0 > c1 ? 255 : 0;
+
+    uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (uint32_t(block[7]) << 24);
+    for (int i = 0; i < 16; ++i)
+    {
+        auto& color = palette[(indices >> (2 * i)) & 3];
+        for (int c = 0; c < 4; ++c)
+        {
+            rgba[4 * i + c] = static_cast<unsigned char>(color[c]);
+        }
+    }
+}
+
+void decodeBlockBC4(const unsigned char* block, unsigned char* values)
+{
+    auto palette = bc4Palette(block[0], block[1]);
+
+    uint64_t indices = 0;
+    for (int k = 0; k < 6; ++k)
+    {
+        indices |= uint64_t(block[2 + k]) << (8 * k);
+    }
+
+    for (int i = 0; i < 16; ++i)
+    {
+        values[i] = static_cast<unsigned char>(palette[(indices >> (3 * i)) & 7]);
+    }
+}
+
+bool writeKtx(const std::string& path, const CompressedTexture& texture)
+{
+    if (texture.levels.empty())
+    {
+        return false;
+    }
+
+    KtxHeader header = {};
+    std::memcpy(header.identifier, ktx_identifier, sizeof(ktx_identifier));
+    header.endianness = ktx_endianness;
+    header.gl_type_size = 1;
+    header.gl_internal_format = texture.internal_format;
+    header.gl_base_internal_format = texture.internal_format == GL_COMPRESSED_RED_RGTC1 ? GL_RED
+                                     : texture.internal_format == GL_COMPRESSED_RG_RGTC2
+                                         ? GL_RG
+                                         : GL_RGBA;
+    header.pixel_width = uint32_t(texture.levels[0].width);
+    header.pixel_height = uint32_t(texture.levels[0].height);
+    header.faces = 1;
+    header.mip_levels = uint32_t(texture.levels.size());
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // block data sizes are multiples of 8, so no mip padding is needed
+    for (auto& level : texture.levels)
+    {
+        auto size = uint32_t(level.data.size());
+        out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        out.write(reinterpret_cast<const char*>(level.data.data()), std::streamsize(size));
+    }
+
+    return bool(out);
+}
+
+bool readKtx(const unsigned char* data, size_t size, CompressedTexture& texture)
+{
+    KtxHeader header;
+    if (data == nullptr || size < sizeof(header))
+    {
+        return false;
+    }
+
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.identifier, ktx_identifier, sizeof(ktx_identifier)) != 0 ||
+        header.endianness != ktx_endianness || header.gl_type != 0 || header.faces != 1)
+    {
+        return false;
+    }
+
+    texture.internal_format = header.gl_internal_format;
+    texture.levels.clear();
+
+    size_t offset = sizeof(header) + header.key_value_bytes;
+    int width = int(header.pixel_width);
+    int height = int(std::max(1u, header.pixel_height));
+
+    for (uint32_t i = 0; i < std::max(1u, header.mip_levels); ++i)
+    {
+        uint32_t level_size;
+        if (offset + sizeof(level_size) > size)
+        {
+            return false;
+        }
+        std::memcpy(&level_size, data + offset, sizeof(level_size));
+        offset += sizeof(level_size);
+
+        if (level_size > size - offset)
+        {
+            return false;
+        }
+
+        texture.levels.push_back({width, height, {data + offset, data + offset + level_size}});
+        offset += (level_size + 3) & ~3u;
+
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+
+    return true;
+}
+
+bool readKtx(const std::string& path, CompressedTexture& texture)
+{
+    MappedFile file(path);
+    return readKtx(file.data(), file.size(), texture);
+}
+
+} // namespace msb
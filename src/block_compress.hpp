@@ -0,0 +1,84 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <string>
+#include <vector>
+
+// S3TC enums are extension-only in a core profile loader
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+#ifndef GL_COMPRESSED_RED_RGTC1
+#define GL_COMPRESSED_RED_RGTC1 0x8DBB
+#endif
+#ifndef GL_COMPRESSED_RG_RGTC2
+#define GL_COMPRESSED_RG_RGTC2 0x8DBD
+#endif
+
+namespace msb
+{
+
+// 4x4 block formats: BC1 for opaque color, BC3 for color with alpha, BC4 for one channel (red)
+// and BC5 for two (red/green, e.g. tangent-space normal xy)
+enum class BlockFormat
+{
+    BC1,
+    BC3,
+    BC4,
+    BC5
+};
+
+unsigned int glInternalFormat(BlockFormat format, bool srgb);
+size_t blockBytes(BlockFormat format);
+
+struct CompressedLevel
+{
+    int width;
+    int height;
+    std::vector<unsigned char> data;
+};
+
+struct CompressedTexture
+{
+    unsigned int internal_format;
+    std::vector<CompressedLevel> levels; // full mip chain down to 1x1
+};
+
+struct RgbaLevel
+{
+    int width;
+    int height;
+    std::vector<unsigned char> pixels; // RGBA8
+};
+
+// Box-filtered mip chain down to 1x1.  srgb averages color in linear light; normal_map decodes
+// rgb as a unit vector and renormalizes after averaging.
+std::vector<RgbaLevel> buildMipChain(const unsigned char* rgba, int width, int height, bool srgb,
+                                     bool normal_map);
+
+// Encode every level of the mip chain; BC5 treats the input as a normal map
+CompressedTexture compressTexture(const unsigned char* rgba, int width, int height,
+                                  BlockFormat format, bool srgb);
+
+// Single blocks.  rgba holds 16 RGBA8 pixels in row order, values 16 bytes.
+void encodeBlockBC1(const unsigned char* rgba, unsigned char* out);
+void encodeBlockBC4(const unsigned char* values, unsigned char* out);
+void decodeBlockBC1(const unsigned char* block, unsigned char* rgba);
+void decodeBlockBC4(const unsigned char* block, unsigned char* values);
+
+// KTX 1.1 container with one face and a full mip chain
+bool writeKtx(const std::string& path, const CompressedTexture& texture);
+bool readKtx(const unsigned char* data, size_t size, CompressedTexture& texture);
+bool readKtx(const std::string& path, CompressedTexture& texture);
+
+} // namespace msb
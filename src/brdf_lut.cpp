@@ -0,0 +1,195 @@
+#include "brdf_lut.hpp"
+
+#include "mapped_file.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace msb
+{
+
+namespace
+{
+
+constexpr char lut_magic[4] = {'M', 'S', 'B', 'L'};
+constexpr float pi = 3.14159265359f;
+
+// Base-2 radical inverse, the second Hammersley coordinate
+float vanDerCorput(uint32_t bits)
+{
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return float(bits) * 2.3283064365386963e-10f;
+}
+
+// GGX half vectors for one roughness.  The view vector lies in the xz plane, so only the x and z
+// components of each sample are needed; they are kept as separate arrays so the per-texel loop
+// runs over contiguous floats.
+struct HalfVectors
+{
+    std::vector<float> x;
+    std::vector<float> z;
+};
+
+HalfVectors sampleGgx(float roughness, unsigned samples)
+{
+    HalfVectors h;
+    h.x.resize(samples);
+    h.z.resize(samples);
+    for (unsigned i = 0; i < samples; ++i)
+    {
+        // the shader's tangent frame around +z maps the sample's y onto x
+        auto half = importanceSampleGgx(hammersley(i, samples), roughness);
+        h.x[i] = half.y;
+        h.z[i] = half.z;
+    }
+    return h;
+}
+
+float geometrySchlickGgx(float n_dot_v, float k) { return n_dot_v / (n_dot_v * (1.f - k) + k); }
+
+glm::vec2 integrate(float n_dot_v, float roughness, const HalfVectors& h)
+{
+    auto v_x = std::sqrt(1.f - n_dot_v * n_dot_v);
+    auto v_z = n_dot_v;
+
+    auto k = roughness * roughness / 2.f;
+    auto g_v = geometrySchlickGgx(n_dot_v, k);
+
+    // branch-free so the compiler can vectorize over samples
+    float a = 0.f;
+    float b = 0.f;
+    auto samples = h.x.size();
+    for (size_t i = 0; i < samples; ++i)
+    {
+        auto v_dot_h = std::max(v_x * h.x[i] + v_z * h.z[i], 0.f);
+        auto n_dot_l = 2.f * v_dot_h * h.z[i] - v_z;
+        auto n_dot_h = std::max(h.z[i], 0.f);
+
+        auto g = g_v * geometrySchlickGgx(std::max(n_dot_l, 0.f), k);
+        auto g_vis = g * v_dot_h / (n_dot_h * n_dot_v);
+        auto c = 1.f - v_dot_h;
+        auto fc = c * c * c * c * c;
+
+        auto keep = n_dot_l > 0.f ? 1.f : 0.f;
+        a += keep * (1.f - fc) * g_vis;
+        b += keep * fc * g_vis;
+    }
+
+    return glm::vec2(a, b) / float(samples);
+}
+
+} // namespace
+
+glm::vec2 hammersley(unsigned i, unsigned n) { return {float(i) / float(n), vanDerCorput(i)}; }
+
+glm::vec3 importanceSampleGgx(const glm::vec2& xi, float roughness)
+{
+    auto a = roughness * roughness;
+
+    auto phi = 2.f * pi * xi.x;
+    auto cos_theta = std::sqrt((1.f - xi.y) / (1.f + (a * a - 1.f) * xi.y));
+    auto sin_theta = std::sqrt(1.f - cos_theta * cos_theta);
+
+    return {std::cos(phi) * sin_theta, std::sin(phi) * sin_theta, cos_theta};
+}
+
+glm::vec2 integrateBrdf(float n_dot_v, float roughness, unsigned samples)
+{
+    return integrate(n_dot_v, roughness, sampleGgx(roughness, samples));
+}
+
+std::vector<float> computeBrdfLut(int size, unsigned samples)
+{
+    std::vector<float> lut(size_t(size) * size * 2);
+
+    parallelFor(0, size_t(size), [&](size_t first, size_t last) {
+        for (auto row = first; row < last; ++row)
+        {
+            auto roughness = (float(row) + .5f) / float(size);
+            auto h = sampleGgx(roughness, samples);
+
+            auto out = lut.data() + row * size * 2;
+            for (int col = 0; col < size; ++col)
+            {
+                auto n_dot_v = (float(col) + .5f) / float(size);
+                auto ab = integrate(n_dot_v, roughness, h);
+                out[2 * col] = ab.x;
+                out[2 * col + 1] = ab.y;
+            }
+        }
+    });
+
+    return lut;
+}
+
+bool writeBrdfLut(const std::string& path, int size, unsigned samples,
+                  const std::vector<float>& lut)
+{
+    if (lut.size() != size_t(size) * size * 2)
+    {
+        return false;
+    }
+
+    BrdfLutHeader header = {};
+    std::memcpy(header.magic, lut_magic, sizeof(lut_magic));
+    header.version = brdf_lut_version;
+    header.size = uint32_t(size);
+    header.samples = samples;
+
+    auto tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            return false;
+        }
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(lut.data()),
+                  std::streamsize(lut.size() * sizeof(float)));
+
+        if (!out)
+        {
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tmp_path, path, error);
+    return !error;
+}
+
+bool readBrdfLut(const std::string& path, int& size, std::vector<float>& lut)
+{
+    MappedFile file(path);
+
+    BrdfLutHeader header;
+    if (file.data() == nullptr || file.size() < sizeof(header))
+    {
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    auto count = size_t(header.size) * header.size * 2;
+    if (std::memcmp(header.magic, lut_magic, sizeof(lut_magic)) != 0 ||
+        header.version != brdf_lut_version || header.size == 0 ||
+        file.size() != sizeof(header) + count * sizeof(float))
+    {
+        return false;
+    }
+
+    size = int(header.size);
+    lut.resize(count);
+    std::memcpy(lut.data(), file.data() + sizeof(header), count * sizeof(float));
+    return true;
+}
+
+} // namespace msb
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace msb
+{
+
+// Split-sum environment BRDF integrated with GGX importance sampling.  The table holds (scale,
+// bias) pairs for F0 with NdotV along x and roughness along y, sampled at texel centers, rows
+// bottom to top like the texture.
+constexpr int brdf_lut_size = 512;
+constexpr unsigned brdf_lut_samples = 1024;
+
+// File: BrdfLutHeader then size * size float pairs, native-endian
+constexpr uint32_t brdf_lut_version = 1;
+
+struct BrdfLutHeader
+{
+    char magic[4]; // "MSBL"
+    uint32_t version;
+    uint32_t size;
+    uint32_t samples;
+};
+
+// Point i of an n-point Hammersley set in [0, 1)^2
+glm::vec2 hammersley(unsigned i, unsigned n);
+
+// GGX-distributed half vector around +z for a Hammersley point, as in importanceSampleGGX
+glm::vec3 importanceSampleGgx(const glm::vec2& xi, float roughness);
+
+// Importance-sampled integral over a Hammersley set of the given size
+glm::vec2 integrateBrdf(float n_dot_v, float roughness, unsigned samples = brdf_lut_samples);
+
+// size * size (scale, bias) pairs, rows integrated in parallel
+std::vector<float> computeBrdfLut(int size = brdf_lut_size, unsigned samples = brdf_lut_samples);
+
+bool writeBrdfLut(const std::string& path, int size, unsigned samples,
+                  const std::vector<float>& lut);
+bool readBrdfLut(const std::string& path, int& size, std::vector<float>& lut);
+
+} // namespace msb
@@ -0,0 +1,193 @@
+#include "buoyancy.hpp"
+
+#include "image.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace msb
+{
+
+BuoyancyQueries::Node BuoyancyQueries::lerp(const Node& a, const Node& b, float f)
+{
+    Node node;
+    node.height = a.height + f * (b.height - a.height);
+    node.nx = a.nx + f * (b.nx - a.nx);
+    node.ny = a.ny + f * (b.ny - a.ny);
+    node.nz = a.nz + f * (b.nz - a.nz);
+    node.vx = a.vx + f * (b.vx - a.vx);
+    node.vy = a.vy + f * (b.vy - a.vy);
+    node.vz = a.vz + f * (b.vz - a.vz);
+    node.padding = 0.f;
+    return node;
+}
+
+Bathymetry::Bathymetry(const std::string& filename)
+{
+    // flipped like the texture, so rows run along +v
+    auto img = Image(filename);
+    if (img.data == nullptr)
+    {
+        std::cout << "Error: Could not load bathymetry " << filename << std::endl;
+        return;
+    }
+
+    *this = Bathymetry(PixelView{img.data, img.width, img.height, img.nrChannels});
+}
+
+Bathymetry::Bathymetry(PixelView heights)
+    : width_(heights.width), height_(heights.height),
+      elevation_(size_t(heights.width) * heights.height)
+{
+    for (size_t i = 0; i < elevation_.size(); ++i)
+    {
+        elevation_[i] = (heights.data[i * heights.channels] / 255.f - .5f) * 6.f;
+    }
+}
+
+float Bathymetry::elevation(float x, float z) const
+{
+    if (elevation_.empty())
+    {
+        return -std::numeric_limits<float>::infinity();
+    }
+
+    // texel centers sit at half-integers, as with GL_LINEAR
+    auto s = (x - 25.f) / 50.f * float(width_) - .5f;
+    auto t = -z / 50.f * float(height_) - .5f;
+    auto s0 = std::floor(s);
+    auto t0 = std::floor(t);
+    auto fs = s - s0;
+    auto ft = t - t0;
+
+    auto texel = [this](float column, float row) {
+        auto c = std::clamp(int(column), 0, width_ - 1);
+        auto r = std::clamp(int(row), 0, height_ - 1);
+        return elevation_[size_t(r) * width_ + c];
+    };
+
+    auto bottom = texel(s0, t0) + fs * (texel(s0 + 1.f, t0) - texel(s0, t0));
+    auto top = texel(s0, t0 + 1.f) + fs * (texel(s0 + 1.f, t0 + 1.f) - texel(s0, t0 + 1.f));
+    return bottom + ft * (top - bottom);
+}
+
+float Bathymetry::depth(float x, float z) const { return std::max(0.f, -elevation(x, z)); }
+
+void WaterSamples::resize(size_t count)
+{
+    for (auto channel : {&height, &nx, &ny, &nz, &vx, &vy, &vz})
+    {
+        channel->resize(count);
+    }
+}
+
+BuoyancyQueries::BuoyancyQueries(Bathymetry bathymetry, BuoyancySettings settings)
+    : bathymetry_(std::move(bathymetry)), settings_(settings)
+{
+}
+
+void BuoyancyQueries::update(const WaveBank& bank, const std::vector<BodyBounds>& bodies)
+{
+    field_.set(bank);
+
+    auto cell = settings_.cell;
+    grids_.clear();
+    points_.x.clear();
+    points_.z.clear();
+    points_.depth.clear();
+    sand_.clear();
+
+    for (auto& body : bodies)
+    {
+        // on the world lattice, so a drifting body does not make its grid swim
+        auto half = body.radius + settings_.margin;
+        Grid grid;
+        grid.x0 = std::floor((body.x - half) / cell) * cell;
+        grid.z0 = std::floor((body.z - half) / cell) * cell;
+        grid.columns = std::max(2, int(std::ceil((body.x + half) / cell - grid.x0 / cell)) + 1);
+        grid.rows = std::max(2, int(std::ceil((body.z + half) / cell - grid.z0 / cell)) + 1);
+        grid.first = points_.size();
+        grids_.push_back(grid);
+
+        for (int r = 0; r < grid.rows; ++r)
+        {
+            for (int c = 0; c < grid.columns; ++c)
+            {
+                auto x = grid.x0 + float(c) * cell;
+                auto z = grid.z0 + float(r) * cell;
+                auto sand = bathymetry_.elevation(x, z);
+                points_.x.push_back(x);
+                points_.z.push_back(z);
+                points_.depth.push_back(std::max(0.f, -sand));
+                sand_.push_back(sand);
+            }
+        }
+    }
+
+    field_.heights(points_, surface_, height_scratch_, settings_.iterations);
+
+    nodes_.resize(points_.size());
+    for (size_t i = 0; i < nodes_.size(); ++i)
+    {
+        auto& node = nodes_[i];
+        node.height = surface_.dy[i];
+        node.nx = surface_.nx[i];
+        node.ny = surface_.ny[i];
+        node.nz = surface_.nz[i];
+        node.vx = surface_.vx[i];
+        node.vy = surface_.vy[i];
+        node.vz = surface_.vz[i];
+
+        // ocean.vert keeps the surface 15 cm above the sand
+        if (node.height < sand_[i] + .15f)
+        {
+            node.height = sand_[i] + .15f;
+            node.vy = 0.f;
+        }
+    }
+}
+
+void BuoyancyQueries::sample(size_t body, const std::vector<float>& x, const std::vector<float>& z,
+                             WaterSamples& samples) const
+{
+    auto count = std::min(x.size(), z.size());
+    samples.resize(count);
+
+    auto grid = grids_[body];
+    auto inv_cell = 1.f / settings_.cell;
+    auto nodes = nodes_.data() + grid.first;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto s = std::clamp((x[i] - grid.x0) * inv_cell, 0.f, float(grid.columns - 1));
+        auto t = std::clamp((z[i] - grid.z0) * inv_cell, 0.f, float(grid.rows - 1));
+        auto c = std::min(int(s), grid.columns - 2);
+        auto r = std::min(int(t), grid.rows - 2);
+        auto fs = s - float(c);
+        auto ft = t - float(r);
+
+        auto corner = size_t(r) * grid.columns + c;
+        auto& n00 = nodes[corner];
+        auto& n01 = nodes[corner + 1];
+        auto& n10 = nodes[corner + grid.columns];
+        auto& n11 = nodes[corner + grid.columns + 1];
+
+        // along the two rows, then between them
+        auto water = lerp(lerp(n00, n01, fs), lerp(n10, n11, fs), ft);
+
+        samples.height[i] = water.height;
+        samples.vx[i] = water.vx;
+        samples.vy[i] = water.vy;
+        samples.vz[i] = water.vz;
+
+        auto inv_length =
+            1.f / std::sqrt(water.nx * water.nx + water.ny * water.ny + water.nz * water.nz);
+        samples.nx[i] = water.nx * inv_length;
+        samples.ny[i] = water.ny * inv_length;
+        samples.nz[i] = water.nz * inv_length;
+    }
+}
+
+} // namespace msb
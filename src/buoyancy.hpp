@@ -0,0 +1,120 @@
+#pragma once
+
+#include "terrain.hpp"
+#include "wave.hpp"
+
+#include <string>
+#include <vector>
+
+namespace msb
+{
+
+// Sea floor elevation from the bathymetry heightmap, sampled the way getElevation in ocean.vert
+// reads it: the first channel, bilinear with clamped edges, over a 50 x 50 m square starting at
+// x = 25 and running towards -z.  A map that failed to load is deep water everywhere.
+class Bathymetry
+{
+  public:
+    Bathymetry() = default;
+    explicit Bathymetry(const std::string& filename);
+    explicit Bathymetry(PixelView heights);
+
+    // meters relative to the still water level, negative under water
+    float elevation(float x, float z) const;
+    float depth(float x, float z) const;
+
+  private:
+    int width_ = 0;
+    int height_ = 0;
+    std::vector<float> elevation_;
+};
+
+struct BuoyancySettings
+{
+    // well under a tenth of the shortest geometric wavelength, so bilinear lookups stay within a
+    // few millimeters of the summed waves
+    float cell = .5f;
+    float margin = 1.f; // grid past each body's radius
+    int iterations = 5; // Newton steps of WaveField::heights
+};
+
+// Horizontal footprint of a floating body in world space
+struct BodyBounds
+{
+    float x;
+    float z;
+    float radius;
+};
+
+// Per query: water height above the still level, surface normal and water velocity
+struct WaterSamples
+{
+    std::vector<float> height;
+    std::vector<float> nx, ny, nz;
+    std::vector<float> vx, vy, vz;
+
+    void resize(size_t count);
+};
+
+// Water under floating bodies for the physics tick.  update() sums the geometric waves once
+// per tick on a coarse world-aligned grid around each body; sample() then answers any number of
+// hull points with bilinear lookups into the grid of their body, so the per-query cost does not
+// grow with the wave count.
+//
+// Heights follow the drawn surface, including the lift above the sand in the shallows.
+//
+// Latency budget: one tick for 20 bodies plus 10k samples within 1.1 ms, 7% of a 60 Hz tick,
+// on one core.  BM_BuoyancyTick/bodies:20 (bank update, update() and the samples) measured
+// 0.9-1.05 ms at -O2 on a single-core 2.0 GHz Xeon VM.  Grid cost grows with the bodies' area,
+// sample cost only with the number of samples.
+class BuoyancyQueries
+{
+  public:
+    explicit BuoyancyQueries(Bathymetry bathymetry, BuoyancySettings settings = {});
+
+    // Rebuild the grids for a bank updated to this tick, one per body in the order given
+    void update(const WaveBank& bank, const std::vector<BodyBounds>& bodies);
+
+    // Water at each (x[i], z[i]) near body; points past the grid take its edge
+    void sample(size_t body, const std::vector<float>& x, const std::vector<float>& z,
+                WaterSamples& samples) const;
+
+    const Bathymetry& bathymetry() const { return bathymetry_; }
+    size_t gridPoints() const { return nodes_.size(); }
+
+  private:
+    struct Grid
+    {
+        float x0;
+        float z0;
+        int columns; // along x
+        int rows;    // along z
+        size_t first;
+    };
+
+    // interleaved so a bilinear lookup touches four nearby records
+    struct Node
+    {
+        float height;
+        float nx, ny, nz;
+        float vx, vy, vz;
+        float padding;
+    };
+
+    static Node lerp(const Node& a, const Node& b, float f);
+
+    Bathymetry bathymetry_;
+    BuoyancySettings settings_;
+    WaveField field_;
+
+    std::vector<Grid> grids_;
+    std::vector<Node> nodes_;
+
+    // scratch reused across ticks
+    WavePoints points_;
+    WaveSurface surface_;
+    std::vector<float> sand_; // sea floor elevation under each grid point
+    WaveField::HeightScratch height_scratch_;
+};
+
+} // namespace msb
@@ -29,7 +29,9 @@ glm::mat4 CameraState::viewMatrix()
 
 glm::mat4 CameraState::projectionMatrix()
 {
-    return glm::perspective(glm::radians(fov), 800.0f / 600.0f, 0.1f, 200.0f);
+    // far enough for the whole ocean clipmap; a 24-bit depth buffer still resolves millimeters
+    // at the shoreline
+    return glm::perspective(glm::radians(fov), aspect, 0.1f, 2500.0f);
 }
 
 glm::vec3 CameraState::cameraPosition()
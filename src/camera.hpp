@@ -26,6 +26,7 @@ class CameraState
 
   public:
     float fov = 45.0f;
+    float aspect = 800.0f / 600.0f;
     float yaw = -90.0f;
     float pitch = 0.0f;
 
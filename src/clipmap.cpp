@@ -0,0 +1,136 @@
+#include "clipmap.hpp"
+
+#include "mesh_optimize.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <utility>
+
+namespace msb
+{
+
+float clipmapExtent(const ClipmapSettings& settings)
+{
+    return 2.f * float(settings.ring_quads) * std::ldexp(settings.base_step, settings.levels - 1);
+}
+
+GridGeometryF getClipmap(const ClipmapSettings& settings)
+{
+    const int r = settings.ring_quads;
+    const int n = 4 * r + 1; // lattice points along a side of every level
+
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+
+    // vertex index of each lattice point of the current and the next finer level, -1 for
+    // points inside the finer level
+    std::vector<int> current(size_t(n) * n, -1);
+    std::vector<int> finer(size_t(n) * n, -1);
+    auto at = [n](std::vector<int>& lattice, int i, int j) -> int& {
+        return lattice[size_t(i) * n + j];
+    };
+
+    auto addVertex = [&](int i, int j, float step) {
+        vertices.insert(vertices.end(), {float(i - 2 * r) * step, step, float(j - 2 * r) * step});
+        return int(vertices.size() / 3 - 1);
+    };
+
+    // counter-clockwise seen from above, like the getPlane triangles
+    auto addTriangle = [&](int a, int b, int c) {
+        auto pa = &vertices[3 * size_t(a)];
+        auto pb = &vertices[3 * size_t(b)];
+        auto pc = &vertices[3 * size_t(c)];
+        auto cross = (pb[2] - pa[2]) * (pc[0] - pa[0]) - (pb[0] - pa[0]) * (pc[2] - pa[2]);
+        if (cross < 0)
+        {
+            std::swap(b, c);
+        }
+        indices.insert(indices.end(), {unsigned(a), unsigned(b), unsigned(c)});
+    };
+
+    for (int level = 0; level < settings.levels; ++level)
+    {
+        auto step = std::ldexp(settings.base_step, level);
+        std::swap(current, finer);
+
+        for (int i = 0; i < n; ++i)
+        {
+            for (int j = 0; j < n; ++j)
+            {
+                auto ring = std::max(std::abs(i - 2 * r), std::abs(j - 2 * r));
+                if (level == 0 || ring > r)
+                {
+                    at(current, i, j) = addVertex(i, j, step);
+                }
+                else if (ring == r)
+                {
+                    // the same point on the finer level's outer edge
+                    at(current, i, j) = at(finer, 2 * i - 2 * r, 2 * j - 2 * r);
+                }
+                else
+                {
+                    at(current, i, j) = -1;
+                }
+            }
+        }
+
+        for (int i = 0; i < n - 1; ++i)
+        {
+            for (int j = 0; j < n - 1; ++j)
+            {
+                if (level > 0 && i >= r && i + 1 <= 3 * r && j >= r && j + 1 <= 3 * r)
+                {
+                    continue;
+                }
+
+                int corners[4][2] = {{i, j}, {i + 1, j}, {i + 1, j + 1}, {i, j + 1}};
+                auto onEdge = [&](int c) {
+                    auto ci = corners[c % 4][0] - 2 * r;
+                    auto cj = corners[c % 4][1] - 2 * r;
+                    return level > 0 && std::max(std::abs(ci), std::abs(cj)) == r;
+                };
+                auto index = [&](int c) {
+                    return at(current, corners[c % 4][0], corners[c % 4][1]);
+                };
+
+                // a cell against the finer level: b0-b1 is its edge there, o0-o1 the opposite one
+                int edge = -1;
+                for (int c = 0; c < 4 && edge < 0; ++c)
+                {
+                    if (onEdge(c) && onEdge(c + 1))
+                    {
+                        edge = c;
+                    }
+                }
+
+                if (edge < 0)
+                {
+                    addTriangle(index(0), index(1), index(2));
+                    addTriangle(index(0), index(2), index(3));
+                    continue;
+                }
+
+                auto b0 = index(edge);
+                auto b1 = index(edge + 1);
+                auto o1 = index(edge + 2);
+                auto o0 = index(edge + 3);
+                auto mi = corners[edge][0] + corners[(edge + 1) % 4][0] - 2 * r;
+                auto mj = corners[edge][1] + corners[(edge + 1) % 4][1] - 2 * r;
+                auto m = at(finer, mi, mj);
+
+                addTriangle(b0, m, o0);
+                addTriangle(m, o1, o0);
+                addTriangle(m, b1, o1);
+            }
+        }
+    }
+
+    optimizeMesh(vertices, 3, indices);
+
+    IndexData index_data;
+    index_data.indices32 = std::move(indices);
+    return {std::move(vertices), std::move(index_data)};
+}
+
+} // namespace msb
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "terrain.hpp"
+
+namespace msb
+{
+
+// Nested square grids centered on the origin for a camera-relative ocean surface.  Level 0 is a
+// full square of 4 * ring_quads cells at base_step; every further level doubles the step and
+// covers the ring between the previous level and twice its half-size, so each level keeps the
+// same vertex count while the covered area grows fourfold.
+//
+// Vertices are {x, step, z}: y holds the grid step of the level that owns the vertex, which
+// ocean.vert uses to move each level with the camera in whole steps.  The first row of every
+// ring shares the finer level's edge vertices and fans two fine edges into each coarse cell, so
+// the surface is watertight without T-junctions.
+struct ClipmapSettings
+{
+    float base_step = .1f;
+    int ring_quads = 32; // cells across each ring, and a quarter of the cells across level 0
+    int levels = 9;
+};
+
+// Half the side of the square covered by every level
+float clipmapExtent(const ClipmapSettings& settings);
+
+// Vertices with layout {3} and a 32-bit triangle list, ordered for the post-transform cache
+GridGeometryF getClipmap(const ClipmapSettings& settings = {});
+
+} // namespace msb
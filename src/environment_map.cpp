@@ -0,0 +1,501 @@
+#include "environment_map.hpp"
+
+#include "brdf_lut.hpp"
+#include "hash.hpp"
+#include "mapped_file.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace msb
+{
+
+namespace
+{
+
+constexpr char cache_magic[4] = {'M', 'S', 'B', 'E'};
+constexpr float pi = 3.14159265359f;
+
+struct EnvironmentCacheHeader
+{
+    char magic[4]; // "MSBE"
+    uint32_t version;
+    uint64_t key;
+    uint32_t num_levels[3]; // skybox, irradiance, prefiltered
+    uint32_t padding;
+};
+
+size_t faceFloats(int size) { return size_t(size) * size * 3; }
+
+CubeLevel emptyLevel(int size) { return {size, std::vector<float>(6 * faceFloats(size))}; }
+
+// Run fn(face, row) over every row of every face of a level
+template <typename Fn> void forEachRow(int size, Fn&& fn)
+{
+    parallelFor(0, size_t(6 * size), [&](size_t first, size_t last) {
+        for (auto i = first; i < last; ++i)
+        {
+            fn(int(i) / size, int(i) % size);
+        }
+    });
+}
+
+glm::vec3 texelDirection(int face, int x, int y, int size)
+{
+    auto u = (float(x) + .5f) / float(size);
+    auto v = (float(y) + .5f) / float(size);
+    return glm::normalize(cubeDirection(face, u, v));
+}
+
+// Trilinear lookup between the two mips around lod
+glm::vec3 sampleCubeLod(const CubeMap& cube, const glm::vec3& dir, float lod)
+{
+    auto last = int(cube.levels.size()) - 1;
+    lod = std::clamp(lod, 0.f, float(last));
+
+    auto l0 = int(lod);
+    auto l1 = std::min(l0 + 1, last);
+    auto t = lod - float(l0);
+
+    auto c0 = sampleCube(cube.levels[l0], dir);
+    return t > 0.f ? glm::mix(c0, sampleCube(cube.levels[l1], dir), t) : c0;
+}
+
+// Orthonormal frame around n, matching the shaders' importance sampling
+void tangentFrame(const glm::vec3& n, glm::vec3& tangent, glm::vec3& bitangent)
+{
+    auto up = std::abs(n.z) < 0.999f ? glm::vec3(0.f, 0.f, 1.f) : glm::vec3(1.f, 0.f, 0.f);
+    tangent = glm::normalize(glm::cross(up, n));
+    bitangent = glm::cross(n, tangent);
+}
+
+} // namespace
+
+glm::vec3 cubeDirection(int face, float u, float v)
+{
+    auto sc = 2.f * u - 1.f;
+    auto tc = 2.f * v - 1.f;
+
+    switch (face)
+    {
+    case 0:
+        return {1.f, -tc, -sc};
+    case 1:
+        return {-1.f, -tc, sc};
+    case 2:
+        return {sc, 1.f, tc};
+    case 3:
+        return {sc, -1.f, -tc};
+    case 4:
+        return {sc, -tc, 1.f};
+    default:
+        return {-sc, -tc, -1.f};
+    }
+}
+
+glm::vec3 sampleCube(const CubeLevel& level, const glm::vec3& dir)
+{
+    auto ax = std::abs(dir.x);
+    auto ay = std::abs(dir.y);
+    auto az = std::abs(dir.z);
+
+    // major axis selection from the GL spec, inverse of cubeDirection
+    int face;
+    float sc, tc, ma;
+    if (ax >= ay && ax >= az)
+    {
+        face = dir.x > 0.f ? 0 : 1;
+        sc = dir.x > 0.f ? -dir.z : dir.z;
+        tc = -dir.y;
+        ma = ax;
+    }
+    else if (ay >= az)
+    {
+        face = dir.y > 0.f ? 2 : 3;
+        sc = dir.x;
+        tc = dir.y > 0.f ? dir.z : -dir.z;
+        ma = ay;
+    }
+    else
+    {
+        face = dir.z > 0.f ? 4 : 5;
+        sc = dir.z > 0.f ? dir.x : -dir.x;
+        tc = -dir.y;
+        ma = az;
+    }
+
+    auto size = level.size;
+    auto fx = std::clamp((sc / ma + 1.f) * .5f * float(size) - .5f, 0.f, float(size - 1));
+    auto fy = std::clamp((tc / ma + 1.f) * .5f * float(size) - .5f, 0.f, float(size - 1));
+
+    auto x0 = int(fx);
+    auto y0 = int(fy);
+    auto x1 = std::min(x0 + 1, size - 1);
+    auto y1 = std::min(y0 + 1, size - 1);
+    auto wx = fx - float(x0);
+    auto wy = fy - float(y0);
+
+    auto texels = level.texels.data() + face * faceFloats(size);
+    auto texel = [&](int x, int y) {
+        auto p = texels + 3 * (size_t(y) * size + x);
+        return glm::vec3(p[0], p[1], p[2]);
+    };
+
+    auto top = glm::mix(texel(x0, y0), texel(x1, y0), wx);
+    auto bottom = glm::mix(texel(x0, y1), texel(x1, y1), wx);
+    return glm::mix(top, bottom, wy);
+}
+
+CubeLevel equirectToCube(const float* rgb, int width, int height, int size)
+{
+    auto cube = emptyLevel(size);
+
+    auto pixel = [&](int x, int y) {
+        auto p = rgb + 3 * (size_t(y) * width + x);
+        return glm::vec3(p[0], p[1], p[2]);
+    };
+
+    forEachRow(size, [&](int face, int y) {
+        auto out = cube.texels.data() + face * faceFloats(size) + 3 * size_t(y) * size;
+        for (int x = 0; x < size; ++x)
+        {
+            auto dir = texelDirection(face, x, y, size);
+            auto u = std::atan2(dir.z, -dir.x) / (2.f * pi) + .5f;
+            auto v = std::asin(std::clamp(dir.y, -1.f, 1.f)) / pi + .5f;
+
+            // wrap around the seam, clamp at the poles
+            auto fx = u * float(width) - .5f;
+            auto fy = std::clamp(v * float(height) - .5f, 0.f, float(height - 1));
+            auto x0 = int(std::floor(fx));
+            auto y0 = int(fy);
+            auto wx = fx - float(x0);
+            auto wy = fy - float(y0);
+            x0 = (x0 % width + width) % width;
+            auto x1 = (x0 + 1) % width;
+            auto y1 = std::min(y0 + 1, height - 1);
+
+            auto color = glm::mix(glm::mix(pixel(x0, y0), pixel(x1, y0), wx),
+                                  glm::mix(pixel(x0, y1), pixel(x1, y1), wx), wy);
+            out[3 * x] = color.x;
+            out[3 * x + 1] = color.y;
+            out[3 * x + 2] = color.z;
+        }
+    });
+
+    return cube;
+}
+
+CubeMap buildCubeMips(CubeLevel base)
+{
+    CubeMap cube;
+    cube.levels.push_back(std::move(base));
+
+    while (cube.levels.back().size > 1)
+    {
+        auto& src = cube.levels.back();
+        auto level = emptyLevel(src.size / 2);
+        auto size = level.size;
+
+        forEachRow(size, [&](int face, int y) {
+            auto in = src.texels.data() + face * faceFloats(src.size);
+            auto out = level.texels.data() + face * faceFloats(size) + 3 * size_t(y) * size;
+            for (int x = 0; x < size; ++x)
+            {
+                auto row0 = in + 3 * (size_t(2 * y) * src.size + 2 * x);
+                auto row1 = row0 + 3 * size_t(src.size);
+                for (int c = 0; c < 3; ++c)
+                {
+                    out[3 * x + c] = .25f * (row0[c] + row0[3 + c] + row1[c] + row1[3 + c]);
+                }
+            }
+        });
+
+        cube.levels.push_back(std::move(level));
+    }
+
+    return cube;
+}
+
+CubeLevel convolveIrradiance(const CubeLevel& source, int size)
+{
+    // every source texel as a direction and solid-angle weighted radiance, in flat arrays so the
+    // inner loop runs over contiguous floats
+    auto count = 6 * size_t(source.size) * source.size;
+    std::vector<float> dx(count), dy(count), dz(count), wr(count), wg(count), wb(count);
+
+    double total_angle = 0.;
+    for (int face = 0; face < 6; ++face)
+    {
+        for (int y = 0; y < source.size; ++y)
+        {
+            for (int x = 0; x < source.size; ++x)
+            {
+                auto i = (size_t(face) * source.size + y) * source.size + x;
+                auto dir = cubeDirection(face, (float(x) + .5f) / float(source.size),
+                                         (float(y) + .5f) / float(source.size));
+                auto len2 = glm::dot(dir, dir);
+                auto texel_size = 2.f / float(source.size);
+                auto angle = texel_size * texel_size / (len2 * std::sqrt(len2));
+                total_angle += angle;
+
+                dir = dir / std::sqrt(len2);
+                dx[i] = dir.x;
+                dy[i] = dir.y;
+                dz[i] = dir.z;
+                wr[i] = source.texels[3 * i] * angle;
+                wg[i] = source.texels[3 * i + 1] * angle;
+                wb[i] = source.texels[3 * i + 2] * angle;
+            }
+        }
+    }
+
+    // the texel solid angles are approximate; make them cover the sphere exactly
+    auto scale = float(4. * pi / total_angle) / pi;
+
+    auto irradiance = emptyLevel(size);
+    forEachRow(size, [&](int face, int y) {
+        auto out = irradiance.texels.data() + face * faceFloats(size) + 3 * size_t(y) * size;
+        for (int x = 0; x < size; ++x)
+        {
+            auto n = texelDirection(face, x, y, size);
+
+            float r = 0.f;
+            float g = 0.f;
+            float b = 0.f;
+            for (size_t i = 0; i < count; ++i)
+            {
+                auto c = std::max(n.x * dx[i] + n.y * dy[i] + n.z * dz[i], 0.f);
+                r += c * wr[i];
+                g += c * wg[i];
+                b += c * wb[i];
+            }
+
+            out[3 * x] = r * scale;
+            out[3 * x + 1] = g * scale;
+            out[3 * x + 2] = b * scale;
+        }
+    });
+
+    return irradiance;
+}
+
+CubeMap prefilterGgx(const CubeMap& source, int size, int levels, unsigned samples)
+{
+    auto source_size = float(source.levels[0].size);
+    auto texel_angle = 4.f * pi / (6.f * source_size * source_size);
+
+    CubeMap prefiltered;
+    for (int m = 0; m < levels; ++m)
+    {
+        auto level = emptyLevel(std::max(1, size >> m));
+        auto roughness = levels > 1 ? float(m) / float(levels - 1) : 0.f;
+
+        // light directions around +z with N = V, their cosine weights and source mips
+        struct Sample
+        {
+            glm::vec3 l;
+            float n_dot_l;
+            float lod;
+        };
+        std::vector<Sample> set;
+        if (roughness > 0.f)
+        {
+            auto a2 = roughness * roughness * roughness * roughness;
+            for (unsigned i = 0; i < samples; ++i)
+            {
+                auto h = importanceSampleGgx(hammersley(i, samples), roughness);
+                glm::vec3 l(2.f * h.z * h.x, 2.f * h.z * h.y, 2.f * h.z * h.z - 1.f);
+                if (l.z <= 0.f)
+                {
+                    continue;
+                }
+
+                // pdf of l is D / 4 when N = V
+                auto d = h.z * h.z * (a2 - 1.f) + 1.f;
+                auto pdf = a2 / (pi * d * d) / 4.f;
+                auto sample_angle = 1.f / (float(samples) * pdf + 1e-4f);
+                set.push_back({l, l.z, .5f * std::log2(sample_angle / texel_angle)});
+            }
+        }
+
+        auto base_lod = std::log2(source_size / float(level.size));
+        forEachRow(level.size, [&](int face, int y) {
+            auto out = level.texels.data() + face * faceFloats(level.size) +
+                       3 * size_t(y) * level.size;
+            for (int x = 0; x < level.size; ++x)
+            {
+                auto n = texelDirection(face, x, y, level.size);
+
+                glm::vec3 color;
+                if (set.empty())
+                {
+                    color = sampleCubeLod(source, n, base_lod);
+                }
+                else
+                {
+                    glm::vec3 tangent, bitangent;
+                    tangentFrame(n, tangent, bitangent);
+
+                    glm::vec3 sum(0.f);
+                    float weight = 0.f;
+                    for (auto& s : set)
+                    {
+                        auto l = tangent * s.l.x + bitangent * s.l.y + n * s.l.z;
+                        sum += sampleCubeLod(source, l, s.lod) * s.n_dot_l;
+                        weight += s.n_dot_l;
+                    }
+                    color = sum / weight;
+                }
+
+                out[3 * x] = color.x;
+                out[3 * x + 1] = color.y;
+                out[3 * x + 2] = color.z;
+            }
+        });
+
+        prefiltered.levels.push_back(std::move(level));
+    }
+
+    return prefiltered;
+}
+
+EnvironmentMaps buildEnvironmentMaps(const float* rgb, int width, int height,
+                                     const EnvironmentSizes& sizes)
+{
+    EnvironmentMaps maps;
+    maps.skybox = buildCubeMips(equirectToCube(rgb, width, height, sizes.skybox));
+
+    // a cosine lobe is smooth, so a coarse mip of the sky is plenty to integrate over
+    auto source = std::find_if(maps.skybox.levels.begin(), maps.skybox.levels.end(),
+                               [&](auto& level) { return level.size <= sizes.irradiance; });
+    if (source == maps.skybox.levels.end())
+    {
+        --source;
+    }
+    maps.irradiance.levels.push_back(convolveIrradiance(*source, sizes.irradiance));
+
+    maps.prefiltered =
+        prefilterGgx(maps.skybox, sizes.prefiltered, sizes.prefiltered_levels, sizes.samples);
+
+    return maps;
+}
+
+uint64_t environmentCacheKey(const std::string& hdr_file, const EnvironmentSizes& sizes)
+{
+    MappedFile file(hdr_file);
+    auto hash = fnv1a(file.data(), file.size());
+
+    int32_t params[] = {sizes.skybox, sizes.irradiance, sizes.prefiltered,
+                        sizes.prefiltered_levels, int32_t(sizes.samples)};
+    hash = fnv1a(params, sizeof(params), hash);
+    hash = fnv1a(&environment_cache_version, sizeof(environment_cache_version), hash);
+
+    return hash;
+}
+
+bool writeEnvironmentCache(const std::string& path, uint64_t key, const EnvironmentMaps& maps)
+{
+    const CubeMap* cubes[] = {&maps.skybox, &maps.irradiance, &maps.prefiltered};
+
+    EnvironmentCacheHeader header = {};
+    std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.version = environment_cache_version;
+    header.key = key;
+    for (int i = 0; i < 3; ++i)
+    {
+        header.num_levels[i] = uint32_t(cubes[i]->levels.size());
+    }
+
+    auto tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            return false;
+        }
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (auto cube : cubes)
+        {
+            for (auto& level : cube->levels)
+            {
+                auto size = uint32_t(level.size);
+                out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+                out.write(reinterpret_cast<const char*>(level.texels.data()),
+                          std::streamsize(level.texels.size() * sizeof(float)));
+            }
+        }
+
+        if (!out)
+        {
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tmp_path, path, error);
+    return !error;
+}
+
+bool readEnvironmentCache(const std::string& path, uint64_t key, EnvironmentMaps& maps)
+{
+    MappedFile file(path);
+
+    EnvironmentCacheHeader header;
+    if (file.data() == nullptr || file.size() < sizeof(header))
+    {
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    if (std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0 ||
+        header.version != environment_cache_version || header.key != key)
+    {
+        return false;
+    }
+
+    EnvironmentMaps loaded;
+    CubeMap* cubes[] = {&loaded.skybox, &loaded.irradiance, &loaded.prefiltered};
+
+    auto offset = sizeof(header);
+    for (int i = 0; i < 3; ++i)
+    {
+        for (uint32_t m = 0; m < header.num_levels[i]; ++m)
+        {
+            uint32_t size;
+            if (file.size() - offset < sizeof(size))
+            {
+                return false;
+            }
+            std::memcpy(&size, file.data() + offset, sizeof(size));
+            offset += sizeof(size);
+
+            constexpr uint32_t max_cache_size = 1u << 14;
+            auto bytes = 6 * faceFloats(int(size)) * sizeof(float);
+            if (size == 0 || size > max_cache_size || file.size() - offset < bytes)
+            {
+                return false;
+            }
+
+            auto level = emptyLevel(int(size));
+            std::memcpy(level.texels.data(), file.data() + offset, bytes);
+            offset += bytes;
+            cubes[i]->levels.push_back(std::move(level));
+        }
+    }
+
+    if (offset != file.size() || loaded.skybox.levels.empty() ||
+        loaded.irradiance.levels.empty() || loaded.prefiltered.levels.empty())
+    {
+        return false;
+    }
+
+    maps = std::move(loaded);
+    return true;
+}
+
+} // namespace msb
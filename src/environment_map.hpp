@@ -0,0 +1,76 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace msb
+{
+
+// Six square faces in GL order (+X, -X, +Y, -Y, +Z, -Z), face after face, RGB floats with rows
+// in upload order
+struct CubeLevel
+{
+    int size;
+    std::vector<float> texels;
+};
+
+struct CubeMap
+{
+    std::vector<CubeLevel> levels; // level 0 first
+};
+
+struct EnvironmentSizes
+{
+    int skybox = 512;
+    int irradiance = 32;
+    int prefiltered = 128;
+    int prefiltered_levels = 6;
+    unsigned samples = 256; // GGX samples per prefiltered texel
+};
+
+// Image-based lighting derived from one equirectangular HDR image
+struct EnvironmentMaps
+{
+    CubeMap skybox;      // radiance, full mip chain
+    CubeMap irradiance;  // cosine-weighted radiance over the hemisphere, divided by pi
+    CubeMap prefiltered; // GGX-filtered radiance, roughness level / (levels - 1)
+};
+
+// Direction through the point (u, v) in [0, 1]^2 of a face, unnormalized
+glm::vec3 cubeDirection(int face, float u, float v);
+
+// Bilinear lookup within the face dir points at; no filtering across face edges
+glm::vec3 sampleCube(const CubeLevel& level, const glm::vec3& dir);
+
+// Resample an equirectangular image onto the cube faces, u = atan(z, -x) / 2pi + 0.5 and
+// v = asin(y) / pi + 0.5; rgb rows bottom to top
+CubeLevel equirectToCube(const float* rgb, int width, int height, int size);
+
+// 2x2 box filter down to 1x1
+CubeMap buildCubeMips(CubeLevel base);
+
+// Sum over the texels of source weighted by solid angle and the cosine to each output normal
+CubeLevel convolveIrradiance(const CubeLevel& source, int size);
+
+// Split-sum prefilter (N = V = R) with GGX importance sampling; samples read a coarser source mip
+// as the sample's solid angle grows so sparse sets do not alias
+CubeMap prefilterGgx(const CubeMap& source, int size, int levels, unsigned samples);
+
+// Faces, texels and mip levels are processed in parallel
+EnvironmentMaps buildEnvironmentMaps(const float* rgb, int width, int height,
+                                     const EnvironmentSizes& sizes = {});
+
+// Binary cache: a header, then every level of the three cube maps as native-endian floats.
+// Rejected on a version or key mismatch.
+constexpr uint32_t environment_cache_version = 1;
+
+// FNV-1a over the HDR file, the sizes and the format version
+uint64_t environmentCacheKey(const std::string& hdr_file, const EnvironmentSizes& sizes);
+
+bool writeEnvironmentCache(const std::string& path, uint64_t key, const EnvironmentMaps& maps);
+bool readEnvironmentCache(const std::string& path, uint64_t key, EnvironmentMaps& maps);
+
+} // namespace msb
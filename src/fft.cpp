@@ -0,0 +1,178 @@
+#include "fft.hpp"
+
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MSB_FFT_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace msb
+{
+
+namespace
+{
+
+// without the inf/nan recovery that operator* adds to every product
+std::complex<float> multiply(std::complex<float> a, std::complex<float> b)
+{
+    return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+}
+
+} // namespace
+
+Fft2d::Fft2d(size_t size) : size_(size), reversed_(size)
+{
+    size_t bits = 0;
+    while ((size_t(1) << bits) < size)
+    {
+        ++bits;
+    }
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        size_t r = 0;
+        for (size_t b = 0; b < bits; ++b)
+        {
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        reversed_[i] = r;
+    }
+
+    // e^(-+2 pi i k / N) for the first half turn, in double so large sizes keep full precision
+    for (size_t k = 0; k < size / 2; ++k)
+    {
+        auto angle = 2. * 3.14159265358979323846 * double(k) / double(size);
+        forward_twiddles_.emplace_back(float(std::cos(angle)), float(-std::sin(angle)));
+        inverse_twiddles_.emplace_back(float(std::cos(angle)), float(std::sin(angle)));
+    }
+}
+
+void Fft2d::forward(std::complex<float>* data, size_t grids) const
+{
+    transform(data, grids, forward_twiddles_);
+}
+
+void Fft2d::inverse(std::complex<float>* data, size_t grids) const
+{
+    transform(data, grids, inverse_twiddles_);
+}
+
+void Fft2d::transform(std::complex<float>* data, size_t grids,
+                      const std::vector<std::complex<float>>& twiddles) const
+{
+    auto n = size_;
+
+    // the rows of every grid are contiguous
+    parallelFor(
+        0, grids * n, [&](size_t first, size_t last) { rows(data, first, last, twiddles); }, 16);
+
+    // column blocks, split where they cross from one grid into the next
+    parallelFor(
+        0, grids * n,
+        [&](size_t first, size_t last) {
+            while (first < last)
+            {
+                auto grid = first / n;
+                auto end = std::min(last, (grid + 1) * n);
+                columns(data + grid * n * n, first - grid * n, end - grid * n, twiddles);
+                first = end;
+            }
+        },
+        32);
+}
+
+void Fft2d::rows(std::complex<float>* data, size_t first, size_t last,
+                 const std::vector<std::complex<float>>& twiddles) const
+{
+    auto n = size_;
+
+    for (auto row = first; row < last; ++row)
+    {
+        auto x = data + row * n;
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (i < reversed_[i])
+            {
+                std::swap(x[i], x[reversed_[i]]);
+            }
+        }
+
+        for (size_t half = 1; half < n; half *= 2)
+        {
+            auto step = n / (2 * half);
+            for (size_t start = 0; start < n; start += 2 * half)
+            {
+                for (size_t j = 0; j < half; ++j)
+                {
+                    auto a = x[start + j];
+                    auto b = multiply(x[start + j + half], twiddles[j * step]);
+                    x[start + j] = a + b;
+                    x[start + j + half] = a - b;
+                }
+            }
+        }
+    }
+}
+
+void Fft2d::columns(std::complex<float>* grid, size_t first, size_t last,
+                    const std::vector<std::complex<float>>& twiddles) const
+{
+    auto n = size_;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (i < reversed_[i])
+        {
+            std::swap_ranges(grid + i * n + first, grid + i * n + last,
+                             grid + reversed_[i] * n + first);
+        }
+    }
+
+    for (size_t half = 1; half < n; half *= 2)
+    {
+        auto step = n / (2 * half);
+        for (size_t start = 0; start < n; start += 2 * half)
+        {
+            for (size_t j = 0; j < half; ++j)
+            {
+                auto w = twiddles[j * step];
+                auto a_row = grid + (start + j) * n;
+                auto b_row = grid + (start + j + half) * n;
+                auto c = first;
+
+#ifdef MSB_FFT_SSE2
+                // two complex values per register: b * w = (br wr - bi wi, bi wr + br wi)
+                auto wr = _mm_set1_ps(w.real());
+                auto wi = _mm_set_ps(w.imag(), -w.imag(), w.imag(), -w.imag());
+                for (; c + 2 <= last; c += 2)
+                {
+                    auto a_ptr = reinterpret_cast<float*>(a_row + c);
+                    auto b_ptr = reinterpret_cast<float*>(b_row + c);
+                    auto a = _mm_loadu_ps(a_ptr);
+                    auto b = _mm_loadu_ps(b_ptr);
+                    auto swapped = _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1));
+                    auto bw = _mm_add_ps(_mm_mul_ps(b, wr), _mm_mul_ps(swapped, wi));
+                    _mm_storeu_ps(a_ptr, _mm_add_ps(a, bw));
+                    _mm_storeu_ps(b_ptr, _mm_sub_ps(a, bw));
+                }
+#endif
+
+                for (; c < last; ++c)
+                {
+                    auto a = a_row[c];
+                    auto b = multiply(b_row[c], w);
+                    a_row[c] = a + b;
+                    b_row[c] = a - b;
+                }
+            }
+        }
+    }
+}
+
+} // namespace msb
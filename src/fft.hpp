@@ -0,0 +1,40 @@
+#pragma once
+
+#include <complex>
+#include <vector>
+
+namespace msb
+{
+
+// Radix-2 FFT of square power-of-two grids, in place and unscaled.  Rows are transformed one
+// per thread; columns are transformed in blocks of adjacent columns, so every butterfly runs
+// along contiguous memory (two complex values per SSE2 register).
+//
+// forward computes X(k) = sum_x x(x) e^(-2 pi i k x / N) over both axes, inverse the same with
+// e^(+...), so inverse(forward(x)) is x times N^2.
+class Fft2d
+{
+  public:
+    explicit Fft2d(size_t size);
+
+    size_t size() const { return size_; }
+
+    // `grids` size x size row-major grids stored back to back
+    void forward(std::complex<float>* data, size_t grids = 1) const;
+    void inverse(std::complex<float>* data, size_t grids = 1) const;
+
+  private:
+    size_t size_;
+    std::vector<size_t> reversed_; // bit-reversed index
+    std::vector<std::complex<float>> forward_twiddles_;
+    std::vector<std::complex<float>> inverse_twiddles_;
+
+    void transform(std::complex<float>* data, size_t grids,
+                   const std::vector<std::complex<float>>& twiddles) const;
+    void rows(std::complex<float>* data, size_t first, size_t last,
+              const std::vector<std::complex<float>>& twiddles) const;
+    void columns(std::complex<float>* grid, size_t first, size_t last,
+                 const std::vector<std::complex<float>>& twiddles) const;
+};
+
+} // namespace msb
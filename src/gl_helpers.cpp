@@ -2,20 +2,47 @@
 
 #include "gl_helpers.hpp"
 
-#include "geometry.hpp"
+#include "brdf_lut.hpp"
+#include "environment_map.hpp"
 #include "image.hpp"
 #include "shader.hpp"
 
 #include <glad/glad.h>
-#include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
+#include <GLFW/glfw3.h>
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <numeric>
 
+// GL 4.4 / GL_ARB_buffer_storage, beyond the 3.3 core profile the loader covers
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
 namespace msb
 {
 
+namespace
+{
+
+using BufferStorageFn = void(APIENTRY*)(GLenum target, GLsizeiptr size, const void* data,
+                                        GLbitfield flags);
+
+// glBufferStorage when the context has it, resolved once
+BufferStorageFn bufferStorage()
+{
+    static auto fn = glfwExtensionSupported("GL_ARB_buffer_storage")
+                         ? reinterpret_cast<BufferStorageFn>(glfwGetProcAddress("glBufferStorage"))
+                         : nullptr;
+    return fn;
+}
+
+} // namespace
+
 unsigned int fillBuffers(std::vector<float> vertices)
 {
     unsigned int VAO, VBO;
@@ -34,214 +61,274 @@ unsigned int fillBuffers(std::vector<float> vertices)
     return VAO;
 }
 
-unsigned int setHdrTexture(std::string filename)
+unsigned int loadCubemap(std::vector<std::string> faces)
 {
-    stbi_set_flip_vertically_on_load(true);
-    int width, height, nrComponents;
-    float* data = stbi_loadf(filename.c_str(), &width, &height, &nrComponents, 0);
-    unsigned int tex_id = 0;
-    if (data)
-    {
-        glGenTextures(1, &tex_id);
-        glBindTexture(GL_TEXTURE_2D, tex_id);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, data);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    unsigned int textureID;
+    glActiveTexture(GL_TEXTURE0);
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 
-        stbi_image_free(data);
-    }
-    else
+    for (auto i = 0; i < 6; ++i)
     {
-        std::cout << "Failed to load HDR image.\n";
+        Image img(faces[i], false);
+        if (img.nrChannels == 3)
+        {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, img.width, img.height, 0,
+                         GL_RGB, GL_UNSIGNED_BYTE, img.data);
+        }
+        else
+        {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA, img.width, img.height, 0,
+                         GL_RGBA, GL_UNSIGNED_BYTE, img.data);
+        }
     }
 
-    return tex_id;
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+    return textureID;
 }
 
-unsigned int setupFramebuffer(size_t x, size_t y)
+// Split-sum BRDF table as an RG16F texture, read from path or integrated on the CPU and saved
+// there when the file is missing or stale
+unsigned int loadBrdfLut(const std::string& path)
 {
-    unsigned int FBO, RBO;
-    glGenFramebuffers(1, &FBO);
-    glGenRenderbuffers(1, &RBO);
+    int size = 0;
+    std::vector<float> lut;
+    if (!readBrdfLut(path, size, lut))
+    {
+        size = brdf_lut_size;
+        lut = computeBrdfLut(size);
+        if (!writeBrdfLut(path, size, brdf_lut_samples, lut))
+        {
+            std::cout << "Failed to write BRDF LUT " << path << "\n";
+        }
+    }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
-    glBindRenderbuffer(GL_RENDERBUFFER, RBO);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, x, y);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, RBO);
+    unsigned int brdf_id;
+    glGenTextures(1, &brdf_id);
 
-    return FBO;
+    glBindTexture(GL_TEXTURE_2D, brdf_id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, size, size, 0, GL_RG, GL_FLOAT, lut.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return brdf_id;
 }
 
-unsigned int emptyCubeMap()
+unsigned int uploadCubeMap(const CubeMap& cube)
 {
     unsigned int cube_id;
-
     glGenTextures(1, &cube_id);
     glBindTexture(GL_TEXTURE_CUBE_MAP, cube_id);
-    for (auto i = 0; i < 6; ++i)
+
+    for (size_t m = 0; m < cube.levels.size(); ++m)
     {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 512, 512, 0, GL_RGB,
-                     GL_FLOAT, nullptr);
+        auto& level = cube.levels[m];
+        auto face_floats = size_t(level.size) * level.size * 3;
+        for (auto i = 0; i < 6; ++i)
+        {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, GLint(m), GL_RGB16F, level.size,
+                         level.size, 0, GL_RGB, GL_FLOAT, level.texels.data() + i * face_floats);
+        }
     }
 
+    auto mipmapped = cube.levels.size() > 1;
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER,
+                    mipmapped ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, GLint(cube.levels.size() - 1));
 
     return cube_id;
 }
 
-std::pair<unsigned int, unsigned int> renderCubeMap(unsigned int tex_id)
+EnvironmentTextures loadEnvironment(const std::string& hdr_file, const std::string& cache_path)
 {
-    glm::mat4 proj = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
-    std::vector<glm::mat4> capture_views = {
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f),
-                    glm::vec3(0.0f, -1.0f, 0.0f)),
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
-                    glm::vec3(0.0f, -1.0f, 0.0f)),
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f),
-                    glm::vec3(0.0f, 0.0f, 1.0f)),
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
-                    glm::vec3(0.0f, 0.0f, -1.0f)),
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f),
-                    glm::vec3(0.0f, -1.0f, 0.0f)),
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f),
-                    glm::vec3(0.0f, -1.0f, 0.0f))};
-
-    auto [v_cube, f_cube] = makeSkybox();
-    auto skybox_vao = fillBuffers(v_cube);
-
-    Shader shader("shaders/snap_cube.vert", "shaders/snap_cube.frag");
-    shader.setInt("equirectangularMap", 0);
-    shader.setMat4("projection", proj);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, tex_id);
-
-    auto FBO = setupFramebuffer(512, 512);
-    auto cubemap = emptyCubeMap();
+    EnvironmentSizes sizes;
+    auto key = environmentCacheKey(hdr_file, sizes);
 
-    glViewport(0, 0, 512, 512);
-    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
-
-    for (auto i = 0; i < 6; ++i)
+    EnvironmentMaps maps;
+    if (!readEnvironmentCache(cache_path, key, maps))
     {
-        shader.setMat4("view", capture_views[i]);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-                               GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, cubemap, 0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        Image img(hdr_file, ImageOptions{true, 3, PixelType::Float});
+        if (img.data == nullptr)
+        {
+            std::cout << "Failed to load HDR image.\n";
+            return {0, 0, 0, 0.f};
+        }
 
-        glBindVertexArray(skybox_vao);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        maps = buildEnvironmentMaps(img.dataf(), img.width, img.height, sizes);
+        if (!writeEnvironmentCache(cache_path, key, maps))
+        {
+            std::cout << "Failed to write environment cache " << cache_path << "\n";
+        }
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // the coarse prefiltered mips are only a few texels wide
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 
-    return {cubemap, skybox_vao};
+    EnvironmentTextures textures;
+    textures.skybox = uploadCubeMap(maps.skybox);
+    textures.irradiance = uploadCubeMap(maps.irradiance);
+    textures.prefiltered = uploadCubeMap(maps.prefiltered);
+    textures.prefiltered_max_lod = float(maps.prefiltered.levels.size() - 1);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+    return textures;
 }
 
-unsigned int loadCubemap(std::vector<std::string> faces)
+void attachUniformBlock(const Shader& shader, const std::string& block_name, unsigned int binding)
 {
-    unsigned int textureID;
-    glActiveTexture(GL_TEXTURE0);
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    auto index = glGetUniformBlockIndex(shader.id, block_name.c_str());
+    if (index == GL_INVALID_INDEX)
+    {
+        std::cout << "Uniform block " << block_name << " is not active" << std::endl;
+        return;
+    }
+    glUniformBlockBinding(shader.id, index, binding);
+}
 
-    for (auto i = 0; i < 6; ++i)
+StreamBuffer::StreamBuffer(size_t frame_bytes, int frames)
+    : frames_(std::max(1, frames)), fences_(size_t(std::max(1, frames)), nullptr)
+{
+    int alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    alignment_ = std::max<size_t>(alignment_, size_t(alignment));
+    region_bytes_ = (frame_bytes + alignment_ - 1) / alignment_ * alignment_;
+    auto total = GLsizeiptr(region_bytes_ * frames_);
+
+    glGenBuffers(1, &buffer_);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_);
+
+    if (auto storage = bufferStorage())
     {
-        Image img(faces[i], false);
-        if (img.nrChannels == 3)
-        {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, img.width, img.height, 0,
-                         GL_RGB, GL_UNSIGNED_BYTE, img.data);
-        }
-        else
-        {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA, img.width, img.height, 0,
-                         GL_RGBA, GL_UNSIGNED_BYTE, img.data);
-        }
+        // written through the mapping for the buffer's whole life; coherent, so no flushes
+        auto flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        storage(GL_COPY_WRITE_BUFFER, total, nullptr, flags);
+        mapped_ = static_cast<unsigned char*>(
+            glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, total, flags));
+    }
+    if (!mapped_)
+    {
+        glBufferData(GL_COPY_WRITE_BUFFER, total, nullptr, GL_STREAM_DRAW);
     }
 
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
 
-    return textureID;
+    // the first beginFrame() moves to region 0
+    region_ = frames_ - 1;
 }
 
-void renderQuad()
+StreamBuffer::~StreamBuffer()
 {
-    unsigned int quadVAO;
-    unsigned int quadVBO;
-
-    float quadVertices[] = {
-        // positions        // texture Coords
-        -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, -1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
-        1.0f,  1.0f, 0.0f, 1.0f, 1.0f, 1.0f,  -1.0f, 0.0f, 1.0f, 0.0f,
-    };
-
-    // setup plane VAO
-    glGenVertexArrays(1, &quadVAO);
-    glGenBuffers(1, &quadVBO);
-    glBindVertexArray(quadVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-
-    glBindVertexArray(quadVAO);
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glBindVertexArray(0);
+    for (auto fence : fences_)
+    {
+        if (fence)
+        {
+            glDeleteSync(static_cast<GLsync>(fence));
+        }
+    }
+    if (mapped_)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &buffer_);
 }
 
-unsigned int renderBrdfQuad()
+void StreamBuffer::beginFrame()
 {
-    unsigned int brdf_id;
-    glGenTextures(1, &brdf_id);
+    region_ = (region_ + 1) % frames_;
+    used_ = 0;
 
-    glBindTexture(GL_TEXTURE_2D, brdf_id);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, 512, 512, 0, GL_RG, GL_FLOAT, 0);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    auto& fence = fences_[region_];
+    if (!fence)
+    {
+        return;
+    }
 
-    Shader brdf_shader("shaders/brdf_lut.vert", "shaders/brdf_lut.frag");
+    // flush once so the fence is sure to signal, then wait in slices of 1 ms
+    auto sync = static_cast<GLsync>(fence);
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    while (true)
+    {
+        auto status = glClientWaitSync(sync, flags, 1000000);
+        if (status != GL_TIMEOUT_EXPIRED)
+        {
+            break;
+        }
+        flags = 0;
+    }
+    glDeleteSync(sync);
+    fence = nullptr;
+}
 
-    unsigned int captureFBO;
-    glGenFramebuffers(1, &captureFBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+void StreamBuffer::endFrame()
+{
+    auto& fence = fences_[region_];
+    if (fence)
+    {
+        glDeleteSync(static_cast<GLsync>(fence));
+    }
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
 
-    unsigned int captureRBO;
-    glGenRenderbuffers(1, &captureRBO);
-    glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
+std::optional<size_t> StreamBuffer::write(const void* data, size_t bytes)
+{
+    if (used_ + bytes > region_bytes_)
+    {
+        std::cout << "Stream buffer region of " << region_bytes_ << " bytes is full" << std::endl;
+        return std::nullopt;
+    }
 
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 512, 512);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, brdf_id, 0);
+    auto offset = region_ * region_bytes_ + used_;
+    used_ = std::min(region_bytes_, (used_ + bytes + alignment_ - 1) / alignment_ * alignment_);
 
-    auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-    if (status != GL_FRAMEBUFFER_COMPLETE)
+    if (mapped_)
     {
-        std::cout << "\nFramebuffer crapped out";
+        std::memcpy(mapped_ + offset, data, bytes);
+        return offset;
     }
 
-    glViewport(0, 0, 512, 512);
-    brdf_shader.use();
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    renderQuad();
+    // the fence in beginFrame() already guarantees the GPU is done with this range
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_);
+    auto dst = glMapBufferRange(GL_COPY_WRITE_BUFFER, GLintptr(offset), GLsizeiptr(bytes),
+                                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+                                    GL_MAP_UNSYNCHRONIZED_BIT);
+    if (dst)
+    {
+        std::memcpy(dst, data, bytes);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!dst)
+    {
+        std::cout << "Failed to map stream buffer" << std::endl;
+        return std::nullopt;
+    }
+    return offset;
+}
 
-    return brdf_id;
+bool StreamBuffer::bindUniform(unsigned int binding, const void* data, size_t bytes)
+{
+    auto offset = write(data, bytes);
+    if (!offset)
+    {
+        return false;
+    }
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer_, GLintptr(*offset), GLsizeiptr(bytes));
+    return true;
 }
 
-} // namespace msb
\ No newline at end of file
+} // namespace msb
@@ -1,16 +1,74 @@
 #pragma once
 
+#include <optional>
 #include <string>
 #include <vector>
 
+class Shader;
+
 namespace msb
 {
 
 unsigned int fillBuffers(std::vector<float> vertices);
-unsigned int setHdrTexture(std::string filename);
 unsigned int loadCubemap(std::vector<std::string> faces);
-std::pair<unsigned int, unsigned int> renderCubeMap(unsigned int hdr_tex_id);
-unsigned int renderBrdfQuad();
-void renderQuad();
+unsigned int loadBrdfLut(const std::string& path);
+
+struct EnvironmentTextures
+{
+    unsigned int skybox;
+    unsigned int irradiance;
+    unsigned int prefiltered;
+    float prefiltered_max_lod;
+};
+
+// Cube maps for image-based lighting from an equirectangular HDR image, read from cache_path or
+// built on the CPU and saved there
+EnvironmentTextures loadEnvironment(const std::string& hdr_file, const std::string& cache_path);
+
+// Bind a shader's uniform block to a binding point, reporting a block the shader does not use
+void attachUniformBlock(const Shader& shader, const std::string& block_name, unsigned int binding);
+
+// Ring of per-frame regions in one buffer object, for everything the CPU rewrites each frame:
+// uniform blocks and pixel uploads.  A frame only writes its own region, and the fence taken at
+// endFrame() tells when the GPU is done reading it, so writes neither wait on the driver nor
+// orphan storage.  With GL_ARB_buffer_storage the buffer stays persistently mapped; on plain GL
+// 3.3 each write maps its range unsynchronized instead.
+class StreamBuffer
+{
+  public:
+    // frame_bytes must hold every write of a frame, each rounded up to the uniform buffer offset
+    // alignment (at most 256 bytes on current drivers)
+    explicit StreamBuffer(size_t frame_bytes, int frames = 3);
+    ~StreamBuffer();
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    // Move to the next region, waiting only if the GPU is still reading it from `frames` ago
+    void beginFrame();
+
+    // Fence the region once every command that reads it has been issued
+    void endFrame();
+
+    // Copy into the current region and return the offset in the buffer, or nothing if the
+    // region is full
+    std::optional<size_t> write(const void* data, size_t bytes);
+
+    // Write a uniform block's data and bind it to `binding`
+    bool bindUniform(unsigned int binding, const void* data, size_t bytes);
+
+    unsigned int id() const { return buffer_; }
+    bool persistent() const { return mapped_ != nullptr; }
+
+  private:
+    unsigned int buffer_ = 0;
+    size_t alignment_ = 256;
+    size_t region_bytes_;
+    int frames_;
+    int region_ = 0;
+    size_t used_ = 0;
+    unsigned char* mapped_ = nullptr;
+    std::vector<void*> fences_; // GLsync per region
+};
 
 } // namespace msb
\ No newline at end of file
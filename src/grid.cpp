@@ -0,0 +1,115 @@
+#include "grid.hpp"
+
+#include "parallel.hpp"
+
+#include <algorithm>
+
+namespace msb
+{
+
+namespace
+{
+
+template <typename Index> Index* writeCellRow(Index* face, size_t top, size_t cols)
+{
+    auto bottom = top + cols;
+
+    for (size_t j = 0; j < cols - 1; ++j)
+    {
+        *face++ = static_cast<Index>(top + j);
+        *face++ = static_cast<Index>(bottom + j);
+        *face++ = static_cast<Index>(bottom + j + 1);
+
+        *face++ = static_cast<Index>(top + j);
+        *face++ = static_cast<Index>(bottom + j + 1);
+        *face++ = static_cast<Index>(top + j + 1);
+    }
+
+    return face;
+}
+
+// Zig-zag bottom, top, bottom, ... across the row.  The leading duplicate adds one degenerate
+// triangle so the strip's alternating winding lines up with the triangle list.
+unsigned short* writeStripRow(unsigned short* face, size_t top, size_t cols)
+{
+    auto bottom = top + cols;
+
+    *face++ = static_cast<unsigned short>(bottom);
+    for (size_t j = 0; j < cols; ++j)
+    {
+        *face++ = static_cast<unsigned short>(bottom + j);
+        *face++ = static_cast<unsigned short>(top + j);
+    }
+    *face++ = restart_index16;
+
+    return face;
+}
+
+} // namespace
+
+IndexData getGridIndices(size_t rows, size_t cols, IndexMode mode)
+{
+    IndexData out;
+
+    if (rows < 2 || cols < 2)
+    {
+        return out;
+    }
+
+    if (mode == IndexMode::Triangles32)
+    {
+        out.indices32.resize(6 * (rows - 1) * (cols - 1));
+
+        parallelFor(0, rows - 1, [&](size_t row_begin, size_t row_end) {
+            for (size_t i = row_begin; i < row_end; ++i)
+            {
+                writeCellRow(out.indices32.data() + i * (cols - 1) * 6, i * cols, cols);
+            }
+        });
+
+        return out;
+    }
+
+    // vertex rows per band, leaving the restart index unused for strips
+    auto max_vertices = size_t(mode == IndexMode::Strips16 ? restart_index16 : 0x10000);
+    auto band_rows = max_vertices / cols;
+
+    if (band_rows < 2)
+    {
+        return getGridIndices(rows, cols, IndexMode::Triangles32);
+    }
+
+    auto band_cells = band_rows - 1;
+    auto per_row = mode == IndexMode::Strips16 ? 2 * cols + 2 : 6 * (cols - 1);
+
+    out.primitive = mode == IndexMode::Strips16 ? GL_TRIANGLE_STRIP : GL_TRIANGLES;
+    out.indices16.resize(per_row * (rows - 1));
+
+    for (size_t first_row = 0; first_row < rows - 1; first_row += band_cells)
+    {
+        auto last_row = std::min(first_row + band_cells, rows - 1);
+        out.chunks.push_back(
+            {first_row * per_row, (last_row - first_row) * per_row, int(first_row * cols)});
+    }
+
+    parallelFor(0, rows - 1, [&](size_t row_begin, size_t row_end) {
+        for (size_t i = row_begin; i < row_end; ++i)
+        {
+            auto face = out.indices16.data() + i * per_row;
+            auto top = (i % band_cells) * cols;
+
+            if (mode == IndexMode::Strips16)
+            {
+                writeStripRow(face, top, cols);
+            }
+            else
+            {
+                writeCellRow(face, top, cols);
+            }
+        }
+    });
+
+    return out;
+}
+
+} // namespace msb
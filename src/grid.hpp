@@ -0,0 +1,17 @@
+#pragma once
+
+#include "mesh.hpp"
+
+namespace msb
+{
+
+// Indices for the row-major grids built by getTerrain and getPlane (rows x cols vertices, two
+// triangles per cell), in the same vertex order for every mode.
+//
+// Triangles32 reproduces the original triangle list.  Triangles16 splits the grid into bands of
+// rows that each fit in 16-bit indices and draws each band with its own base vertex.  Strips16
+// emits one strip per cell row over the same triangles and winding, with a restart index between
+// rows.  16-bit modes fall back to Triangles32 when a single pair of rows does not fit.
+IndexData getGridIndices(size_t rows, size_t cols, IndexMode mode);
+
+} // namespace msb
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace msb
+{
+
+// FNV-1a, for cache keys built from file contents and parameters
+constexpr uint64_t fnv_offset = 14695981039346656037ull;
+constexpr uint64_t fnv_prime = 1099511628211ull;
+
+inline uint64_t fnv1a(const void* data, size_t size, uint64_t hash = fnv_offset)
+{
+    auto bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash = (hash ^ bytes[i]) * fnv_prime;
+    }
+    return hash;
+}
+
+} // namespace msb
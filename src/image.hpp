@@ -1,37 +1,155 @@
 #pragma once
 
+#include "mapped_file.hpp"
+
 #include <stb_image.h>
 
-#include <memory>
+#include <cstddef>
 #include <string>
+#include <utility>
+
+enum class PixelType
+{
+    UInt8,
+    UInt16,
+    Float
+};
 
+struct ImageOptions
+{
+    bool flip = true;
+    int channels = 0; // 0 keeps the channel count of the file
+    PixelType type = PixelType::UInt8;
+    bool mapped = false; // decode from a memory map of the file instead of stdio
+};
 
+// Decoded pixels owned by stb_image.  Every option is passed per call, so images can be loaded
+// from any number of threads at once; the flip flag is stb's thread-local one and is set before
+// each decode.  data is nullptr when the file cannot be read, and nrChannels is the channel count
+// of data (the requested count when one was given).
 class Image
 {
 
   public:
-    int width;
-    int height;
-    int nrChannels;
-    unsigned char* data;
+    int width = 0;
+    int height = 0;
+    int nrChannels = 0;
+    PixelType type = PixelType::UInt8;
+    unsigned char* data = nullptr;
 
-    Image(std::string filename)
-    {
-        stbi_set_flip_vertically_on_load(true);
-        data = stbi_load(filename.c_str(), &width, &height, &nrChannels, 0);
-    }
+    Image(const std::string& filename) : Image(filename, ImageOptions{}) {}
 
-    Image(std::string filename, bool flip)
+    Image(const std::string& filename, bool flip) : Image(filename, ImageOptions{flip}) {}
+
+    Image(const std::string& filename, const ImageOptions& options) : type(options.type)
     {
-        stbi_set_flip_vertically_on_load(flip);
-        data = stbi_load(filename.c_str(), &width, &height, &nrChannels, 0);
+        stbi_set_flip_vertically_on_load_thread(options.flip);
+
+        int file_channels = 0;
+        if (options.mapped)
+        {
+            msb::MappedFile file(filename);
+            if (file.data() != nullptr)
+            {
+                data = decode(file.data(), file.size(), file_channels, options);
+            }
+        }
+        else
+        {
+            data = decode(filename, file_channels, options);
+        }
+
+        if (data)
+        {
+            nrChannels = options.channels != 0 ? options.channels : file_channels;
+        }
     }
 
     Image() = delete;
     Image(const Image&) = delete;
     Image& operator=(const Image&) = delete;
-    Image(Image&&) = default;
-    Image& operator=(Image&&) = default;
 
-    ~Image() { stbi_image_free(data); }
-};
\ No newline at end of file
+    Image(Image&& other) noexcept { swap(other); }
+
+    Image& operator=(Image&& other) noexcept
+    {
+        Image tmp(std::move(other));
+        swap(tmp);
+        return *this;
+    }
+
+    ~Image()
+    {
+        if (data)
+        {
+            stbi_image_free(data);
+        }
+    }
+
+    size_t bytesPerChannel() const
+    {
+        switch (type)
+        {
+        case PixelType::UInt16:
+            return 2;
+        case PixelType::Float:
+            return 4;
+        default:
+            return 1;
+        }
+    }
+
+    size_t sizeBytes() const
+    {
+        return data ? size_t(width) * height * nrChannels * bytesPerChannel() : 0;
+    }
+
+    const unsigned short* data16() const { return reinterpret_cast<unsigned short*>(data); }
+    const float* dataf() const { return reinterpret_cast<float*>(data); }
+
+  private:
+    void swap(Image& other) noexcept
+    {
+        std::swap(width, other.width);
+        std::swap(height, other.height);
+        std::swap(nrChannels, other.nrChannels);
+        std::swap(type, other.type);
+        std::swap(data, other.data);
+    }
+
+    unsigned char* decode(const std::string& filename, int& file_channels,
+                          const ImageOptions& options)
+    {
+        auto name = filename.c_str();
+        switch (options.type)
+        {
+        case PixelType::UInt16:
+            return reinterpret_cast<unsigned char*>(
+                stbi_load_16(name, &width, &height, &file_channels, options.channels));
+        case PixelType::Float:
+            return reinterpret_cast<unsigned char*>(
+                stbi_loadf(name, &width, &height, &file_channels, options.channels));
+        default:
+            return stbi_load(name, &width, &height, &file_channels, options.channels);
+        }
+    }
+
+    unsigned char* decode(const unsigned char* bytes, size_t size, int& file_channels,
+                          const ImageOptions& options)
+    {
+        auto len = static_cast<int>(size);
+        switch (options.type)
+        {
+        case PixelType::UInt16:
+            return reinterpret_cast<unsigned char*>(stbi_load_16_from_memory(
+                bytes, len, &width, &height, &file_channels, options.channels));
+        case PixelType::Float:
+            return reinterpret_cast<unsigned char*>(
+                stbi_loadf_from_memory(bytes, len, &width, &height, &file_channels,
+                                       options.channels));
+        default:
+            return stbi_load_from_memory(bytes, len, &width, &height, &file_channels,
+                                         options.channels);
+        }
+    }
+};
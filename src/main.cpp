@@ -1,152 +1,254 @@
 #include "camera.hpp"
-#include "geometry.hpp"
-#include "gl_helpers.hpp"
-#include "model.hpp"
-#include "shader.hpp"
-#include "terrain.hpp"
-#include "wave.hpp"
+#include "offscreen.hpp"
+#include "profiler.hpp"
+#include "scene.hpp"
+#include "sim_clock.hpp"
+#include "texture_loader.hpp"
 #include "window_management.hpp"
 
 #include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
 
-int main()
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+
+constexpr const char* usage =
+    "usage: beach [--headless] [--frames N] [--size WxH] [--step seconds] [--out directory]\n"
+    "             [--raw] [--trace file.json] [--spectral]";
+
+// Headless runs render N frames at a fixed time step into an offscreen framebuffer and write
+// them to the output directory, as PPM files or one raw RGB stream with --raw.  --trace saves
+// the CPU zones and GPU passes of the run in Chrome trace format on exit.  --spectral replaces
+// the Gerstner waves with an FFT ocean spectrum.
+struct Options
+{
+    bool headless = false;
+    int frames = 300;
+    int width = 800;
+    int height = 600;
+    double step = 1. / 60.;
+    std::string out = "frames";
+    bool raw = false;
+    std::string trace;
+    bool spectral = false;
+};
+
+// Whole text as a number above zero; false for anything else, including values out of range
+bool parsePositive(const std::string& text, int& value)
+{
+    try
+    {
+        size_t used = 0;
+        value = std::stoi(text, &used);
+        return used == text.size() && value > 0;
+    }
+    catch (const std::logic_error&)
+    {
+        return false;
+    }
+}
+
+bool parsePositive(const std::string& text, double& value)
+{
+    try
+    {
+        size_t used = 0;
+        value = std::stod(text, &used);
+        return used == text.size() && std::isfinite(value) && value > 0.;
+    }
+    catch (const std::logic_error&)
+    {
+        return false;
+    }
+}
+
+// false after reporting a malformed or non-positive --frames, --size or --step
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        auto has_value = i + 1 < argc;
+
+        if (arg == "--headless")
+        {
+            options.headless = true;
+        }
+        else if (arg == "--raw")
+        {
+            options.raw = true;
+        }
+        else if (arg == "--spectral")
+        {
+            options.spectral = true;
+        }
+        else if (arg == "--frames" && has_value)
+        {
+            if (!parsePositive(argv[++i], options.frames))
+            {
+                std::cout << "--frames needs a positive frame count, got " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--size" && has_value)
+        {
+            std::string size = argv[++i];
+            auto x = size.find('x');
+            auto valid = parsePositive(size.substr(0, x), options.width);
+            options.height = options.width;
+            if (x != std::string::npos)
+            {
+                valid = valid && parsePositive(size.substr(x + 1), options.height);
+            }
+            if (!valid)
+            {
+                std::cout << "--size needs a positive W or WxH, got " << size << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--step" && has_value)
+        {
+            if (!parsePositive(argv[++i], options.step))
+            {
+                std::cout << "--step needs a positive number of seconds, got " << argv[i]
+                          << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--out" && has_value)
+        {
+            options.out = argv[++i];
+        }
+        else if (arg == "--trace" && has_value)
+        {
+            options.trace = argv[++i];
+        }
+        else
+        {
+            std::cout << "Ignoring unknown argument " << arg << std::endl;
+        }
+    }
+    return true;
+}
+
+// Load the scene and render until the window closes or every headless frame is written.  GL
+// objects are released on return, while the context still exists.
+int run(const Options& options, GLFWwindow* window)
 {
-    auto window = msb::initializeWindow();
-    auto [vertices, faces] = msb::getPlane(65, 50, .1, 10);
-
-    std::vector<msb::Texture> ocean_tex = {
-        msb::initTexture("resources/bathy2.png", "texture_diffuse", GL_CLAMP_TO_EDGE, GL_LINEAR,
-                         GL_RGB),
-        msb::initTexture("resources/foam2.png", "texture_diffuse", GL_MIRRORED_REPEAT, GL_LINEAR,
-                         GL_RGBA)};
-
-    auto mesh = msb::Mesh(vertices, faces, ocean_tex);
-    msb::Model model(std::move(mesh));
-    Shader shader("shaders/ocean.vert", "shaders/ocean_pbr2.frag");
-    shader.setFloat("avg_water_ht", 0.f);
-    shader.setInt("env_map", 0);
-    shader.setInt("brdf_map", 2);
-
-    // auto [v_beach, f_beach] = getQuad(50, 50, 10);
-    auto [v_beach, f_beach] =
-        msb::getTerrain("resources/bathy2.png", "resources/bathy_norms2.png", 50, 50);
-
-    std::vector<msb::Texture> beach_tex = {
-        msb::initTexture("resources/Sand 002/Sand 002_COLOR.jpg", "texture_diffuse",
-                         GL_MIRRORED_REPEAT, GL_LINEAR, GL_SRGB),
-        msb::initTexture("resources/Sand 002/Sand 002_NRM.jpg", "texture_diffuse",
-                         GL_MIRRORED_REPEAT, GL_LINEAR, GL_RGB),
-        msb::initTexture("resources/Sand 002/Sand 002_OCC.jpg", "texture_diffuse",
-                         GL_MIRRORED_REPEAT, GL_LINEAR, GL_RGB),
-        msb::initTexture("resources/Sand 002/Sand 002_DISP.jpg", "texture_diffuse",
-                         GL_MIRRORED_REPEAT, GL_LINEAR, GL_RGB)};
-
-    auto mesh_beach = msb::Mesh(v_beach, {3, 3, 2, 3}, f_beach, beach_tex);
-    msb::Model model_beach(std::move(mesh_beach));
-    Shader shader_beach("shaders/tbn_tex.vert", "shaders/tbn_tex.frag");
-    shader_beach.setInt("env_map", 4);
-    shader_beach.setInt("brdf_map", 5);
-
-    // auto [v_cube, f_cube] = makeSkybox();
-    // auto skybox_vao = fillBuffers(v_cube);
-    // auto cubemap_tex = loadCubemap({ "skybox2/right.jpg","skybox2/left.jpg","skybox2/top.jpg",
-    //								 "skybox2/bottom.jpg","skybox2/front.jpg","skybox2/back.jpg"
-    //});
-    auto hdr_cube = msb::setHdrTexture("resources/Malibu/Malibu_Overlook_env.hdr");
-    auto [cube_tex, cube_vao] = msb::renderCubeMap(hdr_cube);
-    Shader shader_cubemap("shaders/cube.vert", "shaders/cube.frag");
-    shader_cubemap.setInt("skybox", 0);
-
-    auto brdf_map_id = msb::renderBrdfQuad();
-
-    float geom_chop = 0.5;
-    auto waves = msb::makeGeomWaves();
-    msb::initWaves(shader, waves, "geom_waves", geom_chop);
-
-    float tex_chop = 0.0;
-    auto tx_waves = msb::makeTexWaves(32);
-    msb::initWaves(shader, tx_waves, "tex_waves", tex_chop);
-
-    // Directional
-    // auto dir_light_vec = glm::vec3(-0.2f, -1.0f, -0.3f);
-    auto dir_light_vec = glm::vec3(1.f, -.25f, 0.f);
-    shader.setVec3("dir_light.direction", dir_light_vec);
-    shader.setVec3("dir_light.ambient", 0.4f, 0.4f, 0.4f);
-    shader.setVec3("dir_light.diffuse", .3f, .3f, .3f);
-    shader.setVec3("dir_light.specular", .8f, .8f, .8f);
-
-    shader_beach.setVec3("light_dir", dir_light_vec);
+    // Float keeps full precision vertex buffers; Compact quantizes them to 16-20 bytes per vertex
+    constexpr auto vertex_packing = msb::VertexPacking::Compact;
+
+    // textures decode in the background and are swapped in by poll() in the render loop
+    msb::TextureLoader textures;
+
+    auto clock = options.headless ? msb::SimClock::fixedStep(options.step)
+                                  : msb::SimClock::realTime();
+    auto ocean_mode = options.spectral ? msb::OceanMode::Spectral : msb::OceanMode::Gerstner;
+    msb::Scene scene(textures, vertex_packing, clock.now(), ocean_mode);
 
     CameraState state(window);
     glfwSetWindowUserPointer(window, &state);
 
     state.setCameraPosition(glm::vec3(0.0, 3.0, 3.0));
 
-    // glEnable(GL_FRAMEBUFFER_SRGB);
-    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glEnable(GL_DEPTH_TEST);
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    // frame percentiles and per-pass times go to the window title, and to stdout on exit
+    msb::Profiler profiler;
+    auto finishProfile = [&] {
+        std::cout << profiler.summary() << std::endl;
+        if (!options.trace.empty() && !profiler.writeChromeTrace(options.trace))
+        {
+            std::cout << "Failed to write " << options.trace << std::endl;
+        }
+    };
+
+    if (options.headless)
+    {
+        // every frame sees the final textures, so runs are repeatable
+        textures.finish();
+        state.aspect = float(options.width) / float(options.height);
+
+        msb::OffscreenTarget target(options.width, options.height);
+        auto format = options.raw ? msb::FrameWriter::Format::Raw : msb::FrameWriter::Format::Ppm;
+        msb::FrameWriter writer(options.out, format, options.width, options.height);
+
+        target.bind();
+        std::vector<unsigned char> pixels;
+        for (int frame = 0; target.complete() && frame < options.frames; ++frame)
+        {
+            profiler.beginFrame();
+            clock.tick();
+            scene.draw(clock, state, profiler);
+            if (target.readback(pixels))
+            {
+                msb::CpuZone zone(profiler, "write frame");
+                writer.write(pixels);
+            }
+            profiler.endFrame();
+        }
+        if (target.flush(pixels))
+        {
+            writer.write(pixels);
+        }
+        finishProfile();
+
+        auto written = writer.frames();
+        std::cout << "Wrote " << written << " frames to " << options.out << std::endl;
+        return written == size_t(options.frames) ? 0 : 1;
+    }
 
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
     glViewport(0, 0, 800, 600);
 
-    float delta_time = 0.0f;
-    float last_frame = 0.0f;
-
+    auto title_time = clock.now();
     while (!glfwWindowShouldClose(window))
     {
-        auto current_frame = static_cast<float>(glfwGetTime());
-        delta_time = current_frame - last_frame;
-        last_frame = current_frame;
-        state.setCameraSpeed(5.f * delta_time);
+        profiler.beginFrame();
+        auto t = clock.tick();
+        textures.poll();
+        state.setCameraSpeed(5.f * static_cast<float>(clock.delta()));
         msb::processInput(state);
 
-        glClearColor(0.0, 0.0, 0.0, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        auto model_mat = glm::mat4(1.0f);
-
-        // Beach
-        glActiveTexture(GL_TEXTURE4);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, cube_tex);
-        glActiveTexture(GL_TEXTURE5);
-        glBindTexture(GL_TEXTURE_2D, brdf_map_id);
-        shader_beach.setMat4("model", model_mat);
-        shader_beach.setMat4("view", state.viewMatrix());
-        shader_beach.setMat4("projection", state.projectionMatrix());
-        shader_beach.setVec3("cam_pos", state.cameraPosition());
-        model_beach.Draw(shader_beach);
-
-        // Waves
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, brdf_map_id);
-        shader.setVec3("dir_light.direction", dir_light_vec);
-        shader.setMat4("model", model_mat);
-        shader.setMat4("view", state.viewMatrix());
-        shader.setMat4("projection", state.projectionMatrix());
-        shader.setVec3("cam_pos", state.cameraPosition());
-        updateWaves(shader, waves, "geom_waves", geom_chop);
-        updateWaves(shader, tx_waves, "tex_waves", tex_chop);
-        model.Draw(shader);
-
-        // Cube map
-        // glDepthFunc(GL_LEQUAL);
-        // shader_cubemap.setMat4("view", glm::mat4(glm::mat3(state.viewMatrix())));
-        // shader_cubemap.setMat4("projection", state.projectionMatrix());
-        // glBindVertexArray(cube_vao);
-        // glActiveTexture(GL_TEXTURE0);
-        // glBindTexture(GL_TEXTURE_CUBE_MAP, cube_tex);
-        // glDrawArrays(GL_TRIANGLES, 0, 36);
-        // glBindVertexArray(0);
-        // glDepthFunc(GL_LESS);
+        scene.draw(clock, state, profiler);
 
         glfwSwapBuffers(window);
         glfwPollEvents();
+        profiler.endFrame();
+
+        if (t - title_time > 1.)
+        {
+            title_time = t;
+            glfwSetWindowTitle(window, ("beach | " + profiler.summary()).c_str());
+        }
+    }
+
+    finishProfile();
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cout << usage << std::endl;
+        return -1;
     }
 
+    auto window = options.headless ? msb::initializeHeadless(options.width, options.height)
+                                   : msb::initializeWindow();
+    if (window == NULL)
+    {
+        return -1;
+    }
+
+    auto status = run(options, window);
     glfwTerminate();
 
-    return 0;
-}
\ No newline at end of file
+    return status;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace msb
+{
+
+// Read-only memory map of a whole file.  data() is nullptr when the file cannot be opened or is
+// empty.
+class MappedFile
+{
+  public:
+    MappedFile(const std::string& path)
+    {
+#ifdef _WIN32
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE)
+        {
+            return;
+        }
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file_, &size) || size.QuadPart == 0)
+        {
+            return;
+        }
+
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_ == nullptr)
+        {
+            return;
+        }
+
+        data_ = static_cast<const unsigned char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        size_ = data_ ? static_cast<size_t>(size.QuadPart) : 0;
+#else
+        auto fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return;
+        }
+
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0)
+        {
+            auto addr = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED)
+            {
+                data_ = static_cast<const unsigned char*>(addr);
+                size_ = size_t(info.st_size);
+            }
+        }
+
+        // the mapping keeps the file alive
+        close(fd);
+#endif
+    }
+
+    MappedFile() = delete;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept { swap(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept
+    {
+        swap(other);
+        return *this;
+    }
+
+    ~MappedFile()
+    {
+#ifdef _WIN32
+        if (data_)
+        {
+            UnmapViewOfFile(data_);
+        }
+        if (mapping_)
+        {
+            CloseHandle(mapping_);
+        }
+        if (file_ != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(file_);
+        }
+#else
+        if (data_)
+        {
+            munmap(const_cast<unsigned char*>(data_), size_);
+        }
+#endif
+    }
+
+    const unsigned char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+  private:
+    const unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#endif
+
+    void swap(MappedFile& other) noexcept
+    {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+#ifdef _WIN32
+        std::swap(file_, other.file_);
+        std::swap(mapping_, other.mapping_);
+#endif
+    }
+};
+
+} // namespace msb
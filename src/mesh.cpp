@@ -2,15 +2,33 @@
 
 #include "image.hpp"
 
+#include <algorithm>
 #include <numeric>
 
 namespace msb
 {
 
 Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices,
-           std::vector<Texture> textures)
-    : indices_(indices), textures_(textures)
+           std::vector<Texture> textures, VertexPacking packing)
+    : Mesh(std::move(vertices), IndexData{GL_TRIANGLES, std::move(indices), {}, {}},
+           std::move(textures), packing)
 {
+}
+
+Mesh::Mesh(std::vector<float> vertices, std::vector<unsigned int> layout,
+           std::vector<unsigned int> indices, std::vector<Texture> textures,
+           VertexPacking packing)
+    : Mesh(std::move(vertices), std::move(layout),
+           IndexData{GL_TRIANGLES, std::move(indices), {}, {}}, std::move(textures), packing)
+{
+}
+
+Mesh::Mesh(std::vector<Vertex> vertices, IndexData indices, std::vector<Texture> textures,
+           VertexPacking packing)
+    : textures_(std::move(textures)), packing_(packing)
+{
+    setIndices(std::move(indices));
+
     // layout for Vertex struct with position, normal, tex_coords
     layout_ = {3, 3, 2};
     vertices_.reserve(8 * vertices.size());
@@ -30,58 +48,139 @@ Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices,
     setupMesh();
 }
 
-Mesh::Mesh(std::vector<float> vertices, std::vector<unsigned int> layout,
-           std::vector<unsigned int> indices, std::vector<Texture> textures)
-    : vertices_(vertices), layout_(layout), indices_(indices), textures_(textures)
+Mesh::Mesh(std::vector<float> vertices, std::vector<unsigned int> layout, IndexData indices,
+           std::vector<Texture> textures, VertexPacking packing)
+    : vertices_(std::move(vertices)), layout_(std::move(layout)), textures_(std::move(textures)),
+      packing_(packing)
 {
+    setIndices(std::move(indices));
     setupMesh();
 }
 
-void Mesh::setupMesh()
+Mesh::Mesh(const PackedVertexView& vertices, std::vector<unsigned int> layout,
+           const IndexView& indices, std::vector<Texture> textures, VertexPacking packing)
+    : layout_(std::move(layout)), chunks_(indices.chunks), textures_(std::move(textures)),
+      primitive_(indices.primitive), index_type_(indices.type), index_count_(indices.count),
+      packing_(packing)
 {
-    glGenBuffers(1, &vbo_);
-    glGenBuffers(1, &ebo_);
+    auto index_size = index_type_ == GL_UNSIGNED_SHORT ? sizeof(unsigned short)
+                                                       : sizeof(unsigned int);
+    setupMesh(vertices, indices.data, index_count_ * index_size);
+}
 
-    glGenVertexArrays(1, &vao_);
-    glBindVertexArray(vao_);
+void Mesh::setIndices(IndexData&& indices)
+{
+    primitive_ = indices.primitive;
+    chunks_ = std::move(indices.chunks);
 
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    glBufferData(GL_ARRAY_BUFFER, vertices_.size() * sizeof(float), vertices_.data(),
-                 GL_STATIC_DRAW);
+    if (!indices.indices16.empty())
+    {
+        index_type_ = GL_UNSIGNED_SHORT;
+        indices16_ = std::move(indices.indices16);
+        index_count_ = indices16_.size();
+    }
+    else
+    {
+        index_type_ = GL_UNSIGNED_INT;
+        indices_ = std::move(indices.indices32);
+        index_count_ = indices_.size();
+    }
+}
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices_.size() * sizeof(unsigned int), indices_.data(),
-                 GL_STATIC_DRAW);
+Mesh::Buffers::~Buffers()
+{
+    if (vao != 0)
+    {
+        glDeleteVertexArrays(1, &vao);
+        glDeleteBuffers(1, &vbo);
+        glDeleteBuffers(1, &ebo);
+    }
+}
 
-    std::vector<unsigned int> offset(layout_.size());
-    std::partial_sum(layout_.begin(), layout_.end(), offset.begin());
-    auto stride = offset.back();
+void Mesh::releaseCpuData()
+{
+    // swap with empties so the capacity is returned too
+    std::vector<float>().swap(vertices_);
+    std::vector<unsigned int>().swap(indices_);
+    std::vector<unsigned short>().swap(indices16_);
+}
 
-    if (offset.size() > 1)
+void Mesh::setupMesh()
+{
+    if (index_type_ == GL_UNSIGNED_SHORT)
     {
-        std::rotate(offset.rbegin(), offset.rbegin() + 1, offset.rend());
+        setupMesh(vertices_.data(), vertices_.size(), indices16_.data(),
+                  indices16_.size() * sizeof(unsigned short));
     }
-    offset[0] = 0;
+    else
+    {
+        setupMesh(vertices_.data(), vertices_.size(), indices_.data(),
+                  indices_.size() * sizeof(unsigned int));
+    }
+}
 
-    for (size_t i = 0; i < layout_.size(); ++i)
+void Mesh::setupMesh(const float* vertices, size_t num_floats, const void* indices,
+                     size_t index_bytes)
+{
+    if (packing_ == VertexPacking::Compact)
     {
-        glVertexAttribPointer(i, layout_[i], GL_FLOAT, GL_FALSE, stride * sizeof(float),
-                              reinterpret_cast<void*>(offset[i] * sizeof(float)));
+        auto packed = packVertices(vertices, num_floats, layout_, compactFormat(layout_));
+        setupMesh(packed.view(), indices, index_bytes);
+    }
+    else
+    {
+        setupMesh(PackedVertexView{vertices, num_floats * sizeof(float)}, indices, index_bytes);
+    }
+}
+
+void Mesh::setupMesh(const PackedVertexView& vertices, const void* indices, size_t index_bytes)
+{
+    position_scale_ = vertices.position_scale;
+    position_offset_ = vertices.position_offset;
+    uv_scale_ = vertices.uv_scale;
+    uv_offset_ = vertices.uv_offset;
+
+    glGenBuffers(1, &buffers_.vbo);
+    glGenBuffers(1, &buffers_.ebo);
+
+    glGenVertexArrays(1, &buffers_.vao);
+    glBindVertexArray(buffers_.vao);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers_.ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_bytes, indices, GL_STATIC_DRAW);
+
+    auto format = packingFormat(layout_, packing_);
+    auto offsets = attributeOffsets(format);
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffers_.vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.bytes, vertices.data, GL_STATIC_DRAW);
+
+    for (size_t i = 0; i < format.size(); ++i)
+    {
+        glVertexAttribPointer(i, format[i].size, format[i].type, format[i].normalized,
+                              GLsizei(offsets.back()), reinterpret_cast<void*>(offsets[i]));
         glEnableVertexAttribArray(i);
     }
 
     glBindVertexArray(0);
 }
 
-void Mesh::Draw(const Shader& shader) const
+void Mesh::resolveUniforms(const Shader& shader) const
 {
+    auto& u = draw_uniforms_;
+    u.program = shader.id;
+    u.pos_scale = shader.uniform<glm::vec3>("pos_scale");
+    u.pos_offset = shader.uniform<glm::vec3>("pos_offset");
+    u.uv_scale = shader.uniform<glm::vec2>("uv_scale");
+    u.uv_offset = shader.uniform<glm::vec2>("uv_offset");
+
+    u.samplers.clear();
     unsigned int num_diffuse_maps = 1;
     unsigned int num_specular_maps = 1;
-    for (size_t i = 0; i < textures_.size(); ++i)
+    for (auto& texture : textures_)
     {
-        glActiveTexture(GL_TEXTURE0 + GLenum(i));
         std::string index;
-        std::string name = textures_[i].type;
+        auto& name = texture.type;
         if (name == "texture_diffuse")
         {
             index = std::to_string(num_diffuse_maps++);
@@ -90,13 +189,60 @@ void Mesh::Draw(const Shader& shader) const
         {
             index = std::to_string(num_specular_maps++);
         }
-        shader.setInt(("material." + name + index), i);
+        u.samplers.push_back(shader.uniform<int>("material." + name + index));
+    }
+}
+
+void Mesh::Draw(const Shader& shader) const
+{
+    auto& u = draw_uniforms_;
+    if (u.program != shader.id)
+    {
+        resolveUniforms(shader);
+    }
+
+    for (size_t i = 0; i < textures_.size(); ++i)
+    {
+        glActiveTexture(GL_TEXTURE0 + GLenum(i));
+        shader.set(u.samplers[i], int(i));
         glBindTexture(GL_TEXTURE_2D, textures_[i].id);
     }
     glActiveTexture(GL_TEXTURE0);
 
-    glBindVertexArray(vao_);
-    glDrawElements(GL_TRIANGLES, GLsizei(indices_.size()), GL_UNSIGNED_INT, 0);
+    shader.set(u.pos_scale, position_scale_);
+    shader.set(u.pos_offset, position_offset_);
+    shader.set(u.uv_scale, uv_scale_);
+    shader.set(u.uv_offset, uv_offset_);
+
+    glBindVertexArray(buffers_.vao);
+
+    if (primitive_ == GL_TRIANGLE_STRIP)
+    {
+        glEnable(GL_PRIMITIVE_RESTART);
+        glPrimitiveRestartIndex(index_type_ == GL_UNSIGNED_SHORT ? restart_index16 : 0xFFFFFFFF);
+    }
+
+    if (chunks_.empty())
+    {
+        glDrawElements(primitive_, GLsizei(index_count_), index_type_, 0);
+    }
+    else
+    {
+        auto index_size = index_type_ == GL_UNSIGNED_SHORT ? sizeof(unsigned short)
+                                                           : sizeof(unsigned int);
+        for (auto& chunk : chunks_)
+        {
+            glDrawElementsBaseVertex(primitive_, GLsizei(chunk.count), index_type_,
+                                     reinterpret_cast<void*>(chunk.first * index_size),
+                                     chunk.base_vertex);
+        }
+    }
+
+    if (primitive_ == GL_TRIANGLE_STRIP)
+    {
+        glDisable(GL_PRIMITIVE_RESTART);
+    }
+
     glBindVertexArray(0);
 }
 
@@ -141,12 +287,12 @@ Texture initTexture(std::string filename, std::string tex_type, unsigned int edg
 
 std::ostream& operator<<(std::ostream& os, const Mesh& mesh)
 {
-    auto verts = mesh.vertices();
-    auto layout = mesh.layout();
-    auto stride = std::accumulate(layout.begin(), layout.end(), 0);
+    const auto& verts = mesh.vertices();
+    const auto& layout = mesh.layout();
+    auto stride = std::accumulate(layout.begin(), layout.end(), 0u);
 
     os << "Verts: \n";
-    for (auto i = 0; i < verts.size(); i += stride)
+    for (size_t i = 0; i < verts.size(); i += stride)
     {
         if (i > 5 * stride)
         {
@@ -154,29 +300,36 @@ std::ostream& operator<<(std::ostream& os, const Mesh& mesh)
             break;
         }
 
-        for (auto num_elements : mesh.layout())
+        auto element = i;
+        for (auto num_elements : layout)
         {
             os << "( ";
-            for (auto element = 0; element < num_elements; ++element)
+            for (size_t k = 0; k < num_elements; ++k)
             {
-                os << verts[i + element] << " ";
+                os << verts[element++] << " ";
             }
             os << ")  ";
         }
         os << "\n";
     }
 
+    const auto& indices = mesh.indices();
+    const auto& indices16 = mesh.indices16();
+    auto index = [&](size_t i) -> unsigned int {
+        return indices16.empty() ? indices[i] : indices16[i];
+    };
+    auto num_indices = indices16.empty() ? indices.size() : indices16.size();
+
     stride = 3;
     os << "\nFaces: ";
-    for (size_t i = 0; i < mesh.indices().size(); i += stride)
+    for (size_t i = 0; i + 2 < num_indices; i += stride)
     {
         if (i > 5 * stride)
         {
             os << "\n...\n";
             break;
         }
-        os << "\n"
-           << mesh.indices()[i] << " " << mesh.indices()[i + 1] << " " << mesh.indices()[i + 2];
+        os << "\n" << index(i) << " " << index(i + 1) << " " << index(i + 2);
     }
 
     os << "\n";
@@ -1,10 +1,12 @@
 #pragma once
 
 #include "shader.hpp"
+#include "vertex_format.hpp"
 
 #include <glm/glm.hpp>
 
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace msb
@@ -26,13 +28,75 @@ struct Texture
     Texture(unsigned int id, std::string type, std::string path) : id(id), type(type), path(path) {}
 };
 
+// Index buffer flavours for grid meshes.  The 16-bit modes split the grid into row bands of at
+// most 64K vertices, each drawn with its own base vertex.
+enum class IndexMode
+{
+    Triangles32,
+    Triangles16,
+    Strips16 // one triangle strip per grid row, separated by primitive restart
+};
+
+constexpr unsigned short restart_index16 = 0xFFFF;
+
+// Range of the index buffer drawn with its own base vertex
+struct IndexChunk
+{
+    size_t first; // in indices
+    size_t count;
+    int base_vertex;
+};
+
+// Non-owning index data, e.g. pages of a mapped file
+struct IndexView
+{
+    unsigned int primitive;
+    unsigned int type; // GL_UNSIGNED_INT or GL_UNSIGNED_SHORT
+    const void* data;
+    size_t count;
+    std::vector<IndexChunk> chunks;
+};
+
+struct IndexData
+{
+    unsigned int primitive = GL_TRIANGLES;
+    std::vector<unsigned int> indices32;
+    std::vector<unsigned short> indices16; // used instead of indices32 when non-empty
+    std::vector<IndexChunk> chunks;        // empty for a single draw over the whole buffer
+
+    // Borrowing view of whichever index array is in use
+    IndexView view() const
+    {
+        if (!indices16.empty())
+        {
+            return {primitive, GL_UNSIGNED_SHORT, indices16.data(), indices16.size(), chunks};
+        }
+        return {primitive, GL_UNSIGNED_INT, indices32.data(), indices32.size(), chunks};
+    }
+};
+
+// Sink constructors: pass geometry with std::move to hand it to the GPU upload without a copy.
+// The CPU copy stays available through the accessors until releaseCpuData().  Compact packing
+// quantizes the GPU copy only; Draw sets the pos_scale/pos_offset/uv_scale/uv_offset uniforms
+// that shaders use to undo it.
 class Mesh
 {
   public:
     Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices,
-         std::vector<Texture> textures);
+         std::vector<Texture> textures, VertexPacking packing = VertexPacking::Float);
     Mesh(std::vector<float> vertices, std::vector<unsigned int> layout,
-         std::vector<unsigned int> indices, std::vector<Texture> textures);
+         std::vector<unsigned int> indices, std::vector<Texture> textures,
+         VertexPacking packing = VertexPacking::Float);
+    Mesh(std::vector<Vertex> vertices, IndexData indices, std::vector<Texture> textures,
+         VertexPacking packing = VertexPacking::Float);
+    Mesh(std::vector<float> vertices, std::vector<unsigned int> layout, IndexData indices,
+         std::vector<Texture> textures, VertexPacking packing = VertexPacking::Float);
+
+    // Upload vertices already packed for packing straight from borrowed memory, without
+    // keeping a CPU copy
+    Mesh(const PackedVertexView& vertices, std::vector<unsigned int> layout,
+         const IndexView& indices, std::vector<Texture> textures,
+         VertexPacking packing = VertexPacking::Float);
 
     Mesh() = delete;
     Mesh(const Mesh&) = delete;
@@ -43,19 +107,77 @@ class Mesh
 
     void Draw(const Shader& shader) const;
 
-    std::vector<float> vertices() const { return vertices_; }
-    std::vector<unsigned int> indices() const { return indices_; }
-    std::vector<unsigned int> layout() const { return layout_; }
+    // Free the CPU-side vertex and index data once it lives in GPU buffers
+    void releaseCpuData();
+
+    const std::vector<float>& vertices() const { return vertices_; }
+    const std::vector<unsigned int>& indices() const { return indices_; }
+    const std::vector<unsigned short>& indices16() const { return indices16_; }
+    const std::vector<unsigned int>& layout() const { return layout_; }
+    unsigned int primitive() const { return primitive_; }
+    unsigned int indexType() const { return index_type_; }
+    size_t indexCount() const { return index_count_; }
 
   private:
-    unsigned int vao_, vbo_, ebo_;
+    // GL objects owned by the mesh; a moved-from set holds zeros, so only one owner deletes them
+    struct Buffers
+    {
+        unsigned int vao = 0;
+        unsigned int vbo = 0;
+        unsigned int ebo = 0;
+
+        Buffers() = default;
+        Buffers(Buffers&& other) noexcept { swap(other); }
+        Buffers& operator=(Buffers&& other) noexcept
+        {
+            swap(other);
+            return *this;
+        }
+        ~Buffers();
+
+        void swap(Buffers& other) noexcept
+        {
+            std::swap(vao, other.vao);
+            std::swap(vbo, other.vbo);
+            std::swap(ebo, other.ebo);
+        }
+    };
+
+    Buffers buffers_;
 
     std::vector<float> vertices_;
     std::vector<unsigned int> layout_;
     std::vector<unsigned int> indices_;
+    std::vector<unsigned short> indices16_;
+    std::vector<IndexChunk> chunks_;
     std::vector<Texture> textures_;
 
+    unsigned int primitive_ = GL_TRIANGLES;
+    unsigned int index_type_ = GL_UNSIGNED_INT;
+    size_t index_count_ = 0;
+
+    VertexPacking packing_;
+    glm::vec3 position_scale_ = glm::vec3(1.f);
+    glm::vec3 position_offset_ = glm::vec3(0.f);
+    glm::vec2 uv_scale_ = glm::vec2(1.f);
+    glm::vec2 uv_offset_ = glm::vec2(0.f);
+
+    // Handles in the shader last drawn with, resolved again when Draw gets another shader
+    struct DrawUniforms
+    {
+        unsigned int program = 0;
+        Uniform<glm::vec3> pos_scale, pos_offset;
+        Uniform<glm::vec2> uv_scale, uv_offset;
+        std::vector<Uniform<int>> samplers; // material sampler of each texture
+    };
+    mutable DrawUniforms draw_uniforms_;
+
+    void resolveUniforms(const Shader& shader) const;
     void setupMesh();
+    void setupMesh(const float* vertices, size_t num_floats, const void* indices,
+                   size_t index_bytes);
+    void setupMesh(const PackedVertexView& vertices, const void* indices, size_t index_bytes);
+    void setIndices(IndexData&& indices);
 };
 
 Texture initTexture(std::string filename, std::string tex_type, unsigned int edge,
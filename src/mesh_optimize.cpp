@@ -0,0 +1,196 @@
+#include "mesh_optimize.hpp"
+
+namespace msb
+{
+
+double computeAcmr(const std::vector<unsigned int>& indices, size_t num_vertices,
+                   size_t cache_size)
+{
+    if (indices.size() < 3)
+    {
+        return 0.;
+    }
+
+    // a vertex is cached while fewer than cache_size vertices were pushed after it
+    std::vector<size_t> pushed_at(num_vertices, 0);
+    size_t pushes = cache_size + 1;
+    size_t misses = 0;
+
+    for (auto v : indices)
+    {
+        if (pushes - pushed_at[v] > cache_size)
+        {
+            pushed_at[v] = pushes++;
+            ++misses;
+        }
+    }
+
+    return double(misses) / double(indices.size() / 3);
+}
+
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t num_vertices,
+                         size_t cache_size)
+{
+    auto num_triangles = indices.size() / 3;
+    if (num_triangles == 0)
+    {
+        return;
+    }
+
+    // vertex -> triangle table; live counts the triangles of each vertex not yet emitted
+    std::vector<unsigned int> live(num_vertices, 0);
+    for (auto v : indices)
+    {
+        ++live[v];
+    }
+
+    std::vector<size_t> offsets(num_vertices + 1, 0);
+    for (size_t v = 0; v < num_vertices; ++v)
+    {
+        offsets[v + 1] = offsets[v] + live[v];
+    }
+
+    std::vector<unsigned int> adjacency(indices.size());
+    auto cursor = offsets;
+    for (size_t k = 0; k < indices.size(); ++k)
+    {
+        adjacency[cursor[indices[k]]++] = static_cast<unsigned int>(k / 3);
+    }
+
+    std::vector<size_t> cache_time(num_vertices, 0);
+    std::vector<char> emitted(num_triangles, 0);
+    std::vector<unsigned int> dead_end;
+    std::vector<unsigned int> candidates;
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+
+    auto time = cache_size + 1;
+    size_t scan = 0;
+
+    // next fanning vertex once the current one runs out of triangles: the dead-end stack holds
+    // recently used vertices, then fall back to scanning in input order
+    auto skipDeadEnd = [&]() -> long long {
+        while (!dead_end.empty())
+        {
+            auto v = dead_end.back();
+            dead_end.pop_back();
+            if (live[v] > 0)
+            {
+                return v;
+            }
+        }
+
+        for (; scan < num_vertices; ++scan)
+        {
+            if (live[scan] > 0)
+            {
+                return static_cast<long long>(scan);
+            }
+        }
+
+        return -1;
+    };
+
+    auto fan = skipDeadEnd();
+
+    while (fan >= 0)
+    {
+        candidates.clear();
+
+        for (auto k = offsets[fan]; k < offsets[fan + 1]; ++k)
+        {
+            auto t = adjacency[k];
+            if (emitted[t])
+            {
+                continue;
+            }
+
+            emitted[t] = 1;
+            for (size_t c = 0; c < 3; ++c)
+            {
+                auto v = indices[3 * t + c];
+                output.push_back(v);
+                dead_end.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+
+                if (time - cache_time[v] > cache_size)
+                {
+                    cache_time[v] = time++;
+                }
+            }
+        }
+
+        // prefer the candidate that stays in cache longest while its remaining triangles are
+        // emitted (each can push at most two new vertices)
+        long long best = -1;
+        long long best_priority = -1;
+        for (auto v : candidates)
+        {
+            if (live[v] == 0)
+            {
+                continue;
+            }
+
+            long long priority = 0;
+            if (time - cache_time[v] + 2 * live[v] <= cache_size)
+            {
+                priority = static_cast<long long>(time - cache_time[v]);
+            }
+
+            if (priority > best_priority)
+            {
+                best_priority = priority;
+                best = v;
+            }
+        }
+
+        fan = best >= 0 ? best : skipDeadEnd();
+    }
+
+    indices = std::move(output);
+}
+
+void optimizeVertexFetch(std::vector<float>& vertices, size_t stride,
+                         std::vector<unsigned int>& indices)
+{
+    const auto unused = ~0u;
+    auto num_vertices = vertices.size() / stride;
+
+    std::vector<unsigned int> remap(num_vertices, unused);
+    std::vector<float> reordered;
+    reordered.reserve(vertices.size());
+
+    unsigned int next = 0;
+    for (auto& v : indices)
+    {
+        if (remap[v] == unused)
+        {
+            remap[v] = next++;
+            auto src = vertices.begin() + v * stride;
+            reordered.insert(reordered.end(), src, src + stride);
+        }
+
+        v = remap[v];
+    }
+
+    vertices = std::move(reordered);
+}
+
+CacheStats optimizeMesh(std::vector<float>& vertices, size_t stride,
+                        std::vector<unsigned int>& indices, size_t cache_size)
+{
+    auto num_vertices = vertices.size() / stride;
+
+    CacheStats stats;
+    stats.acmr_before = computeAcmr(indices, num_vertices, cache_size);
+
+    optimizeVertexCache(indices, num_vertices, cache_size);
+    optimizeVertexFetch(vertices, stride, indices);
+
+    stats.acmr_after = computeAcmr(indices, vertices.size() / stride, cache_size);
+
+    return stats;
+}
+
+} // namespace msb
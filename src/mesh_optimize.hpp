@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace msb
+{
+
+// Post-transform cache efficiency of an indexed triangle list
+struct CacheStats
+{
+    double acmr_before; // average cache misses per triangle
+    double acmr_after;
+};
+
+// Average cache miss ratio of a FIFO post-transform cache of cache_size vertices.  1/2 is the
+// best case for large grids, 3 the worst.
+double computeAcmr(const std::vector<unsigned int>& indices, size_t num_vertices,
+                   size_t cache_size = 16);
+
+// Reorder triangles for vertex cache locality with Tipsify (Sander, Nehab and Barczak 2007): fan
+// around a vertex, emit all of its remaining triangles, then continue from the most recently
+// used vertex that will still be in cache.  Linear in the number of triangles.
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t num_vertices,
+                         size_t cache_size = 16);
+
+// Renumber vertices in first-use order and permute interleaved vertices (stride floats each) to
+// match, dropping vertices no triangle references
+void optimizeVertexFetch(std::vector<float>& vertices, size_t stride,
+                         std::vector<unsigned int>& indices);
+
+// Both passes, returning the ACMR before and after
+CacheStats optimizeMesh(std::vector<float>& vertices, size_t stride,
+                        std::vector<unsigned int>& indices, size_t cache_size = 16);
+
+} // namespace msb
@@ -1,6 +1,8 @@
 #include "model.hpp"
 
 #include "gl_helpers.hpp"
+#include "mesh_optimize.hpp"
+#include "tangents.hpp"
 
 #include <iostream>
 
@@ -95,7 +97,21 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
         textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
     }
 
-    return Mesh(vertices, indices, textures);
+    auto tbn_vertices = interleaveTangentSpace(vertices);
+    computeTangents(tbn_vertices.data(), vertices.size(), tbn_layout, indices);
+
+    // averaged over all triangles loaded so far
+    auto stats = optimizeMesh(tbn_vertices, tbn_layout.stride, indices);
+    auto triangles = indices.size() / 3;
+    if (triangles > 0)
+    {
+        auto weight = double(triangles) / double(num_triangles + triangles);
+        cache_stats.acmr_before += weight * (stats.acmr_before - cache_stats.acmr_before);
+        cache_stats.acmr_after += weight * (stats.acmr_after - cache_stats.acmr_after);
+        num_triangles += triangles;
+    }
+
+    return Mesh(std::move(tbn_vertices), {3, 3, 2, 3}, std::move(indices), std::move(textures));
 }
 
 std::vector<Texture> Model::loadMaterialTextures(aiMaterial* mat, aiTextureType type,
@@ -118,8 +134,11 @@ std::vector<Texture> Model::loadMaterialTextures(aiMaterial* mat, aiTextureType
         }
         if (!skip)
         {
+            auto filename = directory + str.C_Str();
             auto texture =
-                initTexture(directory + str.C_Str(), type_name, GL_REPEAT, GL_LINEAR, GL_SRGB);
+                texture_loader
+                    ? texture_loader->load(filename, type_name, GL_REPEAT, GL_LINEAR, GL_SRGB)
+                    : initTexture(filename, type_name, GL_REPEAT, GL_LINEAR, GL_SRGB);
             texture.path = str.C_Str();
             textures.push_back(texture);
             loaded_textures.push_back(texture);
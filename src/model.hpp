@@ -1,7 +1,9 @@
 #pragma once
 
 #include "mesh.hpp"
+#include "mesh_optimize.hpp"
 #include "shader.hpp"
+#include "texture_loader.hpp"
 
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
@@ -17,6 +19,9 @@ class Model
   public:
     Model(std::string path) { loadModel(path); }
 
+    // Material textures decode through loader instead of blocking the load
+    Model(std::string path, TextureLoader& loader) : texture_loader(&loader) { loadModel(path); }
+
     Model(Mesh mesh) { meshes.push_back(std::move(mesh)); }
 
     void Draw(const Shader& shader) const
@@ -27,10 +32,16 @@ class Model
         }
     }
 
+    // Vertex cache misses of every loaded mesh before and after reordering, per triangle
+    const CacheStats& cacheStats() const { return cache_stats; }
+
   private:
     std::vector<Mesh> meshes;
     std::string directory;
     std::vector<Texture> loaded_textures;
+    TextureLoader* texture_loader = nullptr;
+    CacheStats cache_stats{0., 0.};
+    size_t num_triangles = 0;
 
     void loadModel(std::string path);
     void processNode(aiNode* node, const aiScene* scene);
@@ -0,0 +1,200 @@
+#include "ocean_spectrum.hpp"
+
+#include "parallel.hpp"
+#include "wave.hpp"
+
+#include <GLAD/glad.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace msb
+{
+
+namespace
+{
+
+const double two_pi = 2. * 3.14159265358979323846;
+const float gravity = 9.8f;
+
+// wavenumber of FFT bin m, the upper half of the bins standing for negative frequencies
+float wavenumber(size_t m, size_t size, float patch)
+{
+    auto signed_m = m < size / 2 ? float(m) : float(m) - float(size);
+    return float(two_pi) * signed_m / patch;
+}
+
+float phillips(float kx, float kz, const SpectrumSettings& settings)
+{
+    auto k2 = kx * kx + kz * kz;
+    auto wind_speed = glm::length(settings.wind);
+    if (k2 == 0.f || wind_speed == 0.f)
+    {
+        return 0.f;
+    }
+
+    auto L = wind_speed * wind_speed / gravity;
+    auto along_wind = (kx * settings.wind.x + kz * settings.wind.y) / (std::sqrt(k2) * wind_speed);
+    auto l = settings.small_waves;
+
+    return settings.amplitude * std::exp(-1.f / (k2 * L * L)) / (k2 * k2) * along_wind *
+           along_wind * std::exp(-k2 * l * l);
+}
+
+// a + i b for complex a and b
+std::complex<float> pack(std::complex<float> a, std::complex<float> b)
+{
+    return {a.real() - b.imag(), a.imag() + b.real()};
+}
+
+} // namespace
+
+OceanSpectrum::OceanSpectrum(const SpectrumSettings& settings)
+    : settings_(settings), fft_(size_t(settings.size))
+{
+    auto n = size_t(settings.size);
+    h0_.resize(n * n);
+    omega_.resize(n * n);
+    spectra_.resize(3 * n * n);
+
+    // amplitudes integrate the density over the area of one bin
+    auto dk = float(two_pi) / settings.patch;
+    WaveRng rng(settings.seed);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (size_t j = 0; j < n; ++j)
+        {
+            auto kz = wavenumber(i, n, settings.patch);
+            auto kx = wavenumber(j, n, settings.patch);
+
+            // Box-Muller pair of unit normals
+            auto u1 = std::max(rng.uniform(), 1e-7f);
+            auto u2 = rng.uniform();
+            auto radius = std::sqrt(-2.f * std::log(u1));
+            auto angle = float(two_pi) * u2;
+
+            // the Nyquist bins are their own mirror, so they could not keep the slopes real
+            auto nyquist = i == n / 2 || j == n / 2;
+            auto scale = nyquist ? 0.f : std::sqrt(phillips(kx, kz, settings) * dk * dk / 2.f);
+            h0_[i * n + j] = {scale * radius * std::cos(angle), scale * radius * std::sin(angle)};
+            omega_[i * n + j] = std::sqrt(gravity * std::sqrt(kx * kx + kz * kz));
+        }
+    }
+}
+
+void OceanSpectrum::evaluate(double t) { evaluate(t, displacement_, normals_); }
+
+void OceanSpectrum::evaluate(double t, std::vector<float>& displacement,
+                             std::vector<float>& normals)
+{
+    auto n = size_t(settings_.size);
+    auto grid = n * n;
+    auto chop = settings_.choppiness;
+    displacement.resize(3 * grid);
+    normals.resize(3 * grid);
+
+    parallelFor(
+        0, n,
+        [&](size_t first, size_t last) {
+            for (auto i = first; i < last; ++i)
+            {
+                auto kz = wavenumber(i, n, settings_.patch);
+                for (size_t j = 0; j < n; ++j)
+                {
+                    auto kx = wavenumber(j, n, settings_.patch);
+                    auto index = i * n + j;
+                    auto mirror = (n - i) % n * n + (n - j) % n;
+
+                    // h0(k) e^(i w t) + conj(h0(-k)) e^(-i w t) keeps the height real
+                    auto phase = float(std::fmod(double(omega_[index]) * t, two_pi));
+                    std::complex<float> rotation(std::cos(phase), std::sin(phase));
+                    auto h = h0_[index] * rotation + std::conj(h0_[mirror] * rotation);
+
+                    auto k = std::sqrt(kx * kx + kz * kz);
+                    auto ux = k > 0.f ? kx / k : 0.f;
+                    auto uz = k > 0.f ? kz / k : 0.f;
+                    std::complex<float> i_h(-h.imag(), h.real());
+
+                    // choppy displacement -i k/|k| h, slopes i k h
+                    spectra_[index] = pack(h, -chop * ux * i_h);
+                    spectra_[grid + index] = pack(-chop * uz * i_h, kx * i_h);
+                    spectra_[2 * grid + index] = kz * i_h;
+                }
+            }
+        },
+        16);
+
+    fft_.inverse(spectra_.data(), 3);
+
+    parallelFor(
+        0, grid,
+        [&](size_t first, size_t last) {
+            for (auto index = first; index < last; ++index)
+            {
+                auto height_dx = spectra_[index];
+                auto dz_slope_x = spectra_[grid + index];
+                auto slope_z = spectra_[2 * grid + index].real();
+
+                displacement[3 * index] = height_dx.imag();
+                displacement[3 * index + 1] = height_dx.real();
+                displacement[3 * index + 2] = dz_slope_x.real();
+
+                auto normal = glm::normalize(glm::vec3(-dz_slope_x.imag(), 1.f, -slope_z));
+                normals[3 * index] = normal.x;
+                normals[3 * index + 1] = normal.y;
+                normals[3 * index + 2] = normal.z;
+            }
+        },
+        4096);
+}
+
+SpectrumTextures::SpectrumTextures(int size) : size_(size)
+{
+    for (auto texture : {&displacement_, &normals_})
+    {
+        glGenTextures(1, texture);
+        glBindTexture(GL_TEXTURE_2D, *texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, size, size, 0, GL_RGB, GL_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+SpectrumTextures::~SpectrumTextures()
+{
+    glDeleteTextures(1, &displacement_);
+    glDeleteTextures(1, &normals_);
+}
+
+void SpectrumTextures::update(unsigned int pixel_buffer, size_t displacement_offset,
+                              size_t normals_offset)
+{
+    auto upload = [this](unsigned int texture, size_t offset) {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size_, size_, GL_RGB, GL_FLOAT,
+                        reinterpret_cast<const void*>(offset));
+        glGenerateMipmap(GL_TEXTURE_2D);
+    };
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixel_buffer);
+    upload(displacement_, displacement_offset);
+    upload(normals_, normals_offset);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void SpectrumTextures::bind(unsigned int displacement_unit, unsigned int normal_unit) const
+{
+    glActiveTexture(GL_TEXTURE0 + displacement_unit);
+    glBindTexture(GL_TEXTURE_2D, displacement_);
+    glActiveTexture(GL_TEXTURE0 + normal_unit);
+    glBindTexture(GL_TEXTURE_2D, normals_);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+} // namespace msb
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "fft.hpp"
+
+#include <glm/glm.hpp>
+
+#include <complex>
+#include <cstdint>
+#include <vector>
+
+namespace msb
+{
+
+struct SpectrumSettings
+{
+    int size = 256;       // samples per side of the maps, a power of two
+    float patch = 128.f;  // meters covered by one tile; the maps repeat past it
+    glm::vec2 wind = {6.f, -3.f}; // m/s over world x and z
+    // Phillips constant.  With the spectral density normalized per unit of wavenumber area the
+    // height variance is about amplitude * pi * L^2 / 2 for L = wind speed^2 / g; the default
+    // gives a significant wave height near 1 m in the default wind.
+    float amplitude = 2e-3f;
+    float small_waves = .1f; // waves much shorter than this, in meters, are damped away
+    float choppiness = 1.f;  // scale of the horizontal displacement
+    uint64_t seed = 1;
+};
+
+// Tessendorf's FFT ocean over a square tile: a Phillips spectrum drawn once with Gaussian
+// amplitudes, advanced to any time with the deep-water dispersion relation and transformed back
+// to space by three inverse FFTs of paired real fields.  The cost per frame depends on the map
+// size only, not on how many waves the spectrum holds.
+//
+// Maps are row-major over z with x along rows, sample (i, j) at x = j * patch / size and
+// z = i * patch / size; displacement is {dx, height, dz} and normals are unit {x, y, z}.
+class OceanSpectrum
+{
+  public:
+    explicit OceanSpectrum(const SpectrumSettings& settings = {});
+
+    // Advance the spectrum to time t and refill the maps
+    void evaluate(double t);
+
+    // Same, writing the maps into the caller's buffers instead, e.g. a frame on its way to the
+    // GL thread; they are resized to fit
+    void evaluate(double t, std::vector<float>& displacement, std::vector<float>& normals);
+
+    const std::vector<float>& displacement() const { return displacement_; }
+    const std::vector<float>& normals() const { return normals_; }
+
+    const SpectrumSettings& settings() const { return settings_; }
+
+  private:
+    SpectrumSettings settings_;
+    Fft2d fft_;
+
+    std::vector<std::complex<float>> h0_;
+    std::vector<float> omega_;
+
+    // three grids: height + i dx, dz + i slope x, slope z
+    std::vector<std::complex<float>> spectra_;
+
+    // filled by evaluate(t) only
+    std::vector<float> displacement_;
+    std::vector<float> normals_;
+};
+
+// The maps of an OceanSpectrum as repeating, mipmapped float textures for the ocean shaders
+class SpectrumTextures
+{
+  public:
+    explicit SpectrumTextures(int size);
+    ~SpectrumTextures();
+
+    SpectrumTextures(const SpectrumTextures&) = delete;
+    SpectrumTextures& operator=(const SpectrumTextures&) = delete;
+
+    // Upload maps laid out as OceanSpectrum's from offsets in a pixel buffer, such as a
+    // StreamBuffer, and rebuild their mip chains
+    void update(unsigned int pixel_buffer, size_t displacement_offset, size_t normals_offset);
+
+    void bind(unsigned int displacement_unit, unsigned int normal_unit) const;
+
+  private:
+    int size_;
+    unsigned int displacement_;
+    unsigned int normals_;
+};
+
+} // namespace msb
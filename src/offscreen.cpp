@@ -0,0 +1,179 @@
+#include "offscreen.hpp"
+
+#include <glad/glad.h>
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <utility>
+
+namespace msb
+{
+
+OffscreenTarget::OffscreenTarget(int width, int height) : width_(width), height_(height)
+{
+    glGenFramebuffers(1, &fbo_);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+
+    glGenRenderbuffers(1, &color_);
+    glBindRenderbuffer(GL_RENDERBUFFER, color_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_);
+
+    glGenRenderbuffers(1, &depth_);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_);
+
+    complete_ = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (!complete_)
+    {
+        std::cout << "Offscreen framebuffer is incomplete" << std::endl;
+    }
+
+    auto bytes = size_t(width) * height * 4;
+    glGenBuffers(2, pbos_);
+    for (auto pbo : pbos_)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+OffscreenTarget::~OffscreenTarget()
+{
+    glDeleteBuffers(2, pbos_);
+    glDeleteRenderbuffers(1, &depth_);
+    glDeleteRenderbuffers(1, &color_);
+    glDeleteFramebuffers(1, &fbo_);
+}
+
+void OffscreenTarget::bind() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glViewport(0, 0, width_, height_);
+}
+
+bool OffscreenTarget::readback(std::vector<unsigned char>& pixels)
+{
+    // RGBA with 4-byte rows is the format drivers copy without conversion
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo_);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos_[next_]);
+    glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    auto previous = 1 - next_;
+    auto ready = pending_ && copyOut(previous, pixels);
+
+    next_ = previous;
+    pending_ = true;
+    return ready;
+}
+
+bool OffscreenTarget::flush(std::vector<unsigned char>& pixels)
+{
+    if (!pending_)
+    {
+        return false;
+    }
+
+    pending_ = false;
+    return copyOut(1 - next_, pixels);
+}
+
+bool OffscreenTarget::copyOut(int pbo, std::vector<unsigned char>& pixels)
+{
+    auto bytes = size_t(width_) * height_ * 4;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos_[pbo]);
+    auto src = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+    if (src)
+    {
+        pixels.resize(bytes);
+        std::memcpy(pixels.data(), src, bytes);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    return src != nullptr;
+}
+
+FrameWriter::FrameWriter(std::string directory, Format format, int width, int height)
+    : directory_(std::move(directory)), format_(format), width_(width), height_(height),
+      rgb_(size_t(width) * height * 3)
+{
+    std::error_code error;
+    std::filesystem::create_directories(directory_, error);
+
+    if (format_ == Format::Raw)
+    {
+        auto path = (std::filesystem::path(directory_) / "frames.rgb").string();
+        raw_ = std::fopen(path.c_str(), "wb");
+        if (raw_ == nullptr)
+        {
+            std::cout << "Failed to open " << path << std::endl;
+        }
+    }
+}
+
+FrameWriter::~FrameWriter()
+{
+    if (raw_)
+    {
+        std::fclose(raw_);
+    }
+}
+
+bool FrameWriter::write(const std::vector<unsigned char>& pixels)
+{
+    if (pixels.size() != size_t(width_) * height_ * 4)
+    {
+        return false;
+    }
+
+    // GL rows run bottom to top, image files top to bottom
+    for (int y = 0; y < height_; ++y)
+    {
+        auto src = pixels.data() + size_t(height_ - 1 - y) * width_ * 4;
+        auto dst = rgb_.data() + size_t(y) * width_ * 3;
+        for (int x = 0; x < width_; ++x)
+        {
+            dst[3 * x] = src[4 * x];
+            dst[3 * x + 1] = src[4 * x + 1];
+            dst[3 * x + 2] = src[4 * x + 2];
+        }
+    }
+
+    std::FILE* out = raw_;
+    if (format_ == Format::Ppm)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "frame_%05zu.ppm", frames_);
+        auto path = (std::filesystem::path(directory_) / name).string();
+
+        out = std::fopen(path.c_str(), "wb");
+        if (out == nullptr)
+        {
+            return false;
+        }
+        std::fprintf(out, "P6\n%d %d\n255\n", width_, height_);
+    }
+    else if (out == nullptr)
+    {
+        return false;
+    }
+
+    auto ok = std::fwrite(rgb_.data(), 1, rgb_.size(), out) == rgb_.size();
+    if (format_ == Format::Ppm)
+    {
+        ok = std::fclose(out) == 0 && ok;
+    }
+
+    frames_ += ok;
+    return ok;
+}
+
+} // namespace msb
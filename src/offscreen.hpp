@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace msb
+{
+
+// Framebuffer with an RGBA8 color and a depth renderbuffer.  Finished frames are read back
+// through two pixel pack buffers in turn, so the copy of frame n runs while frame n + 1 renders
+// and glReadPixels never stalls the pipeline.
+class OffscreenTarget
+{
+  public:
+    OffscreenTarget(int width, int height);
+    ~OffscreenTarget();
+
+    OffscreenTarget(const OffscreenTarget&) = delete;
+    OffscreenTarget& operator=(const OffscreenTarget&) = delete;
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    bool complete() const { return complete_; }
+
+    // Bind the framebuffer and set the viewport to cover it
+    void bind() const;
+
+    // Start reading the frame just rendered.  When the previous frame is ready its RGBA rows,
+    // bottom to top, are copied into pixels and true is returned.
+    bool readback(std::vector<unsigned char>& pixels);
+
+    // Wait for the last frame started by readback
+    bool flush(std::vector<unsigned char>& pixels);
+
+  private:
+    int width_;
+    int height_;
+    bool complete_ = false;
+
+    unsigned int fbo_ = 0;
+    unsigned int color_ = 0;
+    unsigned int depth_ = 0;
+    unsigned int pbos_[2] = {0, 0};
+
+    int next_ = 0;
+    bool pending_ = false;
+
+    bool copyOut(int pbo, std::vector<unsigned char>& pixels);
+};
+
+// Frame sequence on disk from RGBA readbacks: one binary PPM per frame (frame_00000.ppm, ...) or
+// a single headerless RGB stream, e.g. for ffmpeg -f rawvideo -pix_fmt rgb24
+class FrameWriter
+{
+  public:
+    enum class Format
+    {
+        Ppm,
+        Raw
+    };
+
+    FrameWriter(std::string directory, Format format, int width, int height);
+    ~FrameWriter();
+
+    FrameWriter(const FrameWriter&) = delete;
+    FrameWriter& operator=(const FrameWriter&) = delete;
+
+    // pixels as filled by OffscreenTarget; rows are written top to bottom
+    bool write(const std::vector<unsigned char>& pixels);
+
+    size_t frames() const { return frames_; }
+
+  private:
+    std::string directory_;
+    Format format_;
+    int width_;
+    int height_;
+    size_t frames_ = 0;
+
+    std::FILE* raw_ = nullptr;
+    std::vector<unsigned char> rgb_;
+};
+
+} // namespace msb
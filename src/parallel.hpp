@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace msb
+{
+
+// Counts jobs down to zero; wait() returns once every one of them has called countDown()
+class Latch
+{
+  public:
+    explicit Latch(size_t count) : count_(count) {}
+
+    Latch(const Latch&) = delete;
+    Latch& operator=(const Latch&) = delete;
+
+    void countDown()
+    {
+        // notified under the lock, so the waiter cannot destroy the latch before this returns
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--count_ == 0)
+        {
+            done_.notify_all();
+        }
+    }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return count_ == 0; });
+    }
+
+  private:
+    size_t count_;
+    std::mutex mutex_;
+    std::condition_variable done_;
+};
+
+// Fixed set of worker threads running submitted jobs in FIFO order.  The destructor finishes
+// the queued jobs before joining.
+class ThreadPool
+{
+  public:
+    ThreadPool(size_t num_threads = std::max(1u, std::thread::hardware_concurrency()))
+    {
+        for (size_t i = 0; i < std::max<size_t>(1, num_threads); ++i)
+        {
+            workers_.emplace_back([this] { run(); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+
+        for (auto& worker : workers_)
+        {
+            worker.join();
+        }
+    }
+
+    void submit(std::function<void()> job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            jobs_.push_back(std::move(job));
+        }
+        wake_.notify_one();
+    }
+
+    size_t size() const { return workers_.size(); }
+
+    // true on the pool's own worker threads
+    bool onWorker() const { return current_ == this; }
+
+  private:
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> jobs_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+
+    static inline thread_local const ThreadPool* current_ = nullptr;
+
+    void run()
+    {
+        current_ = this;
+        while (true)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+                if (jobs_.empty())
+                {
+                    return;
+                }
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+            job();
+        }
+    }
+};
+
+// Workers for parallelFor, one per hardware thread besides the caller, started on first use
+inline ThreadPool& parallelPool()
+{
+    static ThreadPool pool(std::max(2u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+// Split [begin, end) into one contiguous block per hardware thread and call fn(first, last) for
+// each block.  The calling thread takes the first block and the rest run on parallelPool(), so
+// per-frame callers do not pay for starting threads; ranges shorter than min_block per thread
+// use fewer threads.  A call made from inside a block runs serially.
+template <typename Fn> void parallelFor(size_t begin, size_t end, Fn&& fn, size_t min_block = 1)
+{
+    if (end <= begin)
+    {
+        return;
+    }
+
+    auto& pool = parallelPool();
+    if (pool.onWorker())
+    {
+        fn(begin, end);
+        return;
+    }
+
+    auto count = end - begin;
+    auto max_threads = std::max<size_t>(1, count / std::max<size_t>(1, min_block));
+    auto hardware = std::max(1u, std::thread::hardware_concurrency());
+    auto num_threads = std::min<size_t>({hardware, pool.size() + 1, max_threads});
+
+    auto block = (count + num_threads - 1) / num_threads;
+    auto num_blocks = (count + block - 1) / block;
+
+    Latch done(num_blocks - 1);
+    for (size_t b = 1; b < num_blocks; ++b)
+    {
+        auto first = begin + b * block;
+        auto last = std::min(end, first + block);
+        pool.submit([&fn, &done, first, last] {
+            fn(first, last);
+            done.countDown();
+        });
+    }
+
+    fn(begin, std::min(end, begin + block));
+
+    done.wait();
+}
+
+} // namespace msb
@@ -0,0 +1,290 @@
+#include "profiler.hpp"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace msb
+{
+
+void FrameTimes::add(double ms)
+{
+    if (capacity_ == 0)
+    {
+        return;
+    }
+
+    if (samples_.size() < capacity_)
+    {
+        samples_.push_back(ms);
+    }
+    else
+    {
+        samples_[next_] = ms;
+    }
+    next_ = (next_ + 1) % capacity_;
+}
+
+double FrameTimes::percentile(double p) const
+{
+    if (samples_.empty())
+    {
+        return 0.;
+    }
+
+    auto sorted = samples_;
+    auto rank = size_t(std::clamp(p, 0., 1.) * double(sorted.size() - 1) + .5);
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank];
+}
+
+double FrameTimes::mean() const
+{
+    if (samples_.empty())
+    {
+        return 0.;
+    }
+
+    double sum = 0.;
+    for (auto ms : samples_)
+    {
+        sum += ms;
+    }
+    return sum / double(samples_.size());
+}
+
+Profiler::Profiler(size_t max_events) : origin_(Clock::now()), max_events_(max_events) {}
+
+Profiler::~Profiler()
+{
+    for (auto& pass : gpu_passes_)
+    {
+        glDeleteQueries(query_ring, pass.queries);
+    }
+}
+
+double Profiler::nowUs() const
+{
+    return std::chrono::duration<double, std::micro>(Clock::now() - origin_).count();
+}
+
+size_t Profiler::zoneIndex(const char* name, bool gpu)
+{
+    for (size_t i = 0; i < zones_.size(); ++i)
+    {
+        if (zones_[i].gpu == gpu && zones_[i].name == name)
+        {
+            return i;
+        }
+    }
+
+    zones_.push_back({name, gpu});
+    return zones_.size() - 1;
+}
+
+void Profiler::record(size_t zone, double start_us, double duration_us)
+{
+    zones_[zone].times.add(duration_us / 1000.);
+    if (events_.size() < max_events_)
+    {
+        events_.push_back({zones_[zone].name, zones_[zone].gpu, start_us, duration_us});
+    }
+}
+
+void Profiler::beginFrame()
+{
+    auto now = nowUs();
+    if (frame_start_us_ >= 0.)
+    {
+        frames_.add((now - frame_start_us_) / 1000.);
+        if (events_.size() < max_events_)
+        {
+            events_.push_back({"frame", false, frame_start_us_, now - frame_start_us_});
+        }
+    }
+    frame_start_us_ = now;
+}
+
+void Profiler::endFrame()
+{
+    for (auto& pass : gpu_passes_)
+    {
+        // oldest first, so results stay in issue order
+        for (int i = 0; i < query_ring; ++i)
+        {
+            collect(pass, (pass.next + i) % query_ring, false);
+        }
+    }
+}
+
+void Profiler::beginCpu(const char* name)
+{
+    cpu_stack_.push_back({zoneIndex(name, false), nowUs()});
+}
+
+void Profiler::endCpu()
+{
+    if (cpu_stack_.empty())
+    {
+        return;
+    }
+
+    auto open = cpu_stack_.back();
+    cpu_stack_.pop_back();
+    record(open.zone, open.start_us, nowUs() - open.start_us);
+}
+
+void Profiler::beginGpu(const char* name)
+{
+    // a zone inside another is folded into the outer one
+    if (gpu_depth_++ > 0)
+    {
+        return;
+    }
+
+    auto zone = zoneIndex(name, true);
+    auto pass = std::find_if(gpu_passes_.begin(), gpu_passes_.end(),
+                             [zone](const GpuPass& p) { return p.zone == zone; });
+    if (pass == gpu_passes_.end())
+    {
+        gpu_passes_.push_back({zone});
+        pass = gpu_passes_.end() - 1;
+        glGenQueries(query_ring, pass->queries);
+    }
+
+    // the ring has wrapped onto a query the GL has not finished; wait rather than lose it
+    auto slot = pass->next;
+    collect(*pass, slot, true);
+
+    pass->start_us[slot] = nowUs();
+    glBeginQuery(GL_TIME_ELAPSED, pass->queries[slot]);
+    open_gpu_ = int(pass - gpu_passes_.begin());
+}
+
+void Profiler::endGpu()
+{
+    if (gpu_depth_ == 0 || --gpu_depth_ > 0)
+    {
+        return;
+    }
+
+    glEndQuery(GL_TIME_ELAPSED);
+
+    auto& pass = gpu_passes_[size_t(open_gpu_)];
+    pass.pending[pass.next] = true;
+    pass.next = (pass.next + 1) % query_ring;
+    open_gpu_ = -1;
+}
+
+void Profiler::collect(GpuPass& pass, int slot, bool wait)
+{
+    if (!pass.pending[slot])
+    {
+        return;
+    }
+
+    if (!wait)
+    {
+        GLint available = 0;
+        glGetQueryObjectiv(pass.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            return;
+        }
+    }
+
+    GLuint64 elapsed_ns = 0;
+    glGetQueryObjectui64v(pass.queries[slot], GL_QUERY_RESULT, &elapsed_ns);
+    pass.pending[slot] = false;
+    record(pass.zone, pass.start_us[slot], double(elapsed_ns) / 1000.);
+}
+
+double Profiler::zoneMedian(const std::string& name, bool gpu) const
+{
+    for (auto& zone : zones_)
+    {
+        if (zone.gpu == gpu && zone.name == name && zone.times.size() > 0)
+        {
+            return zone.times.percentile(.5);
+        }
+    }
+    return -1.;
+}
+
+std::string Profiler::summary() const
+{
+    char buffer[128];
+    std::snprintf(buffer, sizeof(buffer), "frame p50 %.2f p95 %.2f p99 %.2f ms",
+                  frames_.percentile(.5), frames_.percentile(.95), frames_.percentile(.99));
+    std::string line = buffer;
+
+    for (auto& zone : zones_)
+    {
+        if (zone.times.size() > 0)
+        {
+            std::snprintf(buffer, sizeof(buffer), " | %s %s %.2f", zone.name.c_str(),
+                          zone.gpu ? "gpu" : "cpu", zone.times.percentile(.5));
+            line += buffer;
+        }
+    }
+    return line;
+}
+
+namespace
+{
+
+void writeJsonString(std::ostream& out, const std::string& s)
+{
+    out << '"';
+    for (auto c : s)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out << '\\';
+        }
+        out << (static_cast<unsigned char>(c) < 0x20 ? ' ' : c);
+    }
+    out << '"';
+}
+
+} // namespace
+
+bool Profiler::writeChromeTrace(const std::string& path)
+{
+    for (auto& pass : gpu_passes_)
+    {
+        for (int i = 0; i < query_ring; ++i)
+        {
+            collect(pass, (pass.next + i) % query_ring, true);
+        }
+    }
+
+    std::ofstream out(path, std::ios::trunc);
+    if (!out)
+    {
+        return false;
+    }
+
+    out << "{\"traceEvents\": [\n";
+    out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": 0, "
+           "\"args\": {\"name\": \"CPU\"}},\n";
+    out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": 1, "
+           "\"args\": {\"name\": \"GPU\"}}";
+
+    char numbers[96];
+    for (auto& event : events_)
+    {
+        out << ",\n{\"name\": ";
+        writeJsonString(out, event.name);
+        std::snprintf(numbers, sizeof(numbers), ", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f",
+                      event.start_us, event.duration_us);
+        out << numbers << ", \"pid\": 0, \"tid\": " << (event.gpu ? 1 : 0) << "}";
+    }
+    out << "\n]}\n";
+
+    return bool(out);
+}
+
+} // namespace msb
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace msb
+{
+
+// The most recent frame times (or zone durations), in milliseconds, for percentiles that follow
+// the current workload rather than the whole run
+class FrameTimes
+{
+  public:
+    explicit FrameTimes(size_t capacity = 600) : capacity_(capacity) {}
+
+    void add(double ms);
+
+    // p in [0, 1], nearest rank; 0 when empty
+    double percentile(double p) const;
+    double mean() const;
+
+    size_t size() const { return samples_.size(); }
+
+  private:
+    size_t capacity_;
+    size_t next_ = 0;
+    std::vector<double> samples_;
+};
+
+// One complete span for the Chrome trace viewer (chrome://tracing, ui.perfetto.dev)
+struct TraceEvent
+{
+    std::string name;
+    bool gpu;
+    double start_us; // since the profiler was created
+    double duration_us;
+};
+
+// Frame timing, named CPU zones and GL_TIME_ELAPSED timer queries for GPU passes.
+//
+// Each GPU pass name owns a small ring of queries; a result is read back once the GL reports it
+// available, a few frames later, so timing never stalls the pipeline.  GPU spans are placed in
+// the trace at the CPU time their pass was issued.  Timer queries cannot nest, so GPU zones
+// must not overlap.  Every call must come from the GL thread.
+class Profiler
+{
+  public:
+    explicit Profiler(size_t max_events = size_t(1) << 20);
+    ~Profiler();
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    // Call at the start of every frame; the time since the previous call is one frame
+    void beginFrame();
+
+    // Collect GPU results that have become available
+    void endFrame();
+
+    void beginCpu(const char* name);
+    void endCpu();
+
+    void beginGpu(const char* name);
+    void endGpu();
+
+    const FrameTimes& frameTimes() const { return frames_; }
+
+    // Median duration of a zone over its recent samples, -1 if it was never recorded
+    double zoneMedian(const std::string& name, bool gpu) const;
+
+    // One line: frame p50/p95/p99 and the median of every zone
+    std::string summary() const;
+
+    const std::vector<TraceEvent>& events() const { return events_; }
+
+    // {"traceEvents": [...]} with CPU zones on one track and GPU passes on another.  Pending
+    // GPU queries are waited for first.
+    bool writeChromeTrace(const std::string& path);
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr int query_ring = 4;
+
+    struct Zone
+    {
+        std::string name;
+        bool gpu;
+        FrameTimes times{120};
+    };
+
+    struct OpenZone
+    {
+        size_t zone;
+        double start_us;
+    };
+
+    struct GpuPass
+    {
+        size_t zone;
+        unsigned int queries[query_ring] = {};
+        double start_us[query_ring] = {};
+        bool pending[query_ring] = {};
+        int next = 0;
+    };
+
+    Clock::time_point origin_;
+    double frame_start_us_ = -1.;
+    FrameTimes frames_;
+
+    size_t max_events_;
+    std::vector<TraceEvent> events_;
+    std::vector<Zone> zones_;
+    std::vector<OpenZone> cpu_stack_;
+    std::vector<GpuPass> gpu_passes_;
+    int open_gpu_ = -1;
+    int gpu_depth_ = 0;
+
+    double nowUs() const;
+    size_t zoneIndex(const char* name, bool gpu);
+    void record(size_t zone, double start_us, double duration_us);
+    void collect(GpuPass& pass, int slot, bool wait);
+};
+
+// Times the enclosing scope as a CPU zone
+class CpuZone
+{
+  public:
+    CpuZone(Profiler& profiler, const char* name) : profiler_(profiler)
+    {
+        profiler_.beginCpu(name);
+    }
+    ~CpuZone() { profiler_.endCpu(); }
+
+    CpuZone(const CpuZone&) = delete;
+    CpuZone& operator=(const CpuZone&) = delete;
+
+  private:
+    Profiler& profiler_;
+};
+
+// Times the GL commands issued in the enclosing scope
+class GpuZone
+{
+  public:
+    GpuZone(Profiler& profiler, const char* name) : profiler_(profiler)
+    {
+        profiler_.beginGpu(name);
+    }
+    ~GpuZone() { profiler_.endGpu(); }
+
+    GpuZone(const GpuZone&) = delete;
+    GpuZone& operator=(const GpuZone&) = delete;
+
+  private:
+    Profiler& profiler_;
+};
+
+} // namespace msb
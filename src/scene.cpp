@@ -0,0 +1,238 @@
+#include "scene.hpp"
+
+#include "clipmap.hpp"
+#include "geometry.hpp"
+#include "terrain.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace msb
+{
+
+namespace
+{
+
+// The clipmap spans kilometers, so 16-bit positions would be too coarse for its 10 cm near
+// field; it keeps float vertices whatever the packing of the other meshes
+Model makeOcean(TextureLoader& loader)
+{
+    auto [vertices, faces] = getClipmap();
+
+    std::vector<Texture> ocean_tex = {
+        loader.load("resources/bathy2.png", "texture_diffuse", GL_CLAMP_TO_EDGE, GL_LINEAR,
+                    GL_RGB),
+        loader.load("resources/foam2.png", "texture_diffuse", GL_MIRRORED_REPEAT, GL_LINEAR,
+                    GL_RGBA)};
+
+    auto mesh = Mesh(std::move(vertices), {3}, std::move(faces), ocean_tex, VertexPacking::Float);
+    mesh.releaseCpuData();
+    return Model(std::move(mesh));
+}
+
+Model makeBeach(TextureLoader& loader, VertexPacking packing)
+{
+    // auto [v_beach, f_beach] = getQuad(50, 50, 10);
+    std::vector<Texture> beach_tex = {
+        loader.load("resources/Sand 002/Sand 002_COLOR.jpg", "texture_diffuse",
+                    GL_MIRRORED_REPEAT, GL_LINEAR, GL_SRGB),
+        loader.load("resources/Sand 002/Sand 002_NRM.jpg", "texture_diffuse", GL_MIRRORED_REPEAT,
+                    GL_LINEAR, GL_RGB),
+        loader.load("resources/Sand 002/Sand 002_OCC.jpg", "texture_diffuse", GL_MIRRORED_REPEAT,
+                    GL_LINEAR, GL_RGB),
+        loader.load("resources/Sand 002/Sand 002_DISP.jpg", "texture_diffuse", GL_MIRRORED_REPEAT,
+                    GL_LINEAR, GL_RGB)};
+
+    auto mesh = loadTerrainMesh("resources/bathy2.png", "resources/bathy_norms2.png", 50, 50,
+                                IndexMode::Strips16, beach_tex, packing,
+                                "resources/bathy2.terrain");
+    mesh.releaseCpuData();
+    return Model(std::move(mesh));
+}
+
+// std140 layout of FrameBlock in the ocean and beach shaders
+struct FrameStd140
+{
+    glm::mat4 projection;
+    glm::mat4 view;
+    glm::vec3 cam_pos;
+    float padding0;
+    glm::vec2 grid_center;
+    glm::vec2 padding1;
+};
+static_assert(sizeof(FrameStd140) == 160, "FrameStd140 must match the std140 block size");
+
+// after GeomWaveBlock and TexWaveBlock
+constexpr unsigned int frame_binding = 2;
+
+// Everything one frame streams, plus room to align each of its writes: the frame constants and
+// both wave blocks always, and the two spectrum maps in spectral mode
+size_t frameBytes(const WaveSimulation& simulation)
+{
+    auto bytes = sizeof(FrameStd140) + 5 * 256 +
+                 (simulation.geomWaves() + simulation.texWaves()) * sizeof(WaveStd140);
+    if (simulation.mode() == OceanMode::Spectral)
+    {
+        auto size = size_t(simulation.spectrumSettings().size);
+        bytes += 2 * size * size * 3 * sizeof(float);
+    }
+    return bytes;
+}
+
+} // namespace
+
+Scene::Scene(TextureLoader& loader, VertexPacking packing, double start_time, OceanMode mode)
+    : ocean_(makeOcean(loader)),
+      ocean_shader_("shaders/ocean.vert", "shaders/ocean_pbr2.frag"),
+      beach_(makeBeach(loader, packing)),
+      beach_shader_("shaders/tbn_tex.vert", "shaders/tbn_tex.frag"),
+      cube_shader_("shaders/cube.vert", "shaders/cube.frag"),
+      environment_(loadEnvironment("resources/Malibu/Malibu_Overlook_env.hdr",
+                                   "resources/Malibu/Malibu_Overlook_env.cube")),
+      cube_vao_(fillBuffers(makeSkybox().first)), brdf_map_(loadBrdfLut("resources/brdf_lut.bin")),
+      simulation_(start_time, mode), geom_block_("GeomWaveBlock", simulation_.geomWaves(), 0),
+      tex_block_("TexWaveBlock", simulation_.texWaves(), 1), stream_(frameBytes(simulation_)),
+      light_dir_(1.f, -.25f, 0.f)
+{
+    ocean_shader_.setFloat("avg_water_ht", 0.f);
+    ocean_shader_.setFloat("grid_ring_quads", float(ClipmapSettings().ring_quads));
+    ocean_shader_.setInt("brdf_map", 2);
+    ocean_shader_.setInt("irradiance_map", 6);
+    ocean_shader_.setInt("prefilter_map", 7);
+    ocean_shader_.setFloat("prefilter_max_lod", environment_.prefiltered_max_lod);
+
+    if (mode == OceanMode::Spectral)
+    {
+        auto& settings = simulation_.spectrumSettings();
+        spectrum_maps_.emplace(settings.size);
+        ocean_shader_.setBool("spectral", true);
+        ocean_shader_.setInt("spectrum_displacement", 3);
+        ocean_shader_.setInt("spectrum_normals", 4);
+        ocean_shader_.setFloat("spectrum_patch", settings.patch);
+        ocean_shader_.setFloat("spectrum_size", float(settings.size));
+    }
+
+    beach_shader_.setInt("brdf_map", 5);
+    beach_shader_.setInt("irradiance_map", 6);
+    beach_shader_.setInt("prefilter_map", 7);
+    beach_shader_.setFloat("prefilter_max_lod", environment_.prefiltered_max_lod);
+
+    // auto [v_cube, f_cube] = makeSkybox();
+    // auto skybox_vao = fillBuffers(v_cube);
+    // auto cubemap_tex = loadCubemap({ "skybox2/right.jpg","skybox2/left.jpg","skybox2/top.jpg",
+    //								 "skybox2/bottom.jpg","skybox2/front.jpg","skybox2/back.jpg"
+    //});
+    cube_shader_.setInt("skybox", 0);
+
+    // image-based lighting stays bound on units 6 and 7 for both shaders
+    glActiveTexture(GL_TEXTURE6);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, environment_.irradiance);
+    glActiveTexture(GL_TEXTURE7);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, environment_.prefiltered);
+    glActiveTexture(GL_TEXTURE0);
+
+    geom_block_.attach(ocean_shader_);
+    tex_block_.attach(ocean_shader_);
+    attachUniformBlock(ocean_shader_, "FrameBlock", frame_binding);
+    attachUniformBlock(beach_shader_, "FrameBlock", frame_binding);
+
+    ocean_shader_.setMat4("model", glm::mat4(1.0f));
+    beach_shader_.setMat4("model", glm::mat4(1.0f));
+
+    // Directional
+    // auto dir_light_vec = glm::vec3(-0.2f, -1.0f, -0.3f);
+    ocean_shader_.setVec3("dir_light.direction", light_dir_);
+    ocean_shader_.setVec3("dir_light.ambient", 0.4f, 0.4f, 0.4f);
+    ocean_shader_.setVec3("dir_light.diffuse", .3f, .3f, .3f);
+    ocean_shader_.setVec3("dir_light.specular", .8f, .8f, .8f);
+
+    beach_shader_.setVec3("light_dir", light_dir_);
+
+    // glEnable(GL_FRAMEBUFFER_SRGB);
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glEnable(GL_DEPTH_TEST);
+}
+
+void Scene::draw(const SimClock& clock, CameraState& camera, Profiler& profiler)
+{
+    glClearColor(0.0, 0.0, 0.0, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // Take the waves simulated while the previous frame drew and start on the next frame's at
+    // once; nothing is in flight before the first frame, so it waits for its own
+    if (simulation_.idle())
+    {
+        simulation_.request(clock.now());
+    }
+    const WaveFrame* waves;
+    {
+        CpuZone zone(profiler, "wait waves");
+        waves = &simulation_.acquire();
+    }
+    simulation_.request(clock.next());
+
+    // All of the frame's dynamic data goes through the stream buffer
+    {
+        CpuZone zone(profiler, "upload frame");
+        stream_.beginFrame();
+
+        auto cam_pos = camera.cameraPosition();
+        FrameStd140 constants{camera.projectionMatrix(), camera.viewMatrix(), cam_pos, 0.f,
+                              glm::vec2(cam_pos.x, cam_pos.z), glm::vec2(0.f)};
+        stream_.bindUniform(frame_binding, &constants, sizeof(constants));
+
+        // the ocean shaders declare both wave blocks in either mode, so both always get a range
+        stream_.bindUniform(geom_block_.binding(), waves->geom_waves.data(),
+                            waves->geom_waves.size() * sizeof(WaveStd140));
+        stream_.bindUniform(tex_block_.binding(), waves->tex_waves.data(),
+                            waves->tex_waves.size() * sizeof(WaveStd140));
+
+        if (spectrum_maps_)
+        {
+            auto map_bytes = waves->displacement.size() * sizeof(float);
+            auto displacement = stream_.write(waves->displacement.data(), map_bytes);
+            auto normals = stream_.write(waves->normals.data(), map_bytes);
+            if (displacement && normals)
+            {
+                spectrum_maps_->update(stream_.id(), *displacement, *normals);
+            }
+        }
+    }
+
+    // Beach
+    {
+        GpuZone zone(profiler, "beach");
+        glActiveTexture(GL_TEXTURE5);
+        glBindTexture(GL_TEXTURE_2D, brdf_map_);
+        beach_.Draw(beach_shader_);
+    }
+
+    // Waves
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, brdf_map_);
+    if (spectrum_maps_)
+    {
+        spectrum_maps_->bind(3, 4);
+    }
+    {
+        GpuZone zone(profiler, "ocean");
+        ocean_.Draw(ocean_shader_);
+    }
+
+    // the region is free again once the GPU has finished the draws above
+    stream_.endFrame();
+
+    // Cube map
+    // glDepthFunc(GL_LEQUAL);
+    // cube_shader_.setMat4("view", glm::mat4(glm::mat3(camera.viewMatrix())));
+    // cube_shader_.setMat4("projection", camera.projectionMatrix());
+    // glBindVertexArray(cube_vao_);
+    // glActiveTexture(GL_TEXTURE0);
+    // glBindTexture(GL_TEXTURE_CUBE_MAP, environment_.skybox);
+    // glDrawArrays(GL_TRIANGLES, 0, 36);
+    // glBindVertexArray(0);
+    // glDepthFunc(GL_LESS);
+}
+
+} // namespace msb
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "camera.hpp"
+#include "gl_helpers.hpp"
+#include "model.hpp"
+#include "ocean_spectrum.hpp"
+#include "profiler.hpp"
+#include "shader.hpp"
+#include "sim_clock.hpp"
+#include "texture_loader.hpp"
+#include "wave.hpp"
+#include "wave_simulation.hpp"
+
+#include <glm/glm.hpp>
+
+#include <optional>
+
+namespace msb
+{
+
+// The beach, the ocean and their image-based lighting, as drawn by the render loop in main and
+// by the frame benchmarks.  Constructing it needs a current GL context; textures arrive through
+// loader as they decode.
+class Scene
+{
+  public:
+    Scene(TextureLoader& loader, VertexPacking packing, double start_time,
+          OceanMode mode = OceanMode::Gerstner);
+
+    Scene(const Scene&) = delete;
+    Scene& operator=(const Scene&) = delete;
+
+    // Clear the bound framebuffer and draw the frame seen by camera at clock.now().  The waves
+    // for clock.next() are simulated in the background meanwhile.
+    void draw(const SimClock& clock, CameraState& camera, Profiler& profiler);
+
+  private:
+    Model ocean_;
+    Shader ocean_shader_;
+    Model beach_;
+    Shader beach_shader_;
+    Shader cube_shader_;
+
+    EnvironmentTextures environment_;
+    unsigned int cube_vao_;
+    unsigned int brdf_map_;
+
+    // wave arrays live in std140 uniform blocks, sized to NUM_WAVES/NUM_TEX_WAVES in the shaders
+    WaveSimulation simulation_;
+    WaveBlock geom_block_;
+    WaveBlock tex_block_;
+
+    // every per-frame upload: FrameBlock, the wave blocks and the spectrum maps
+    StreamBuffer stream_;
+
+    // set in OceanMode::Spectral only; the maps sit on texture units 3 and 4
+    std::optional<SpectrumTextures> spectrum_maps_;
+
+    glm::vec3 light_dir_;
+};
+
+} // namespace msb
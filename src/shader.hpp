@@ -8,7 +8,15 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
+// Typed handle to a uniform location, resolved once through Shader::uniform().  A location of -1
+// marks an inactive uniform and is silently ignored by GL, same as glGetUniformLocation.
+template <typename T> struct Uniform
+{
+    int location = -1;
+};
 
 class Shader
 {
@@ -60,6 +68,8 @@ class Shader
 
         glDeleteShader(vertexShader);
         glDeleteShader(fragmentShader);
+
+        registerUniforms();
     }
 
     std::string getShaderSource(std::string filename) const
@@ -79,60 +89,151 @@ class Shader
     Shader(Shader&&) = default;
     Shader& operator=(Shader&&) = default;
 
-    // Use/activate the shader
-    void use() const { glUseProgram(id); }
+    // Use/activate the shader, skipping glUseProgram when this program is already bound
+    void use() const
+    {
+        if (bound_program_ != id)
+        {
+            glUseProgram(id);
+            bound_program_ = id;
+        }
+    }
+
+    // Forget the program use() last bound, so the next use() always calls glUseProgram.  Needed
+    // after binding a program without going through Shader and after making a context current.
+    static void resetBoundProgram() { bound_program_ = 0; }
+
+    // Uniform location from the table built at link time, -1 if the uniform is not active
+    int location(const std::string& name) const
+    {
+        auto it = uniforms_.find(name);
+        return it == uniforms_.end() ? -1 : it->second;
+    }
+
+    template <typename T> Uniform<T> uniform(const std::string& name) const
+    {
+        return {location(name)};
+    }
 
-    // set uniform types
-    void setBool(const std::string& name, bool value) const
+    // set uniforms through pre-resolved handles
+    void set(Uniform<bool> u, bool value) const
     {
         use();
-        glUniform1i(glGetUniformLocation(id, name.c_str()), static_cast<int>(value));
+        glUniform1i(u.location, static_cast<int>(value));
     }
 
-    void setInt(const std::string& name, int value) const
+    void set(Uniform<int> u, int value) const
     {
         use();
-        glUniform1i(glGetUniformLocation(id, name.c_str()), value);
+        glUniform1i(u.location, value);
     }
 
-    void setFloat(const std::string& name, float value) const
+    void set(Uniform<float> u, float value) const
     {
         use();
-        glUniform1f(glGetUniformLocation(id, name.c_str()), value);
+        glUniform1f(u.location, value);
     }
 
-    void setMat3(const std::string& name, glm::mat3 value) const
+    void set(Uniform<glm::vec2> u, glm::vec2 value) const
     {
         use();
-        auto value_loc = glGetUniformLocation(id, name.c_str());
-        glUniformMatrix3fv(value_loc, 1, GL_FALSE, glm::value_ptr(value));
+        glUniform2f(u.location, value.x, value.y);
     }
 
-    void setMat4(const std::string& name, glm::mat4 value) const
+    void set(Uniform<glm::vec3> u, glm::vec3 value) const
     {
         use();
-        auto value_loc = glGetUniformLocation(id, name.c_str());
-        glUniformMatrix4fv(value_loc, 1, GL_FALSE, glm::value_ptr(value));
+        glUniform3f(u.location, value.x, value.y, value.z);
     }
 
-    void setVec2(const std::string& name, glm::vec2 value)
+    void set(Uniform<glm::mat3> u, const glm::mat3& value) const
     {
         use();
-        auto value_loc = glGetUniformLocation(id, name.c_str());
-        glUniform2f(value_loc, value.x, value.y);
+        glUniformMatrix3fv(u.location, 1, GL_FALSE, glm::value_ptr(value));
     }
 
-    void setVec3(const std::string& name, float v0, float v1, float v2) const
+    void set(Uniform<glm::mat4> u, const glm::mat4& value) const
     {
         use();
-        auto value_loc = glGetUniformLocation(id, name.c_str());
-        glUniform3f(value_loc, v0, v1, v2);
+        glUniformMatrix4fv(u.location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+
+    // set uniform types by name
+    void setBool(const std::string& name, bool value) const { set(uniform<bool>(name), value); }
+
+    void setInt(const std::string& name, int value) const { set(uniform<int>(name), value); }
+
+    void setFloat(const std::string& name, float value) const { set(uniform<float>(name), value); }
+
+    void setMat3(const std::string& name, glm::mat3 value) const
+    {
+        set(uniform<glm::mat3>(name), value);
+    }
+
+    void setMat4(const std::string& name, glm::mat4 value) const
+    {
+        set(uniform<glm::mat4>(name), value);
+    }
+
+    void setVec2(const std::string& name, glm::vec2 value) const
+    {
+        set(uniform<glm::vec2>(name), value);
+    }
+
+    void setVec3(const std::string& name, float v0, float v1, float v2) const
+    {
+        set(uniform<glm::vec3>(name), glm::vec3(v0, v1, v2));
     }
 
     void setVec3(const std::string& name, glm::vec3 value) const
     {
-        use();
-        auto value_loc = glGetUniformLocation(id, name.c_str());
-        glUniform3f(value_loc, value.x, value.y, value.z);
+        set(uniform<glm::vec3>(name), value);
+    }
+
+  private:
+    std::unordered_map<std::string, int> uniforms_;
+
+    // Program last bound through use() in the current context, 0 when unknown
+    static inline unsigned int bound_program_ = 0;
+
+    // Enumerate the active uniforms once after linking.  Arrays of basic types are reported as
+    // "name[0]", so every element is registered along with the bare array name.
+    void registerUniforms()
+    {
+        int num_uniforms = 0;
+        int max_length = 0;
+        glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &num_uniforms);
+        glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+        std::vector<char> buffer(max_length + 1);
+        for (int i = 0; i < num_uniforms; ++i)
+        {
+            int length = 0;
+            int size = 0;
+            GLenum type;
+            glGetActiveUniform(id, i, GLsizei(buffer.size()), &length, &size, &type, buffer.data());
+
+            std::string name(buffer.data(), length);
+            auto loc = glGetUniformLocation(id, name.c_str());
+            if (loc < 0)
+            {
+                // uniform block member
+                continue;
+            }
+
+            uniforms_[name] = loc;
+
+            if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+            {
+                auto base = name.substr(0, name.size() - 3);
+                uniforms_[base] = loc;
+
+                for (int element = 1; element < size; ++element)
+                {
+                    auto element_name = base + "[" + std::to_string(element) + "]";
+                    uniforms_[element_name] = glGetUniformLocation(id, element_name.c_str());
+                }
+            }
+        }
     }
 };
\ No newline at end of file
@@ -1,125 +0,0 @@
-#version 330 core
-
-in vec2 TexCoords;
-
-// layout (location = 0) out vec2 FragColor;
-out vec2 FragColor;
-
-vec2 integrateBrdf(float NdotV, float roughness);
-float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness);
-float GeometrySchlickGgxIbl(float NdotV, float roughness);
-vec2 hammersley(uint i, uint N);
-vec3 importanceSampleGGX(vec2 Xi, vec3 N, float roughness);
-float vanDerCorpus(uint n, uint base);
-
-const float PI = 3.14159265359;
-
-void main()
-{
-    vec2 integrated_brdf = integrateBrdf(TexCoords.x, TexCoords.y);
-    //	FragColor = integrated_brdf;
-    FragColor = integrated_brdf;
-}
-
-float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness)
-{
-    float NdotV = max(dot(N, V), 0.0);
-    float NdotL = max(dot(N, L), 0.0);
-    float ggx1 = GeometrySchlickGgxIbl(NdotV, roughness);
-    float ggx2 = GeometrySchlickGgxIbl(NdotL, roughness);
-
-    return ggx1 * ggx2;
-}
-
-float GeometrySchlickGgxIbl(float NdotV, float roughness)
-{
-    float r = roughness;
-    float k = (r * r) / 2.0;
-
-    float nom = NdotV;
-    float denom = NdotV * (1.0 - k) + k;
-
-    return nom / denom;
-}
-
-vec2 integrateBrdf(float NdotV, float roughness)
-{
-    vec3 V;
-    V.x = sqrt(1.0 - NdotV * NdotV);
-    V.y = 0.0;
-    V.z = NdotV;
-
-    float A = 0.0;
-    float B = 0.0;
-
-    vec3 N = vec3(0.0, 0.0, 1.0);
-
-    const uint SAMPLE_COUNT = 1024u;
-    for (uint i = 0u; i < SAMPLE_COUNT; ++i)
-    {
-        vec2 Xi = hammersley(i, SAMPLE_COUNT);
-        vec3 H = importanceSampleGGX(Xi, N, roughness);
-        vec3 L = normalize(2.0 * dot(V, H) * H - V);
-
-        float NdotL = max(L.z, 0.0);
-        float NdotH = max(H.z, 0.0);
-        float VdotH = max(dot(V, H), 0.0);
-
-        if (NdotL > 0.0)
-        {
-            float G = GeometrySmith(N, V, L, roughness);
-            float G_Vis = (G * VdotH) / (NdotH * NdotV);
-            float Fc = pow(1.0 - VdotH, 5.0);
-
-            A += (1.0 - Fc) * G_Vis;
-            B += Fc * G_Vis;
-        }
-    }
-    A /= float(SAMPLE_COUNT);
-    B /= float(SAMPLE_COUNT);
-    return vec2(A, B);
-}
-
-vec2 hammersley(uint i, uint N) { return vec2(float(i) / float(N), vanDerCorpus(i, 2u)); }
-
-vec3 importanceSampleGGX(vec2 Xi, vec3 N, float roughness)
-{
-    float a = roughness * roughness;
-
-    float phi = 2.0 * PI * Xi.x;
-    float cosTheta = sqrt((1.0 - Xi.y) / (1.0 + (a * a - 1.0) * Xi.y));
-    float sinTheta = sqrt(1.0 - cosTheta * cosTheta);
-
-    // spherical to cartesian
-    vec3 H;
-    H.x = cos(phi) * sinTheta;
-    H.y = sin(phi) * sinTheta;
-    H.z = cosTheta;
-
-    vec3 up = abs(N.z) < 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(1.0, 0.0, 0.0);
-    vec3 tangent = normalize(cross(up, N));
-    vec3 bitangent = cross(N, tangent);
-
-    vec3 sampleVec = tangent * H.x + bitangent * H.y + N * H.z;
-    return normalize(sampleVec);
-}
-
-float vanDerCorpus(uint n, uint base)
-{
-    float invBase = 1.0 / float(base);
-    float denom = 1.0;
-    float result = 0.0;
-
-    for (uint i = 0u; i < 32u; ++i)
-    {
-        if (n > 0u)
-        {
-            denom = mod(float(n), 2.0);
-            result += denom * invBase;
-            invBase = invBase / 2.0;
-            n = uint(float(n) / 2.0);
-        }
-    }
-
-    return result;
-}
\ No newline at end of file
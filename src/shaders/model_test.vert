@@ -14,11 +14,18 @@ uniform mat4 view;
 uniform mat4 projection;
 uniform mat3 invmodel;
 
+// undo Mesh vertex quantization
+uniform vec3 pos_scale = vec3(1.);
+uniform vec3 pos_offset = vec3(0.);
+uniform vec2 uv_scale = vec2(1.);
+uniform vec2 uv_offset = vec2(0.);
+
 void main()
 {
-    gl_Position = projection * view * vec4(aPos, 1.0);
-    FragPos = vec3(view * model * vec4(aPos, 1.0));
+    vec3 pos = aPos * pos_scale + pos_offset;
+    gl_Position = projection * view * vec4(pos, 1.0);
+    FragPos = vec3(view * model * vec4(pos, 1.0));
     Normal = invmodel * aNormal;
-    TexCoords = aTexCoords;
+    TexCoords = aTexCoords * uv_scale + uv_offset;
     world_norm = aNormal;
 }
\ No newline at end of file
@@ -1,12 +1,35 @@
 #version 330 core
 
-layout(location = 0) in vec3 aPos;
-layout(location = 1) in vec3 aNormal;
+// clipmap vertex: x/z around the origin, y the grid step of its level (see clipmap.hpp)
+layout(location = 0) in vec3 aPosition;
 
-uniform mat4 projection;
-uniform mat4 view;
+// per-frame constants, streamed once for every shader (FrameStd140 in scene.cpp)
+layout(std140) uniform FrameBlock
+{
+    mat4 projection;
+    mat4 view;
+    vec3 cam_pos;
+    vec2 grid_center;
+};
 uniform mat4 model;
 
+// undo Mesh vertex quantization
+uniform vec3 pos_scale = vec3(1.);
+uniform vec3 pos_offset = vec3(0.);
+
+// the clipmap follows the camera x/z in grid_center; cells per ring
+uniform float grid_ring_quads = 32.;
+
+// FFT ocean (see ocean_spectrum.hpp): displacement {dx, height, dz} tiling every spectrum_patch
+// meters, in place of the geometric waves
+uniform bool spectral = false;
+uniform sampler2D spectrum_displacement;
+uniform float spectrum_patch = 128.;
+uniform float spectrum_size = 256.;
+
+vec3 aPos;
+float lod_fade;
+
 struct Wave
 {
     vec2 wave_dirs;
@@ -17,7 +40,10 @@ struct Wave
     float chop;
 };
 #define NUM_WAVES 1
-uniform Wave[NUM_WAVES] geom_waves;
+layout(std140) uniform GeomWaveBlock
+{
+    Wave geom_waves[NUM_WAVES];
+};
 
 struct Material
 {
@@ -38,10 +64,12 @@ out float surface_elev;
 out float att_factor;
 out float particle_phase;
 out float wave_width;
+out vec2 spectrum_coords;
 
 const float PI = 3.14159265359;
 
 vec3 getNewPosition(float cur_depth);
+vec3 getSpectralPosition(float grid_step);
 vec3 getNewNormal(vec3 pos, float cur_depth);
 vec2 setFoamCoords();
 float getElevation(float x, float z);
@@ -49,10 +77,24 @@ float updateSpeed(float freq, float phase, float cur_depth);
 
 void main()
 {
+    aPos = aPosition * pos_scale + pos_offset;
+
+    // each level moves in whole steps of its own grid, so vertices stay on a fixed world lattice
+    // and do not swim as the camera moves
+    float grid_step = aPos.y;
+    aPos.xz += floor(grid_center / grid_step) * grid_step;
+
+    // fade waves out before the grid spacing, which grows about linearly with distance, passes a
+    // quarter wavelength and would alias
+    float spacing = length(aPos.xz - grid_center) / grid_ring_quads;
+    lod_fade = clamp(2. - 4. * geom_waves[0].freq * spacing / PI, 0., 1.);
+
     float cur_depth = max(0, -getElevation(aPos.x, aPos.z));
 
-    vec3 new_pos = getNewPosition(cur_depth);
-    vec3 new_norm = getNewNormal(new_pos, cur_depth);
+    // the spectrum's slopes come from its normal map in the fragment shader
+    spectrum_coords = aPos.xz / spectrum_patch;
+    vec3 new_pos = spectral ? getSpectralPosition(grid_step) : getNewPosition(cur_depth);
+    vec3 new_norm = spectral ? vec3(0, 1, 0) : getNewNormal(new_pos, cur_depth);
 
     // Debug: turn off geom waves
     // new_pos = vec3(aPos.x, 0.0, aPos.z);
@@ -109,6 +151,8 @@ vec3 getNewPosition(float cur_depth)
         particle_phase = angle;
     }
 
+    new_pos *= lod_fade;
+
     float PI_2 = PI / 2;
     float sin_width = (2 * PI / geom_waves[0].freq) *
                       abs(clamp(mod(particle_phase, 2 * PI) - PI_2, -PI_2, PI_2) / (2 * PI));
@@ -131,9 +175,33 @@ vec3 getNewPosition(float cur_depth)
     return vec3(aPos.x + new_pos.x, new_pos.y, aPos.z + new_pos.z);
 }
 
+vec3 getSpectralPosition(float grid_step)
+{
+    // the mip whose texels are about one grid step wide, so coarse levels get the waves they can
+    // hold instead of aliasing
+    float lod = max(0., log2(grid_step * spectrum_size / spectrum_patch));
+    vec3 new_pos = textureLod(spectrum_displacement, spectrum_coords, lod).xyz;
+
+    // no single breaking wave to put foam on; scatter as through a wave a few meters thick
+    particle_phase = PI;
+    wave_width = 5.;
+
+    surface_elev = getElevation(aPos.x + new_pos.x, aPos.z + new_pos.z);
+    att_factor = clamp((-surface_elev) / 1., 0, 1);
+
+    if (new_pos.y < (surface_elev + .15))
+    {
+        new_pos.y = surface_elev + 0.15;
+    }
+
+    depth = new_pos.y - surface_elev;
+
+    return vec3(aPos.x + new_pos.x, new_pos.y, aPos.z + new_pos.z);
+}
+
 vec3 getNewNormal(vec3 newPos, float cur_depth)
 {
-    vec3 new_norm = vec3(0, 1, 0);
+    vec3 slope = vec3(0, 0, 0);
 
     float tot_chop = 0.4 + clamp(2 - cur_depth, 0, 1) / 2;
 
@@ -155,14 +223,14 @@ vec3 getNewNormal(vec3 newPos, float cur_depth)
 
         float angle =
             geom_waves[i].freq * dot(geom_waves[i].wave_dirs, vec2(newPos.x, -newPos.z)) - phi;
-        new_norm.x -=
+        slope.x +=
             geom_waves[i].wave_dirs.x * geom_waves[i].freq * geom_waves[i].amplitude * cos(angle);
-        new_norm.z -=
+        slope.z +=
             -geom_waves[i].wave_dirs.y * geom_waves[i].freq * geom_waves[i].amplitude * cos(angle);
-        new_norm.y -= chop * geom_waves[i].freq * geom_waves[i].amplitude * sin(angle);
+        slope.y += chop * geom_waves[i].freq * geom_waves[i].amplitude * sin(angle);
     }
 
-    return new_norm;
+    return vec3(0, 1, 0) - lod_fade * slope;
 }
 
 vec2 setFoamCoords()
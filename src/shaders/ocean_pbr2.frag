@@ -10,7 +10,10 @@ struct Wave
     float chop;
 };
 #define NUM_TEX_WAVES 32
-uniform Wave[NUM_TEX_WAVES] tex_waves;
+layout(std140) uniform TexWaveBlock
+{
+    Wave tex_waves[NUM_TEX_WAVES];
+};
 
 struct Material
 {
@@ -29,10 +32,24 @@ struct DirLight
 };
 uniform DirLight dir_light;
 
-uniform vec3 cam_pos;
-uniform samplerCube env_map;
+// declared as in ocean.vert
+layout(std140) uniform FrameBlock
+{
+    mat4 projection;
+    mat4 view;
+    vec3 cam_pos;
+    vec2 grid_center;
+};
+
+uniform samplerCube irradiance_map;
+uniform samplerCube prefilter_map;
+uniform float prefilter_max_lod;
 uniform sampler2D brdf_map;
 
+// FFT ocean normals, replacing the texture waves (see ocean.vert)
+uniform bool spectral = false;
+uniform sampler2D spectrum_normals;
+
 in vec2 TexCoords;
 in vec2 brdf_coords;
 in vec3 Normal;
@@ -45,6 +62,7 @@ in float att_factor;
 in float surface_elev;
 in float particle_phase;
 in float wave_width;
+in vec2 spectrum_coords;
 
 const float PI = 3.14159265359;
 
@@ -165,7 +183,7 @@ vec3 skydomeLight(vec3 normal, vec3 view_dir)
     vec3 kS = fresnelSchlickRoughness(max(dot(normal, view_dir), 0.0), F0, roughness);
     vec3 kD = 1.0 - kS;
 
-    vec3 irradiance = texture(env_map, normal).rgb;
+    vec3 irradiance = texture(irradiance_map, normal).rgb;
     vec3 diffuse = irradiance * albedo;
 
     // instead of sampling/integrating - assume normal as halfway_dir....
@@ -179,7 +197,7 @@ vec3 skydomeLight(vec3 normal, vec3 view_dir)
     vec3 R = reflect(-view_dir, normal);
     vec3 V = R;
 
-    vec3 prefilteredColor = irradiance; // technically should use LOD/sampled map
+    vec3 prefilteredColor = textureLod(prefilter_map, R, roughness * prefilter_max_lod).rgb;
     vec2 brdf = texture(brdf_map, vec2(max(dot(normal, view_dir), 0.0), roughness)).rg;
     vec3 specular = prefilteredColor * (F * brdf.x + brdf.y);
 
@@ -235,6 +253,13 @@ vec3 directionalLight(DirLight light, vec3 normal, vec3 view_dir)
 
 vec3 getTexNormal()
 {
+    if (spectral)
+    {
+        // flattened in the shallows like the texture waves
+        vec3 spectrum_norm = normalize(texture(spectrum_normals, spectrum_coords).xyz);
+        return normalize(mix(vec3(0, 1, 0), spectrum_norm, att_factor));
+    }
+
     vec3 new_norm = Normal;
     for (int i = 0; i < NUM_TEX_WAVES; ++i)
     {
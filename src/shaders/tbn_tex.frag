@@ -9,9 +9,20 @@ struct Material
 };
 uniform Material material;
 
-uniform samplerCube env_map;
+uniform samplerCube irradiance_map;
+uniform samplerCube prefilter_map;
+uniform float prefilter_max_lod;
 uniform sampler2D brdf_map;
 
+// declared as in tbn_tex.vert
+layout(std140) uniform FrameBlock
+{
+    mat4 projection;
+    mat4 view;
+    vec3 cam_pos;
+    vec2 grid_center;
+};
+
 in vec2 brdf_coords;
 in vec3 frag_pos;
 in vec2 tex_coords;
@@ -46,6 +57,8 @@ void main()
     vec3 albedo = texture(material.texture_diffuse1, disp_coords).rgb;
     vec3 tex_norm = texture(material.texture_diffuse2, disp_coords).rgb;
     tex_norm = 2.0 * tex_norm - 1.0;
+    // BC5 normal maps only store x and y
+    tex_norm.z = sqrt(max(0.0, 1.0 - dot(tex_norm.xy, tex_norm.xy)));
 
     out_color += directionalLight(tan_light_dir, tex_norm, view_dir, albedo);
     out_color += skydomeLight(tex_norm, view_dir, albedo, disp_coords);
@@ -103,7 +116,7 @@ vec3 skydomeLight(vec3 normal, vec3 view_dir, vec3 albedo, vec2 uv_coords)
     vec3 kS = fresnelSchlickRoughness(max(dot(normal, view_dir), 0.0), F0, roughness);
     vec3 kD = 1.0 - kS;
 
-    vec3 irradiance = texture(env_map, world_normal).rgb;
+    vec3 irradiance = texture(irradiance_map, world_normal).rgb;
     vec3 diffuse = irradiance * albedo;
 
     // Indirect specular
@@ -111,7 +124,9 @@ vec3 skydomeLight(vec3 normal, vec3 view_dir, vec3 albedo, vec2 uv_coords)
     vec3 R = reflect(-view_dir, normal);
     vec3 V = R;
 
-    vec3 prefilteredColor = irradiance; // technically should use LOD/sampled map
+    // the cube maps are in world space, the lighting above in tangent space
+    vec3 world_R = reflect(normalize(frag_pos - cam_pos), normalize(world_normal));
+    vec3 prefilteredColor = textureLod(prefilter_map, world_R, roughness * prefilter_max_lod).rgb;
     vec2 brdf = texture(brdf_map, vec2(max(dot(normal, view_dir), 0.0), roughness)).rg;
     vec3 specular = prefilteredColor * (kS * brdf.x + brdf.y);
 
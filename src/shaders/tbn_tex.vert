@@ -5,12 +5,23 @@ layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aTexCoords;
 layout(location = 3) in vec3 aTangent;
 
+// camera of the frame, shared with the ocean shaders (see ocean.vert)
+layout(std140) uniform FrameBlock
+{
+    mat4 projection;
+    mat4 view;
+    vec3 cam_pos;
+    vec2 grid_center;
+};
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 uniform vec3 light_dir;
-uniform vec3 cam_pos;
+
+// undo Mesh vertex quantization
+uniform vec3 pos_scale = vec3(1.);
+uniform vec3 pos_offset = vec3(0.);
+uniform vec2 uv_scale = vec2(1.);
+uniform vec2 uv_offset = vec2(0.);
 
 out vec3 frag_pos;
 out vec2 tex_coords;
@@ -21,13 +32,14 @@ out vec3 tan_frag_pos;
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.);
+    vec3 pos = aPos * pos_scale + pos_offset;
+    gl_Position = projection * view * model * vec4(pos, 1.);
 
-    frag_pos = vec3(model * vec4(aPos, 1.0));
-	tex_coords = aTexCoords;
+    frag_pos = vec3(model * vec4(pos, 1.0));
+	tex_coords = aTexCoords * uv_scale + uv_offset;
 
     vec3 tangent = normalize(vec3(model * vec4(aTangent, 0.0)));
-    vec3 world_normal = normalize(vec3(model * vec4(aNormal, 0.0)));
+    world_normal = normalize(vec3(model * vec4(aNormal, 0.0)));
 
 	// G-S Re-orthogonalize
     tangent = normalize(tangent - dot(tangent, world_normal) * world_normal);
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+
+namespace msb
+{
+
+// Time source for the simulation.  A real-time clock follows glfwGetTime(); a fixed-step clock
+// advances by a constant step on every tick, so simulations can run faster than real time and
+// repeat exactly.
+class SimClock
+{
+  public:
+    static SimClock realTime() { return SimClock(0., glfwGetTime()); }
+    static SimClock fixedStep(double step, double start = 0.) { return SimClock(step, start); }
+
+    // Advance to the next frame and return the new time
+    double tick()
+    {
+        auto previous = time_;
+        time_ = step_ > 0 ? time_ + step_ : glfwGetTime();
+        delta_ = time_ - previous;
+        return time_;
+    }
+
+    double now() const { return time_; }
+
+    // The time the next tick() most likely returns: exact with a fixed step, one more frame as
+    // long as the last in real time
+    double next() const { return step_ > 0 ? time_ + step_ : time_ + delta_; }
+
+    double delta() const { return delta_; }
+    bool fixed() const { return step_ > 0; }
+
+  private:
+    double step_;
+    double time_;
+    double delta_ = 0.;
+
+    SimClock(double step, double start) : step_(step), time_(start) {}
+};
+
+} // namespace msb
@@ -0,0 +1,181 @@
+#include "tangents.hpp"
+
+#include "parallel.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cmath>
+#include <numeric>
+
+namespace msb
+{
+
+namespace
+{
+
+glm::vec3 triangleTangent(const float* v1, const float* v2, const float* v3,
+                          const TangentLayout& layout)
+{
+    auto p1 = glm::make_vec3(v1 + layout.position);
+    auto edge1 = glm::make_vec3(v2 + layout.position) - p1;
+    auto edge2 = glm::make_vec3(v3 + layout.position) - p1;
+
+    auto uv1 = glm::make_vec2(v1 + layout.uv);
+    auto delta_uv1 = glm::make_vec2(v2 + layout.uv) - uv1;
+    auto delta_uv2 = glm::make_vec2(v3 + layout.uv) - uv1;
+
+    auto det = delta_uv1.x * delta_uv2.y - delta_uv2.x * delta_uv1.y;
+    if (std::abs(det) < 1e-12f)
+    {
+        // degenerate uv mapping contributes nothing
+        return glm::vec3(0.f);
+    }
+
+    auto f = 1.0f / det;
+    return f * (delta_uv2.y * edge1 - delta_uv1.y * edge2);
+}
+
+// Gram-Schmidt against the vertex normal, falling back to any perpendicular when the summed
+// tangent vanishes
+void storeTangent(float* vertex, glm::vec3 tangent, const TangentLayout& layout)
+{
+    auto normal = glm::make_vec3(vertex + layout.normal);
+    tangent = tangent - glm::dot(normal, tangent) * normal;
+
+    if (glm::dot(tangent, tangent) < 1e-20f)
+    {
+        auto axis = std::abs(normal.x) < 0.9f ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+        tangent = glm::cross(normal, axis);
+    }
+
+    tangent = glm::normalize(tangent);
+    vertex[layout.tangent] = tangent.x;
+    vertex[layout.tangent + 1] = tangent.y;
+    vertex[layout.tangent + 2] = tangent.z;
+}
+
+} // namespace
+
+void computeTangents(float* vertices, size_t num_vertices, const TangentLayout& layout,
+                     const std::vector<unsigned int>& indices)
+{
+    auto num_triangles = indices.size() / 3;
+    auto vertex = [&](unsigned int idx) { return vertices + size_t(idx) * layout.stride; };
+
+    std::vector<glm::vec3> triangle_tangents(num_triangles);
+    parallelFor(0, num_triangles, [&](size_t first, size_t last) {
+        for (auto t = first; t < last; ++t)
+        {
+            triangle_tangents[t] = triangleTangent(vertex(indices[3 * t]),
+                                                   vertex(indices[3 * t + 1]),
+                                                   vertex(indices[3 * t + 2]), layout);
+        }
+    });
+
+    // vertex -> incident triangle table (counting sort over the index buffer)
+    std::vector<unsigned int> offsets(num_vertices + 1, 0);
+    for (auto idx : indices)
+    {
+        ++offsets[idx + 1];
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    std::vector<unsigned int> incident(indices.size());
+    std::vector<unsigned int> cursor(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        incident[cursor[indices[i]]++] = static_cast<unsigned int>(i / 3);
+    }
+
+    parallelFor(0, num_vertices, [&](size_t first, size_t last) {
+        for (auto v = first; v < last; ++v)
+        {
+            auto tangent = glm::vec3(0.f);
+            for (auto k = offsets[v]; k < offsets[v + 1]; ++k)
+            {
+                tangent += triangle_tangents[incident[k]];
+            }
+            storeTangent(vertex(static_cast<unsigned int>(v)), tangent, layout);
+        }
+    });
+}
+
+void computeGridTangents(float* vertices, size_t rows, size_t cols, const TangentLayout& layout)
+{
+    if (rows < 2 || cols < 2)
+    {
+        return;
+    }
+
+    auto vertex = [&](size_t i, size_t j) { return vertices + (i * cols + j) * layout.stride; };
+
+    // cell (i, j) holds triangles (i,j),(i+1,j),(i+1,j+1) and (i,j),(i+1,j+1),(i,j+1)
+    auto cell_cols = cols - 1;
+    std::vector<glm::vec3> cell_tangents(2 * (rows - 1) * cell_cols);
+    auto lower = [&](size_t i, size_t j) { return cell_tangents[2 * (i * cell_cols + j)]; };
+    auto upper = [&](size_t i, size_t j) { return cell_tangents[2 * (i * cell_cols + j) + 1]; };
+
+    parallelFor(0, rows - 1, [&](size_t first, size_t last) {
+        for (auto i = first; i < last; ++i)
+        {
+            for (size_t j = 0; j < cell_cols; ++j)
+            {
+                auto slot = 2 * (i * cell_cols + j);
+                cell_tangents[slot] = triangleTangent(vertex(i, j), vertex(i + 1, j),
+                                                      vertex(i + 1, j + 1), layout);
+                cell_tangents[slot + 1] = triangleTangent(vertex(i, j), vertex(i + 1, j + 1),
+                                                          vertex(i, j + 1), layout);
+            }
+        }
+    });
+
+    // each vertex touches up to six triangles in the four surrounding cells
+    parallelFor(0, rows, [&](size_t first, size_t last) {
+        for (auto i = first; i < last; ++i)
+        {
+            for (size_t j = 0; j < cols; ++j)
+            {
+                auto tangent = glm::vec3(0.f);
+                if (i < rows - 1 && j < cols - 1)
+                {
+                    tangent += lower(i, j) + upper(i, j);
+                }
+                if (i > 0 && j > 0)
+                {
+                    tangent += lower(i - 1, j - 1) + upper(i - 1, j - 1);
+                }
+                if (i > 0 && j < cols - 1)
+                {
+                    tangent += lower(i - 1, j);
+                }
+                if (i < rows - 1 && j > 0)
+                {
+                    tangent += upper(i, j - 1);
+                }
+                storeTangent(vertex(i, j), tangent, layout);
+            }
+        }
+    });
+}
+
+std::vector<float> interleaveTangentSpace(const std::vector<Vertex>& vertices)
+{
+    std::vector<float> data(vertices.size() * tbn_layout.stride, 0.f);
+
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        auto vert = data.data() + i * tbn_layout.stride;
+        vert[0] = vertices[i].position.x;
+        vert[1] = vertices[i].position.y;
+        vert[2] = vertices[i].position.z;
+        vert[3] = vertices[i].normal.x;
+        vert[4] = vertices[i].normal.y;
+        vert[5] = vertices[i].normal.z;
+        vert[6] = vertices[i].tex_coords.x;
+        vert[7] = vertices[i].tex_coords.y;
+    }
+
+    return data;
+}
+
+} // namespace msb
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "mesh.hpp"
+
+#include <vector>
+
+namespace msb
+{
+
+// Float offsets of the attributes the tangent pass reads (position, normal, uv) and writes
+// (tangent) within one interleaved vertex
+struct TangentLayout
+{
+    size_t stride;
+    size_t position;
+    size_t normal;
+    size_t uv;
+    size_t tangent;
+};
+
+// {3, 3, 2, 3} layout used by getTerrain and the tbn_tex shaders
+constexpr TangentLayout tbn_layout = {11, 0, 3, 6, 8};
+
+// Per-vertex tangents for an indexed triangle list.  Triangle tangents are computed in parallel,
+// then each vertex gathers its incident triangles through a vertex -> triangle table, so no two
+// threads write the same vertex.  Results are orthogonalized against the normal and normalized.
+void computeTangents(float* vertices, size_t num_vertices, const TangentLayout& layout,
+                     const std::vector<unsigned int>& indices);
+
+// Same result for the row-major grids built by getTerrain and getPlane (rows x cols vertices,
+// two triangles per cell), where each vertex's incident triangles are known without a table
+void computeGridTangents(float* vertices, size_t rows, size_t cols, const TangentLayout& layout);
+
+// Interleave Vertex data into tbn_layout with zeroed tangents
+std::vector<float> interleaveTangentSpace(const std::vector<Vertex>& vertices);
+
+} // namespace msb
@@ -1,6 +1,9 @@
 #include "terrain.hpp"
 
 #include "image.hpp"
+#include "parallel.hpp"
+#include "tangents.hpp"
+#include "terrain_cache.hpp"
 
 #include <cmath>
 #include <iostream>
@@ -8,17 +11,13 @@
 namespace msb
 {
 
-Geometry getPlane(double xsize, double zsize, double step, double max_depth)
+GridGeometry getPlane(double xsize, double zsize, double step, double max_depth, IndexMode mode)
 {
     double num_steps_x = std::floor(xsize / step);
     double num_steps_z = std::floor(zsize / step);
 
-    double vert_stride = 3. * 3. * 2.; // 3 position, 3 normals, 2 uvs
-    double tri_stride = 3. * 2.;       // 3 indices, 2 triangles per step
     std::vector<Vertex> vertices;
     vertices.reserve(static_cast<unsigned int>(num_steps_x * num_steps_z));
-    std::vector<unsigned int> indices;
-    indices.reserve(static_cast<unsigned int>(3. * 2. * (num_steps_x - 1) * (num_steps_z - 1)));
 
     for (size_t i = 0; i < num_steps_x; ++i)
     {
@@ -37,21 +36,18 @@ Geometry getPlane(double xsize, double zsize, double step, double max_depth)
             vert.tex_coords.y = static_cast<float>(float(i) / (num_steps_x - 1));
 
             vertices.push_back(vert);
-
-            if (i < num_steps_x - 1 && j < num_steps_z - 1)
-            {
-                indices.push_back(static_cast<unsigned int>(i * num_steps_z + j));
-                indices.push_back(static_cast<unsigned int>((i + 1) * num_steps_z + j));
-                indices.push_back(static_cast<unsigned int>((i + 1) * num_steps_z + j + 1));
-
-                indices.push_back(static_cast<unsigned int>(i * num_steps_z + j));
-                indices.push_back(static_cast<unsigned int>((i + 1) * num_steps_z + j + 1));
-                indices.push_back(static_cast<unsigned int>(i * num_steps_z + j + 1));
-            }
         }
     }
 
-    return {vertices, indices};
+    auto indices = getGridIndices(size_t(num_steps_x), size_t(num_steps_z), mode);
+
+    return {std::move(vertices), std::move(indices)};
+}
+
+Geometry getPlane(double xsize, double zsize, double step, double max_depth)
+{
+    auto [vertices, indices] = getPlane(xsize, zsize, step, max_depth, IndexMode::Triangles32);
+    return {std::move(vertices), std::move(indices.indices32)};
 }
 
 Geometry getPlane(double xsize, double zsize, double step)
@@ -86,6 +82,19 @@ Geometry getQuad(float xsize, float zsize, float ysize)
 }
 
 GeometryF getTerrain(std::string ht_file, std::string norm_file, float xsize, float zsize)
+{
+    auto [vertices, indices] = getTerrain(ht_file, norm_file, xsize, zsize, IndexMode::Triangles32);
+    return {std::move(vertices), std::move(indices.indices32)};
+}
+
+GeometryF getTerrain(PixelView ht_img, PixelView norm_img, float xsize, float zsize)
+{
+    auto [vertices, indices] = getTerrain(ht_img, norm_img, xsize, zsize, IndexMode::Triangles32);
+    return {std::move(vertices), std::move(indices.indices32)};
+}
+
+GridGeometryF getTerrain(std::string ht_file, std::string norm_file, float xsize, float zsize,
+                         IndexMode mode)
 {
     auto ht_img = Image(ht_file);
     auto norm_img = Image(norm_file);
@@ -96,112 +105,97 @@ GeometryF getTerrain(std::string ht_file, std::string norm_file, float xsize, fl
         return {{}, {}};
     }
 
-    auto stride = 3 + 3 + 2 + 3; // position, normal, tex_coord, tangent
-
-    std::vector<float> vertices;
-    vertices.reserve(ht_img.width * ht_img.height * stride);
+    return getTerrain({ht_img.data, ht_img.width, ht_img.height, ht_img.nrChannels},
+                      {norm_img.data, norm_img.width, norm_img.height, norm_img.nrChannels}, xsize,
+                      zsize, mode);
+}
 
-    std::vector<glm::vec3> positions;
-    positions.reserve(ht_img.width * ht_img.height);
+GridGeometryF getTerrain(PixelView ht_img, PixelView norm_img, float xsize, float zsize,
+                         IndexMode mode)
+{
+    const size_t stride = tbn_layout.stride; // position, normal, tex_coord, tangent
 
-    std::vector<glm::vec2> uv;
-    uv.reserve(ht_img.width * ht_img.height);
+    size_t width = ht_img.width;
+    size_t height = ht_img.height;
 
-    std::vector<unsigned int> indices;
-    indices.reserve(3 * 2 * (ht_img.width - 1) * (ht_img.height - 1));
+    // sized exactly up front; rows are filled independently straight into the final buffer
+    std::vector<float> vertices(width * height * stride);
 
-    auto num_px = ht_img.width * ht_img.height;
     auto xstep = xsize / ht_img.width;
     auto zstep = zsize / ht_img.height;
 
-    for (size_t i = 0; i < ht_img.height; ++i)
-    {
-        for (size_t j = 0; j < ht_img.width; ++j)
+    parallelFor(0, height, [&](size_t row_begin, size_t row_end) {
+        for (size_t i = row_begin; i < row_end; ++i)
         {
-            auto ht = 6 * (ht_img.data[ht_img.nrChannels * (i * ht_img.width + j)] / 255.f - 0.5f);
-
-            // position
-            auto pos = glm::vec3(xsize * float(j) / (ht_img.width - 1) + 25, ht,
-                                 zsize * -float(i) / (ht_img.height - 1));
-
-            vertices.push_back(pos.x);
-            vertices.push_back(pos.y);
-            vertices.push_back(pos.z);
-
-            positions.push_back(pos);
-
-            // normal
-            auto nx =
-                2 * (norm_img.data[norm_img.nrChannels * (i * norm_img.width + j)] / 255.) - 1;
-            auto ny =
-                2 * (norm_img.data[norm_img.nrChannels * (i * norm_img.width + j) + 1] / 255.) - 1;
-            auto nz =
-                2 * (norm_img.data[norm_img.nrChannels * (i * norm_img.width + j) + 2] / 255.) - 1;
+            auto vert = vertices.data() + i * width * stride;
 
-            // normalize and flip to y-is-up, and swap x/z
-            auto normal = glm::normalize(glm::vec3(ny / xstep, nz, -nx / zstep));
-
-            vertices.push_back(float(normal.x));
-            vertices.push_back(float(normal.y));
-            vertices.push_back(float(normal.z));
-
-            // tex_coords
-            auto uv_val =
-                glm::vec2(15.f * j / (ht_img.width - 1.f), 15.f * i / (ht_img.height - 1.f));
-
-            vertices.push_back(uv_val.x);
-            vertices.push_back(uv_val.y);
+            for (size_t j = 0; j < width; ++j, vert += stride)
+            {
+                auto ht = 6 * (ht_img.data[ht_img.channels * (i * width + j)] / 255.f - 0.5f);
+
+                // position
+                vert[0] = xsize * float(j) / (width - 1) + 25;
+                vert[1] = ht;
+                vert[2] = zsize * -float(i) / (height - 1);
+
+                // normal
+                auto norm_px = norm_img.data + norm_img.channels * (i * norm_img.width + j);
+                auto nx = 2 * (norm_px[0] / 255.) - 1;
+                auto ny = 2 * (norm_px[1] / 255.) - 1;
+                auto nz = 2 * (norm_px[2] / 255.) - 1;
+
+                // normalize and flip to y-is-up, and swap x/z
+                auto normal = glm::normalize(glm::vec3(ny / xstep, nz, -nx / zstep));
+
+                vert[3] = float(normal.x);
+                vert[4] = float(normal.y);
+                vert[5] = float(normal.z);
+
+                // tex_coords
+                vert[6] = 15.f * j / (width - 1.f);
+                vert[7] = 15.f * i / (height - 1.f);
+
+                // zero fill for tangent
+                vert[8] = 0.f;
+                vert[9] = 0.f;
+                vert[10] = 0.f;
+            }
+        }
+    });
 
-            uv.push_back(uv_val);
+    computeGridTangents(vertices.data(), height, width, tbn_layout);
 
-            // zero fill for tangent
-            vertices.push_back(0.);
-            vertices.push_back(0.);
-            vertices.push_back(0.);
+    return {std::move(vertices), getGridIndices(height, width, mode)};
+}
 
-            // triangles
-            if (i < ht_img.height - 1. && j < ht_img.width - 1.)
-            {
-                indices.push_back(static_cast<unsigned int>(i * ht_img.width + j));
-                indices.push_back(static_cast<unsigned int>((i + 1) * ht_img.width + j));
-                indices.push_back(static_cast<unsigned int>((i + 1) * ht_img.width + j + 1));
+Mesh loadTerrainMesh(const std::string& ht_file, const std::string& norm_file, float xsize,
+                     float zsize, IndexMode mode, std::vector<Texture> textures,
+                     VertexPacking packing, const std::string& cache_path)
+{
+    auto key = terrainCacheKey(ht_file, norm_file, xsize, zsize, mode, packing);
 
-                indices.push_back(static_cast<unsigned int>(i * ht_img.width + j));
-                indices.push_back(static_cast<unsigned int>((i + 1) * ht_img.width + j + 1));
-                indices.push_back(static_cast<unsigned int>(i * ht_img.width + j + 1));
-            }
+    {
+        TerrainCache cache(cache_path, key, packing);
+        if (cache.valid())
+        {
+            return Mesh(cache.vertices(), cache.layout(), cache.indices(), std::move(textures),
+                        packing);
         }
     }
 
-    // compute vertex tangents
-    for (auto i = 0; i < indices.size(); i += 3)
+    auto [vertices, indices] = getTerrain(ht_file, norm_file, xsize, zsize, mode);
+    std::vector<unsigned int> layout = {3, 3, 2, 3};
+
+    // packed once, for both the cache and the upload
+    auto packed = packVertices(vertices.data(), vertices.size(), layout,
+                               packingFormat(layout, packing));
+    if (!vertices.empty() &&
+        !writeTerrainCache(cache_path, key, packed.view(), packing, layout, indices))
     {
-        auto& p1 = positions[indices[i]];
-        auto& p2 = positions[indices[i + 1]];
-        auto& p3 = positions[indices[i + 2]];
-        auto& uv1 = uv[indices[i]];
-        auto& uv2 = uv[indices[i + 1]];
-        auto& uv3 = uv[indices[i + 2]];
-
-        auto edge1 = p2 - p1;
-        auto edge2 = p3 - p1;
-        auto delta_uv1 = uv2 - uv1;
-        auto delta_uv2 = uv3 - uv1;
-
-        auto f = 1.0f / (delta_uv1.x * delta_uv2.y - delta_uv2.x * delta_uv1.y);
-
-        glm::vec3 tangent;
-        tangent.x = f * (delta_uv2.y * edge1.x - delta_uv1.y * edge2.x);
-        tangent.y = f * (delta_uv2.y * edge1.y - delta_uv1.y * edge2.y);
-        tangent.z = f * (delta_uv2.y * edge1.z - delta_uv1.y * edge2.z);
-
-        auto offset = indices[i] * stride + 8;
-        vertices[offset] += tangent.x;
-        vertices[offset + 1] += tangent.y;
-        vertices[offset + 2] += tangent.z;
+        std::cout << "Warning: Could not write terrain cache " << cache_path << std::endl;
     }
 
-    return {vertices, indices};
+    return Mesh(packed.view(), std::move(layout), indices.view(), std::move(textures), packing);
 }
 
 } // namespace msb
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "grid.hpp"
 #include "mesh.hpp"
 
 #include <string>
@@ -10,10 +11,33 @@ namespace msb
 
 using Geometry = std::pair<std::vector<Vertex>, std::vector<unsigned int>>;
 using GeometryF = std::pair<std::vector<float>, std::vector<unsigned int>>;
+using GridGeometry = std::pair<std::vector<Vertex>, IndexData>;
+using GridGeometryF = std::pair<std::vector<float>, IndexData>;
+
+// Borrowed 8-bit pixel rows, e.g. the data of an Image
+struct PixelView
+{
+    const unsigned char* data;
+    int width;
+    int height;
+    int channels;
+};
 
 Geometry getPlane(double xsize, double zsize, double step);
 Geometry getPlane(double xsize, double zsize, double step, double max_depth);
+GridGeometry getPlane(double xsize, double zsize, double step, double max_depth, IndexMode mode);
 Geometry getQuad(float xsize, float zsize, float ysize);
-GeometryF getTerrain(std::string ht_file, std::string norm_file, float xsize, float ysize);
+GeometryF getTerrain(std::string ht_file, std::string norm_file, float xsize, float zsize);
+GeometryF getTerrain(PixelView ht_img, PixelView norm_img, float xsize, float zsize);
+GridGeometryF getTerrain(std::string ht_file, std::string norm_file, float xsize, float zsize,
+                         IndexMode mode);
+GridGeometryF getTerrain(PixelView ht_img, PixelView norm_img, float xsize, float zsize,
+                         IndexMode mode);
+
+// getTerrain through the baked cache at cache_path: a cache matching the source images and
+// parameters is mapped and uploaded directly, otherwise the terrain is built and the cache written
+Mesh loadTerrainMesh(const std::string& ht_file, const std::string& norm_file, float xsize,
+                     float zsize, IndexMode mode, std::vector<Texture> textures,
+                     VertexPacking packing, const std::string& cache_path);
 
 } // namespace msb
\ No newline at end of file
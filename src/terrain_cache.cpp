@@ -0,0 +1,180 @@
+#include "terrain_cache.hpp"
+
+#include "hash.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace msb
+{
+
+namespace
+{
+
+constexpr char cache_magic[4] = {'M', 'S', 'B', 'T'};
+
+uint64_t alignUp(uint64_t offset)
+{
+    return (offset + terrain_cache_alignment - 1) & ~uint64_t(terrain_cache_alignment - 1);
+}
+
+} // namespace
+
+uint64_t terrainCacheKey(const std::string& ht_file, const std::string& norm_file, float xsize,
+                         float zsize, IndexMode mode, VertexPacking packing)
+{
+    auto hash = fnv_offset;
+
+    for (auto& file : {ht_file, norm_file})
+    {
+        MappedFile image(file);
+        hash = fnv1a(image.data(), image.size(), hash);
+
+        // separate the two files so moving bytes between them changes the key
+        auto size = uint64_t(image.size());
+        hash = fnv1a(&size, sizeof(size), hash);
+    }
+
+    auto mode_id = static_cast<uint32_t>(mode);
+    auto packing_id = static_cast<uint32_t>(packing);
+    hash = fnv1a(&xsize, sizeof(xsize), hash);
+    hash = fnv1a(&zsize, sizeof(zsize), hash);
+    hash = fnv1a(&mode_id, sizeof(mode_id), hash);
+    hash = fnv1a(&packing_id, sizeof(packing_id), hash);
+    hash = fnv1a(&terrain_cache_version, sizeof(terrain_cache_version), hash);
+
+    return hash;
+}
+
+bool writeTerrainCache(const std::string& path, uint64_t key, const PackedVertexView& vertices,
+                       VertexPacking packing, const std::vector<unsigned int>& layout,
+                       const IndexData& indices)
+{
+    auto use16 = !indices.indices16.empty();
+    const void* index_data = use16 ? static_cast<const void*>(indices.indices16.data())
+                                   : static_cast<const void*>(indices.indices32.data());
+
+    TerrainCacheHeader header = {};
+    std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.version = terrain_cache_version;
+    header.key = key;
+    header.num_attributes = uint32_t(layout.size());
+    header.primitive = indices.primitive;
+    header.index_type = use16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    header.num_chunks = uint32_t(indices.chunks.size());
+    header.packing = static_cast<uint32_t>(packing);
+    std::memcpy(header.position_scale, &vertices.position_scale, sizeof(header.position_scale));
+    std::memcpy(header.position_offset, &vertices.position_offset, sizeof(header.position_offset));
+    std::memcpy(header.uv_scale, &vertices.uv_scale, sizeof(header.uv_scale));
+    std::memcpy(header.uv_offset, &vertices.uv_offset, sizeof(header.uv_offset));
+
+    header.layout_offset = sizeof(TerrainCacheHeader);
+    header.chunk_offset = alignUp(header.layout_offset + layout.size() * sizeof(uint32_t));
+    header.vertex_offset =
+        alignUp(header.chunk_offset + indices.chunks.size() * sizeof(CachedChunk));
+    header.vertex_bytes = vertices.bytes;
+    header.index_offset = alignUp(header.vertex_offset + header.vertex_bytes);
+    header.index_bytes = use16 ? indices.indices16.size() * sizeof(unsigned short)
+                               : indices.indices32.size() * sizeof(unsigned int);
+
+    std::vector<uint32_t> cached_layout(layout.begin(), layout.end());
+    std::vector<CachedChunk> chunks;
+    for (auto& chunk : indices.chunks)
+    {
+        chunks.push_back({chunk.first, chunk.count, chunk.base_vertex});
+    }
+
+    auto tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            return false;
+        }
+
+        auto writeAt = [&](uint64_t offset, const void* data, size_t size) {
+            static const char padding[terrain_cache_alignment] = {};
+            auto pos = uint64_t(out.tellp());
+            out.write(padding, std::streamsize(offset - pos));
+            out.write(static_cast<const char*>(data), std::streamsize(size));
+        };
+
+        writeAt(0, &header, sizeof(header));
+        writeAt(header.layout_offset, cached_layout.data(),
+                cached_layout.size() * sizeof(uint32_t));
+        writeAt(header.chunk_offset, chunks.data(), chunks.size() * sizeof(CachedChunk));
+        writeAt(header.vertex_offset, vertices.data, header.vertex_bytes);
+        writeAt(header.index_offset, index_data, header.index_bytes);
+
+        if (!out)
+        {
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tmp_path, path, error);
+    return !error;
+}
+
+TerrainCache::TerrainCache(const std::string& path, uint64_t key, VertexPacking packing)
+    : file_(path)
+{
+    auto data = file_.data();
+    auto size = file_.size();
+
+    if (data == nullptr || size < sizeof(TerrainCacheHeader))
+    {
+        return;
+    }
+
+    // the mapping is page aligned, so the header can be read in place
+    auto header = reinterpret_cast<const TerrainCacheHeader*>(data);
+    if (std::memcmp(header->magic, cache_magic, sizeof(cache_magic)) != 0 ||
+        header->version != terrain_cache_version || header->key != key ||
+        header->packing != static_cast<uint32_t>(packing))
+    {
+        return;
+    }
+
+    auto fits = [&](uint64_t offset, uint64_t bytes) {
+        return offset <= size && bytes <= size - offset;
+    };
+    if (!fits(header->layout_offset, header->num_attributes * sizeof(uint32_t)) ||
+        !fits(header->chunk_offset, header->num_chunks * sizeof(CachedChunk)) ||
+        !fits(header->vertex_offset, header->vertex_bytes) ||
+        !fits(header->index_offset, header->index_bytes))
+    {
+        return;
+    }
+
+    auto cached_layout = reinterpret_cast<const uint32_t*>(data + header->layout_offset);
+    layout_.assign(cached_layout, cached_layout + header->num_attributes);
+
+    auto chunks = reinterpret_cast<const CachedChunk*>(data + header->chunk_offset);
+    for (uint32_t i = 0; i < header->num_chunks; ++i)
+    {
+        indices_.chunks.push_back({size_t(chunks[i].first), size_t(chunks[i].count),
+                                   int(chunks[i].base_vertex)});
+    }
+
+    auto index_size =
+        header->index_type == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+
+    vertices_.data = data + header->vertex_offset;
+    vertices_.bytes = size_t(header->vertex_bytes);
+    std::memcpy(&vertices_.position_scale, header->position_scale, sizeof(header->position_scale));
+    std::memcpy(&vertices_.position_offset, header->position_offset,
+                sizeof(header->position_offset));
+    std::memcpy(&vertices_.uv_scale, header->uv_scale, sizeof(header->uv_scale));
+    std::memcpy(&vertices_.uv_offset, header->uv_offset, sizeof(header->uv_offset));
+    indices_.primitive = header->primitive;
+    indices_.type = header->index_type;
+    indices_.data = data + header->index_offset;
+    indices_.count = size_t(header->index_bytes / index_size);
+
+    valid_ = true;
+}
+
+} // namespace msb
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "mapped_file.hpp"
+#include "mesh.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace msb
+{
+
+// Baked getTerrain output: a TerrainCacheHeader followed by the layout, the index chunks and the
+// vertex and index blobs, each aligned to terrain_cache_alignment.  Vertices are stored already
+// packed for the mesh's VertexPacking, so with either packing the mapped pages go straight to
+// glBufferData.  Files are native-endian and rejected on any version, key or packing mismatch.
+constexpr uint32_t terrain_cache_version = 2;
+constexpr size_t terrain_cache_alignment = 64;
+
+struct TerrainCacheHeader
+{
+    char magic[4]; // "MSBT"
+    uint32_t version;
+    uint64_t key;
+    uint32_t num_attributes;
+    uint32_t primitive;
+    uint32_t index_type;
+    uint32_t num_chunks;
+    uint64_t layout_offset; // uint32_t components per attribute
+    uint64_t chunk_offset;  // CachedChunk per chunk
+    uint64_t vertex_offset; // packed vertices, see packingFormat
+    uint64_t vertex_bytes;
+    uint64_t index_offset; // index_type
+    uint64_t index_bytes;
+    uint32_t packing; // VertexPacking
+    float position_scale[3];
+    float position_offset[3];
+    float uv_scale[2];
+    float uv_offset[2];
+    uint32_t padding;
+};
+static_assert(sizeof(TerrainCacheHeader) == 128, "TerrainCacheHeader must not gain padding");
+
+struct CachedChunk
+{
+    uint64_t first;
+    uint64_t count;
+    int64_t base_vertex;
+};
+
+// FNV-1a over the bytes of both source images, the terrain size, the index mode, the vertex
+// packing and the format version
+uint64_t terrainCacheKey(const std::string& ht_file, const std::string& norm_file, float xsize,
+                         float zsize, IndexMode mode, VertexPacking packing);
+
+// Write through a temporary file so a crash never leaves a truncated cache behind.  vertices are
+// packed for packing.
+bool writeTerrainCache(const std::string& path, uint64_t key, const PackedVertexView& vertices,
+                       VertexPacking packing, const std::vector<unsigned int>& layout,
+                       const IndexData& indices);
+
+// Mapped cache file.  The vertex and index views point into the mapping and live as long as the
+// TerrainCache.
+class TerrainCache
+{
+  public:
+    TerrainCache(const std::string& path, uint64_t key, VertexPacking packing);
+
+    bool valid() const { return valid_; }
+
+    const PackedVertexView& vertices() const { return vertices_; }
+    const std::vector<unsigned int>& layout() const { return layout_; }
+    const IndexView& indices() const { return indices_; }
+
+  private:
+    MappedFile file_;
+    bool valid_ = false;
+
+    PackedVertexView vertices_ = {nullptr, 0};
+    std::vector<unsigned int> layout_;
+    IndexView indices_ = {GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, 0, {}};
+};
+
+} // namespace msb
@@ -0,0 +1,273 @@
+#include "texture_loader.hpp"
+
+#include <GLFW/glfw3.h>
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace msb
+{
+
+namespace
+{
+
+// mapped, so the workers never serialize on stdio
+std::unique_ptr<Image> decodeImage(const std::string& filename)
+{
+    ImageOptions options;
+    options.mapped = true;
+    return std::make_unique<Image>(filename, options);
+}
+
+} // namespace
+
+TextureLoader::TextureLoader(size_t num_threads)
+    : s3tc_(glfwExtensionSupported("GL_EXT_texture_compression_s3tc")),
+      srgb_s3tc_(s3tc_ && glfwExtensionSupported("GL_EXT_texture_sRGB")), pool_(num_threads)
+{
+    glGenBuffers(1, &pbo_);
+}
+
+TextureLoader::~TextureLoader()
+{
+    glDeleteBuffers(1, &pbo_);
+}
+
+Texture TextureLoader::load(std::string filename, std::string tex_type, unsigned int edge,
+                            unsigned int interp, unsigned int cmap)
+{
+    Texture texture(0, tex_type, filename);
+
+    glGenTextures(1, &texture.id);
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, edge);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, edge);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, interp);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, interp);
+
+    const unsigned char placeholder[4] = {128, 128, 128, 255};
+    glTexImage2D(GL_TEXTURE_2D, 0, cmap, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++pending_;
+    }
+
+    auto ktx_file = std::filesystem::path(filename).replace_extension(".ktx").string();
+    auto use_ktx = std::filesystem::exists(ktx_file);
+
+    pool_.submit([this, id = texture.id, cmap, filename, ktx_file, use_ktx] {
+        Decoded decoded = {id, cmap, filename, nullptr, nullptr};
+
+        if (use_ktx)
+        {
+            decoded.compressed = std::make_unique<CompressedTexture>();
+            if (!readKtx(ktx_file, *decoded.compressed) ||
+                !supports(decoded.compressed->internal_format))
+            {
+                decoded.compressed.reset();
+            }
+        }
+
+        if (!decoded.compressed)
+        {
+            decoded.image = decodeImage(filename);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ready_.push_back(std::move(decoded));
+        }
+        ready_cv_.notify_all();
+    });
+
+    return texture;
+}
+
+void TextureLoader::poll(size_t max_bytes)
+{
+    std::deque<Decoded> batch;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        size_t bytes = 0;
+        while (!ready_.empty() && (batch.empty() || bytes < max_bytes))
+        {
+            bytes += ready_.front().bytes();
+            batch.push_back(std::move(ready_.front()));
+            ready_.pop_front();
+        }
+    }
+
+    for (auto& decoded : batch)
+    {
+        if (decoded.compressed && !uploadCompressed(decoded))
+        {
+            // rare enough to decode right here rather than queue the image again
+            std::cout << "Compressed upload failed, decoding " << decoded.filename << std::endl;
+            decoded.compressed.reset();
+            decoded.image = decodeImage(decoded.filename);
+        }
+
+        if (!decoded.compressed)
+        {
+            upload(decoded);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_ -= batch.size();
+}
+
+void TextureLoader::finish()
+{
+    while (pending() > 0)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_cv_.wait(lock, [this] { return !ready_.empty(); });
+        }
+        poll(~size_t(0));
+    }
+}
+
+size_t TextureLoader::pending() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_;
+}
+
+size_t TextureLoader::Decoded::bytes() const
+{
+    size_t total = 0;
+    if (compressed)
+    {
+        for (auto& level : compressed->levels)
+        {
+            total += level.data.size();
+        }
+    }
+    else if (image && image->data)
+    {
+        total = size_t(image->width) * image->height * image->nrChannels;
+    }
+    return total;
+}
+
+bool TextureLoader::supports(unsigned int internal_format) const
+{
+    switch (internal_format)
+    {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        return s3tc_;
+    case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+        return srgb_s3tc_;
+    default:
+        // RGTC is core since GL 3.0
+        return true;
+    }
+}
+
+void TextureLoader::upload(const Decoded& decoded)
+{
+    auto& img = *decoded.image;
+    if (img.data == nullptr)
+    {
+        std::cout << "Failed to load texture " << decoded.filename << std::endl;
+        return;
+    }
+
+    GLenum format = GL_RED;
+    switch (img.nrChannels)
+    {
+    case 2:
+        format = GL_RG;
+        break;
+    case 3:
+        format = GL_RGB;
+        break;
+    case 4:
+        format = GL_RGBA;
+        break;
+    }
+
+    auto bytes = size_t(img.width) * img.height * img.nrChannels;
+
+    // orphan the previous upload's storage so mapping never waits for it to be consumed
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+
+    auto dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes,
+                                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (dst)
+    {
+        std::memcpy(dst, img.data, bytes);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        // rows of 3-channel images are not 4-byte aligned in general
+        glBindTexture(GL_TEXTURE_2D, decoded.id);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, decoded.cmap, img.width, img.height, 0, format,
+                     GL_UNSIGNED_BYTE, nullptr);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+bool TextureLoader::uploadCompressed(const Decoded& decoded)
+{
+    auto& texture = *decoded.compressed;
+    auto bytes = decoded.bytes();
+
+    // errors raised before this upload are not its own
+    while (glGetError() != GL_NO_ERROR)
+    {
+    }
+    auto uploaded = false;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+
+    auto dst = static_cast<unsigned char*>(glMapBufferRange(
+        GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    if (dst)
+    {
+        // every level back to back, then one glCompressedTexImage2D per level at its offset
+        size_t offset = 0;
+        for (auto& level : texture.levels)
+        {
+            std::memcpy(dst + offset, level.data.data(), level.data.size());
+            offset += level.data.size();
+        }
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        glBindTexture(GL_TEXTURE_2D, decoded.id);
+
+        offset = 0;
+        for (size_t i = 0; i < texture.levels.size(); ++i)
+        {
+            auto& level = texture.levels[i];
+            glCompressedTexImage2D(GL_TEXTURE_2D, GLint(i), texture.internal_format, level.width,
+                                   level.height, 0, GLsizei(level.data.size()),
+                                   reinterpret_cast<void*>(offset));
+            offset += level.data.size();
+        }
+        uploaded = glGetError() == GL_NO_ERROR;
+        if (uploaded)
+        {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,
+                            GLint(texture.levels.size() - 1));
+        }
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return uploaded;
+}
+
+} // namespace msb
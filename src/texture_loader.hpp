@@ -0,0 +1,83 @@
+#pragma once
+
+#include "block_compress.hpp"
+#include "image.hpp"
+#include "mesh.hpp"
+#include "parallel.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace msb
+{
+
+// Decodes image files on worker threads and uploads them on the GL thread through a pixel buffer
+// object.  load() hands back a texture at once whose id holds a 1x1 grey placeholder; poll()
+// respecifies the same texture object with the decoded image, so handles never change.
+//
+// A block-compressed <name>.ktx next to the image (see tools/compress_textures) is used instead
+// of the image, with its precomputed mip chain, when the context supports its format.  S3TC and
+// its sRGB variants are extensions to GL 3.3; without them, or if the compressed upload fails,
+// the image itself is decoded and uploaded.
+//
+// load(), poll() and finish() must be called on the GL thread.
+class TextureLoader
+{
+  public:
+    TextureLoader(size_t num_threads = std::max(1u, std::thread::hardware_concurrency()));
+    ~TextureLoader();
+
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+    // Same parameters as initTexture
+    Texture load(std::string filename, std::string tex_type, unsigned int edge,
+                 unsigned int interp, unsigned int cmap);
+
+    // Upload decoded images, stopping once max_bytes have gone out (always at least one image)
+    void poll(size_t max_bytes = size_t(64) << 20);
+
+    // Wait for every pending image and upload it
+    void finish();
+
+    size_t pending() const;
+
+  private:
+    struct Decoded
+    {
+        unsigned int id;
+        unsigned int cmap;
+        std::string filename;
+        std::unique_ptr<Image> image;
+        std::unique_ptr<CompressedTexture> compressed;
+
+        size_t bytes() const;
+    };
+
+    mutable std::mutex mutex_;
+    std::condition_variable ready_cv_;
+    std::deque<Decoded> ready_;
+    size_t pending_ = 0; // loaded but not yet uploaded
+
+    unsigned int pbo_ = 0;
+
+    // GL_EXT_texture_compression_s3tc, and GL_EXT_texture_sRGB for its sRGB formats; set before
+    // the workers start, so they may read them
+    bool s3tc_ = false;
+    bool srgb_s3tc_ = false;
+
+    // destroyed first, so queued decodes finish while the members above still exist
+    ThreadPool pool_;
+
+    bool supports(unsigned int internal_format) const;
+
+    void upload(const Decoded& decoded);
+
+    // false when the driver rejected the compressed data; the texture is left unchanged
+    bool uploadCompressed(const Decoded& decoded);
+};
+
+} // namespace msb
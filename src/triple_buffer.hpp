@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+namespace msb
+{
+
+// Lock-free hand-off of whole values from one producer thread to one consumer thread.  The
+// producer fills back() and publish()es it; the consumer fetch()es the newest published value
+// into front().  Neither side ever waits for the other: a value the consumer has not fetched yet
+// is simply replaced by the next one published.
+template <typename T> class TripleBuffer
+{
+  public:
+    TripleBuffer() = default;
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Producer side
+    T& back() { return slots_[back_]; }
+
+    void publish()
+    {
+        back_ = middle_.exchange(back_ | fresh, std::memory_order_acq_rel) & index_mask;
+    }
+
+    // Consumer side; false when nothing was published since the last fetch
+    bool fetch()
+    {
+        if ((middle_.load(std::memory_order_acquire) & fresh) == 0)
+        {
+            return false;
+        }
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & index_mask;
+        return true;
+    }
+
+    const T& front() const { return slots_[front_]; }
+
+  private:
+    // the slot between the two sides, and whether it holds a value the consumer has not seen
+    static constexpr unsigned int index_mask = 3;
+    static constexpr unsigned int fresh = 4;
+
+    std::array<T, 3> slots_;
+    unsigned int back_ = 0;
+    unsigned int front_ = 1;
+    std::atomic<unsigned int> middle_{2};
+};
+
+} // namespace msb
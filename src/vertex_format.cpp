@@ -0,0 +1,187 @@
+#include "vertex_format.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+
+namespace msb
+{
+
+namespace
+{
+
+constexpr size_t position_attribute = 0;
+constexpr size_t uv_attribute = 2;
+
+size_t attributeBytes(const VertexAttribute& attribute)
+{
+    size_t bytes = 4;
+    switch (attribute.type)
+    {
+    case GL_UNSIGNED_SHORT:
+        bytes = 2 * attribute.size;
+        break;
+    case GL_INT_2_10_10_10_REV:
+        bytes = 4;
+        break;
+    default:
+        bytes = 4 * attribute.size;
+    }
+
+    return (bytes + 3) & ~size_t(3);
+}
+
+uint32_t packSnorm10(const float* v, unsigned int size)
+{
+    uint32_t packed = 0;
+    for (unsigned int c = 0; c < std::min(size, 3u); ++c)
+    {
+        auto q = static_cast<int32_t>(std::lround(std::clamp(v[c], -1.f, 1.f) * 511.f));
+        packed |= (static_cast<uint32_t>(q) & 0x3FF) << (10 * c);
+    }
+    return packed;
+}
+
+} // namespace
+
+VertexFormat floatFormat(const std::vector<unsigned int>& layout)
+{
+    VertexFormat format;
+    for (auto size : layout)
+    {
+        format.push_back({size});
+    }
+    return format;
+}
+
+std::vector<size_t> attributeOffsets(const VertexFormat& format)
+{
+    std::vector<size_t> offsets(format.size() + 1, 0);
+    for (size_t i = 0; i < format.size(); ++i)
+    {
+        offsets[i + 1] = offsets[i] + attributeBytes(format[i]);
+    }
+    return offsets;
+}
+
+VertexFormat compactFormat(const std::vector<unsigned int>& layout)
+{
+    auto format = floatFormat(layout);
+
+    for (size_t i = 0; i < format.size() && i < 4; ++i)
+    {
+        if (i == position_attribute || i == uv_attribute)
+        {
+            format[i] = {layout[i], GL_UNSIGNED_SHORT, true};
+        }
+        else if (layout[i] == 3)
+        {
+            // packed formats always have four components; w is left at zero
+            format[i] = {4, GL_INT_2_10_10_10_REV, true};
+        }
+    }
+
+    return format;
+}
+
+VertexFormat packingFormat(const std::vector<unsigned int>& layout, VertexPacking packing)
+{
+    return packing == VertexPacking::Compact ? compactFormat(layout) : floatFormat(layout);
+}
+
+PackedVertices packVertices(const float* vertices, size_t num_floats,
+                            const std::vector<unsigned int>& layout, const VertexFormat& format)
+{
+    PackedVertices packed;
+
+    auto float_stride = std::accumulate(layout.begin(), layout.end(), size_t(0));
+    auto num_vertices = float_stride ? num_floats / float_stride : 0;
+
+    std::vector<size_t> float_offsets(layout.size(), 0);
+    for (size_t i = 1; i < layout.size(); ++i)
+    {
+        float_offsets[i] = float_offsets[i - 1] + layout[i - 1];
+    }
+
+    auto offsets = attributeOffsets(format);
+    auto stride = offsets.back();
+
+    // bounds of the 16-bit attributes map them onto [0, 1]
+    std::vector<float> lo(float_stride, 0.f);
+    std::vector<float> extent(float_stride, 1.f);
+    for (size_t i = 0; i < layout.size(); ++i)
+    {
+        if (format[i].type != GL_UNSIGNED_SHORT || num_vertices == 0)
+        {
+            continue;
+        }
+
+        for (size_t c = 0; c < layout[i]; ++c)
+        {
+            auto k = float_offsets[i] + c;
+            auto hi = vertices[k];
+            lo[k] = vertices[k];
+            for (size_t v = 1; v < num_vertices; ++v)
+            {
+                lo[k] = std::min(lo[k], vertices[v * float_stride + k]);
+                hi = std::max(hi, vertices[v * float_stride + k]);
+            }
+            extent[k] = hi > lo[k] ? hi - lo[k] : 1.f;
+        }
+    }
+
+    packed.data.assign(num_vertices * stride, 0);
+    for (size_t v = 0; v < num_vertices; ++v)
+    {
+        auto src = vertices + v * float_stride;
+        auto dst = packed.data.data() + v * stride;
+
+        for (size_t i = 0; i < layout.size(); ++i)
+        {
+            auto in = src + float_offsets[i];
+            auto out = dst + offsets[i];
+
+            switch (format[i].type)
+            {
+            case GL_UNSIGNED_SHORT:
+                for (size_t c = 0; c < layout[i]; ++c)
+                {
+                    auto k = float_offsets[i] + c;
+                    auto q = static_cast<uint16_t>(
+                        std::lround(std::clamp((in[c] - lo[k]) / extent[k], 0.f, 1.f) * 65535.f));
+                    std::memcpy(out + 2 * c, &q, sizeof(q));
+                }
+                break;
+            case GL_INT_2_10_10_10_REV:
+            {
+                auto q = packSnorm10(in, layout[i]);
+                std::memcpy(out, &q, sizeof(q));
+                break;
+            }
+            default:
+                std::memcpy(out, in, layout[i] * sizeof(float));
+            }
+        }
+    }
+
+    auto dequantize = [&](size_t i, auto& scale, auto& offset) {
+        if (i >= layout.size() || format[i].type != GL_UNSIGNED_SHORT)
+        {
+            return;
+        }
+
+        for (size_t c = 0; c < std::min<size_t>(layout[i], scale.length()); ++c)
+        {
+            scale[c] = extent[float_offsets[i] + c];
+            offset[c] = lo[float_offsets[i] + c];
+        }
+    };
+    dequantize(position_attribute, packed.position_scale, packed.position_offset);
+    dequantize(uv_attribute, packed.uv_scale, packed.uv_offset);
+
+    return packed;
+}
+
+} // namespace msb
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace msb
+{
+
+// Storage of one vertex attribute in the GPU buffer.  The CPU side always holds floats.
+struct VertexAttribute
+{
+    unsigned int size;            // components
+    unsigned int type = GL_FLOAT; // GL_FLOAT, GL_UNSIGNED_SHORT or GL_INT_2_10_10_10_REV
+    bool normalized = false;
+};
+
+using VertexFormat = std::vector<VertexAttribute>;
+
+enum class VertexPacking
+{
+    Float,
+    Compact
+};
+
+// Float attributes matching a Mesh layout
+VertexFormat floatFormat(const std::vector<unsigned int>& layout);
+
+// Compact storage for the {3, 3, 2[, 3]} position/normal/uv/tangent layouts: 16-bit normalized
+// positions and uvs relative to the mesh bounds, and 10:10:10:2 signed normalized normals and
+// tangents.  Attributes past those stay float.
+VertexFormat compactFormat(const std::vector<unsigned int>& layout);
+
+// Storage of layout for a packing
+VertexFormat packingFormat(const std::vector<unsigned int>& layout, VertexPacking packing);
+
+// Byte offset of each attribute in an interleaved vertex, followed by the stride.  Attributes
+// are padded to 4 bytes.
+std::vector<size_t> attributeOffsets(const VertexFormat& format);
+
+// Non-owning interleaved vertex bytes, e.g. pages of a mapped file, with the transforms that
+// unpack them
+struct PackedVertexView
+{
+    const void* data;
+    size_t bytes;
+    glm::vec3 position_scale = glm::vec3(1.f);
+    glm::vec3 position_offset = glm::vec3(0.f);
+    glm::vec2 uv_scale = glm::vec2(1.f);
+    glm::vec2 uv_offset = glm::vec2(0.f);
+};
+
+// Interleaved vertex bytes ready for glBufferData.  Shaders recover positions and uvs with
+// value * scale + offset.
+struct PackedVertices
+{
+    std::vector<unsigned char> data;
+    glm::vec3 position_scale = glm::vec3(1.f);
+    glm::vec3 position_offset = glm::vec3(0.f);
+    glm::vec2 uv_scale = glm::vec2(1.f);
+    glm::vec2 uv_offset = glm::vec2(0.f);
+
+    PackedVertexView view() const
+    {
+        return {data.data(), data.size(), position_scale, position_offset, uv_scale, uv_offset};
+    }
+};
+
+PackedVertices packVertices(const float* vertices, size_t num_floats,
+                            const std::vector<unsigned int>& layout, const VertexFormat& format);
+
+} // namespace msb
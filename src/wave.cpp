@@ -1,47 +1,225 @@
 #include "wave.hpp"
 
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MSB_WAVE_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace msb
 {
 
-Wave::Wave()
+namespace
+{
+
+struct WaveInstance
+{
+    float amplitude;
+    float wavelength;
+    float freq;
+    float phi;
+    float phase_offset;
+    glm::vec2 direction;
+};
+
+WaveInstance drawWaveInstance(float avg_amplitude, float avg_wavelength, glm::vec2 avg_direction,
+                              WaveRng& rng)
+{
+    //_amplitude = avg_amplitude;
+    //_direction = avg_direction;
+
+    WaveInstance wave;
+    wave.amplitude =
+        float(0.5 * avg_amplitude + rng.uniform() * (1.5 * avg_amplitude)); // amplitude variation
+    wave.wavelength = wave.amplitude * avg_wavelength / avg_amplitude;       // maintain A/L ratio
+    wave.freq = float(2. * 3.14159 / wave.wavelength);
+    wave.phi = float(std::sqrt(9.8 * 3.14159 * 2 / wave.wavelength));
+    //_phi = float(std::sqrt(9.8 * 0.5 / (3.14159 * 2)));  // hard-code water depth...
+    wave.phase_offset = rng.uniform() * 2.f * 3.14159f;
+
+    auto angle = glm::radians(5. * (2. * rng.uniform() - 1.));
+    auto rot = glm::mat2(cos(angle), -sin(angle), sin(angle), cos(angle));
+    wave.direction = glm::normalize(rot * avg_direction);
+
+    return wave;
+}
+
+// sin(x) for x in [0, pi/2], Taylor series through x^11 (error below 1e-7)
+float sinQuadrant(float x)
+{
+    auto x2 = x * x;
+    return x * (1.f + x2 * (-1.f / 6.f +
+                            x2 * (1.f / 120.f +
+                                  x2 * (-1.f / 5040.f + x2 * (1.f / 362880.f - x2 / 39916800.f)))));
+}
+
+// Fade envelope: 0.5 - 0.5 cos(pi * w) = sin^2(pi/2 * w), with w ramping 0 -> 1 over the fade-in
+// time at both ends of the wave's lifetime and 0 once it has expired
+float fadeEnvelope(float elapsed, float duration, float inv_fade_time)
+{
+    auto w = std::min(elapsed, duration - elapsed) * inv_fade_time;
+    auto s = sinQuadrant(1.5707963f * std::clamp(w, 0.f, 1.f));
+    return s * s;
+}
+
+// tot_chop of ocean.vert: waves steepen as the water shoals
+float totalChop(float depth) { return .4f + std::clamp(2.f - depth, 0.f, 1.f) * .5f; }
+
+// Wave speed factor of updateSpeed in ocean.vert, counted from its precomputed depth steps
+float speedFactor(const float* first, const float* last, float depth)
+{
+    auto factor = 1.f;
+    for (auto step = first; step != last; ++step)
+    {
+        factor += depth >= *step ? 1.f : 0.f;
+    }
+    return factor;
+}
+
+#ifdef MSB_WAVE_SSE2
+__m128 sinQuadrant(__m128 x)
+{
+    auto x2 = _mm_mul_ps(x, x);
+    auto p = _mm_sub_ps(_mm_set1_ps(1.f / 362880.f), _mm_mul_ps(x2, _mm_set1_ps(1.f / 39916800.f)));
+    p = _mm_add_ps(_mm_set1_ps(-1.f / 5040.f), _mm_mul_ps(x2, p));
+    p = _mm_add_ps(_mm_set1_ps(1.f / 120.f), _mm_mul_ps(x2, p));
+    p = _mm_add_ps(_mm_set1_ps(-1.f / 6.f), _mm_mul_ps(x2, p));
+    p = _mm_add_ps(_mm_set1_ps(1.f), _mm_mul_ps(x2, p));
+    return _mm_mul_ps(x, p);
+}
+
+__m128 fadeEnvelope(__m128 elapsed, __m128 duration, __m128 inv_fade_time)
+{
+    auto w = _mm_mul_ps(_mm_min_ps(elapsed, _mm_sub_ps(duration, elapsed)), inv_fade_time);
+    w = _mm_min_ps(_mm_max_ps(w, _mm_setzero_ps()), _mm_set1_ps(1.f));
+    auto s = sinQuadrant(_mm_mul_ps(_mm_set1_ps(1.5707963f), w));
+    return _mm_mul_ps(s, s);
+}
+
+__m128 totalChop(__m128 depth)
+{
+    auto shoal = _mm_min_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(2.f), depth), _mm_setzero_ps()),
+                            _mm_set1_ps(1.f));
+    return _mm_add_ps(_mm_set1_ps(.4f), _mm_mul_ps(shoal, _mm_set1_ps(.5f)));
+}
+
+__m128 speedFactor(const float* first, const float* last, __m128 depth)
+{
+    auto one = _mm_set1_ps(1.f);
+    auto factor = one;
+    for (auto step = first; step != last; ++step)
+    {
+        factor = _mm_add_ps(factor, _mm_and_ps(_mm_cmpge_ps(depth, _mm_set1_ps(*step)), one));
+    }
+    return factor;
+}
+
+// sin and cos for |x| up to about 1e4.  x = q * pi/2 + r with pi/2 split in three parts so that
+// q times the leading part is exact, then minimax polynomials on [-pi/4, pi/4] (as in Cephes)
+// swapped and negated by quadrant.
+void sinCos(__m128 x, __m128& sin_x, __m128& cos_x)
 {
-    resetWave();
+    auto q = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(0.63661977f)));
+    auto qf = _mm_cvtepi32_ps(q);
+    auto r = _mm_sub_ps(x, _mm_mul_ps(qf, _mm_set1_ps(1.5703125f)));
+    r = _mm_sub_ps(r, _mm_mul_ps(qf, _mm_set1_ps(4.837512969970703125e-4f)));
+    r = _mm_sub_ps(r, _mm_mul_ps(qf, _mm_set1_ps(7.54978995489188216e-8f)));
+    auto r2 = _mm_mul_ps(r, r);
+
+    auto s = _mm_add_ps(_mm_set1_ps(8.3321608736e-3f),
+                        _mm_mul_ps(r2, _mm_set1_ps(-1.9515295891e-4f)));
+    s = _mm_add_ps(_mm_set1_ps(-1.6666654611e-1f), _mm_mul_ps(r2, s));
+    s = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2), s));
+
+    auto c = _mm_add_ps(_mm_set1_ps(-1.388731625493765e-3f),
+                        _mm_mul_ps(r2, _mm_set1_ps(2.443315711809948e-5f)));
+    c = _mm_add_ps(_mm_set1_ps(4.166664568298827e-2f), _mm_mul_ps(r2, c));
+    c = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.f), _mm_mul_ps(_mm_set1_ps(.5f), r2)),
+                   _mm_mul_ps(_mm_mul_ps(r2, r2), c));
+
+    // odd quadrants swap sin and cos; sin is negative in quadrants 2 and 3, cos in 1 and 2
+    auto one = _mm_set1_epi32(1);
+    auto two = _mm_set1_epi32(2);
+    auto swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, one), one));
+    auto sin_sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, two), 30));
+    auto cos_sign =
+        _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, one), two), 30));
+    sin_x = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s)), sin_sign);
+    cos_x = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c)), cos_sign);
+}
+#endif
+
+} // namespace
+
+WaveRng::WaveRng(uint64_t seed)
+{
+    // splitmix64 expands the seed so nearby seeds give unrelated streams
+    for (size_t i = 0; i < 4; i += 2)
+    {
+        auto z = (seed += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        z = z ^ (z >> 31);
+        state_[i] = uint32_t(z);
+        state_[i + 1] = uint32_t(z >> 32);
+    }
+}
+
+uint32_t WaveRng::next()
+{
+    auto rotl = [](uint32_t x, int k) { return (x << k) | (x >> (32 - k)); };
+
+    auto result = rotl(state_[0] + state_[3], 7) + state_[0];
+    auto t = state_[1] << 9;
+
+    state_[2] ^= state_[0];
+    state_[3] ^= state_[1];
+    state_[1] ^= state_[2];
+    state_[0] ^= state_[3];
+    state_[2] ^= t;
+    state_[3] = rotl(state_[3], 11);
+
+    return result;
+}
+
+Wave::Wave(WaveRng& rng, double t) : _att_offset(0)
+{
+    resetWave(rng, t);
     _reset_time = _reset_time - _att_offset * duration;
     _start_time = _reset_time;
 }
 
-Wave::Wave(float amp, float wl, float chop, float dur, glm::vec2 dir, double att_offset)
+Wave::Wave(float amp, float wl, float chop, float dur, glm::vec2 dir, double att_offset,
+           WaveRng& rng, double t)
     : avg_amplitude(amp), avg_wavelength(wl), chop(chop), duration(dur), avg_direction(dir),
       _att_offset(att_offset)
 {
-    resetWave();
+    resetWave(rng, t);
     _reset_time = _reset_time - _att_offset * duration;
     _start_time = _reset_time;
 }
 
-void Wave::resetWave()
+void Wave::resetWave(WaveRng& rng, double t)
 {
-    //_amplitude = avg_amplitude;
-    //_direction = avg_direction;
+    auto wave = drawWaveInstance(avg_amplitude, avg_wavelength, avg_direction, rng);
 
-    _amplitude = float(0.5 * avg_amplitude + (float(std::rand()) / float(RAND_MAX)) *
-                                                 (1.5 * avg_amplitude)); // 10% amplitude variation
-    _wavelength = _amplitude * avg_wavelength / avg_amplitude;           // maintain A/L ratio
-    _freq = float(2. * 3.14159 / _wavelength);
-    _phi = float(std::sqrt(9.8 * 3.14159 * 2 / _wavelength));
-    //_phi = float(std::sqrt(9.8 * 0.5 / (3.14159 * 2)));  // hard-code water depth...
-    _phase_offset = (float(std::rand()) / RAND_MAX) * 2.f * 3.14159f;
+    _amplitude = wave.amplitude;
+    _wavelength = wave.wavelength;
+    _freq = wave.freq;
+    _phi = wave.phi;
+    _phase_offset = wave.phase_offset;
+    _direction = wave.direction;
 
-    auto angle = glm::radians(5. * (2. * (float(std::rand()) / RAND_MAX) - 1.));
-    auto rot = glm::mat2(cos(angle), -sin(angle), sin(angle), cos(angle));
-    _direction = glm::normalize(rot * avg_direction);
-
-    _reset_time = glfwGetTime();
+    _reset_time = t;
 }
 
-float Wave::amplitude()
+float Wave::amplitude(double t)
 {
-    auto t = glfwGetTime();
     auto global_elapsed = t - _start_time;
     auto instance_elapsed = t - _reset_time;
 
@@ -64,58 +242,481 @@ float Wave::amplitude()
     return _amplitude * float(0.5 - 0.5 * std::cos(3.14159 * instance_elapsed / _fade_in_time));
 }
 
-void initWaves(Shader& shader, std::vector<Wave>& waves, std::string var_name, float total_chop)
+WaveBank::WaveBank(const std::vector<Wave>& waves, uint64_t seed) : rng_(seed)
 {
-    for (size_t i = 0; i < waves.size(); ++i)
+    auto num_waves = waves.size();
+
+    avg_amplitude_.reserve(num_waves);
+    avg_wavelength_.reserve(num_waves);
+    avg_direction_.reserve(num_waves);
+    duration_.reserve(num_waves);
+    amplitude_.reserve(num_waves);
+    wavelength_.reserve(num_waves);
+    freq_.reserve(num_waves);
+    phi_.reserve(num_waves);
+    phase_offset_.reserve(num_waves);
+    dir_x_.reserve(num_waves);
+    dir_y_.reserve(num_waves);
+    reset_time_.reserve(num_waves);
+
+    for (auto& wave : waves)
     {
-        std::string idx = "[" + std::to_string(i) + "]";
+        avg_amplitude_.push_back(wave.avg_amplitude);
+        avg_wavelength_.push_back(wave.avg_wavelength);
+        avg_direction_.push_back(wave.avg_direction);
+        duration_.push_back(wave.duration);
+        amplitude_.push_back(wave._amplitude);
+        wavelength_.push_back(wave._wavelength);
+        freq_.push_back(wave._freq);
+        phi_.push_back(wave._phi);
+        phase_offset_.push_back(wave._phase_offset);
+        dir_x_.push_back(wave._direction.x);
+        dir_y_.push_back(wave._direction.y);
+        reset_time_.push_back(wave._reset_time);
+    }
 
-        // auto chop = 1 / (waves[i].freq() * waves[i].amplitude() * waves.size());
-        // chop = std::min(waves[i].chop, chop);
+    elapsed_.resize(num_waves);
+    current_amplitude_.resize(num_waves);
+    phase_.resize(num_waves);
+}
+
+void WaveBank::resetWave(size_t i, double t)
+{
+    auto wave =
+        drawWaveInstance(avg_amplitude_[i], avg_wavelength_[i], avg_direction_[i], rng_);
+
+    amplitude_[i] = wave.amplitude;
+    wavelength_[i] = wave.wavelength;
+    freq_[i] = wave.freq;
+    phi_[i] = wave.phi;
+    phase_offset_[i] = wave.phase_offset;
+    dir_x_[i] = wave.direction.x;
+    dir_y_[i] = wave.direction.y;
+    reset_time_[i] = t;
+}
+
+void WaveBank::evaluate(size_t begin, size_t end)
+{
+    auto inv_fade_time = 1.f / fade_in_time_;
+    auto i = begin;
+
+#ifdef MSB_WAVE_SSE2
+    auto inv_fade = _mm_set1_ps(inv_fade_time);
+    for (; i + 4 <= end; i += 4)
+    {
+        auto elapsed = _mm_loadu_ps(&elapsed_[i]);
+        auto envelope = fadeEnvelope(elapsed, _mm_loadu_ps(&duration_[i]), inv_fade);
+        _mm_storeu_ps(&current_amplitude_[i], _mm_mul_ps(_mm_loadu_ps(&amplitude_[i]), envelope));
+
+        auto phase = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&phi_[i]), elapsed),
+                                _mm_loadu_ps(&phase_offset_[i]));
+        _mm_storeu_ps(&phase_[i], phase);
+    }
+#endif
+
+    for (; i < end; ++i)
+    {
+        current_amplitude_[i] =
+            amplitude_[i] * fadeEnvelope(elapsed_[i], duration_[i], inv_fade_time);
+        phase_[i] = phi_[i] * elapsed_[i] + phase_offset_[i];
+    }
+}
+
+void WaveBank::update(double t)
+{
+    auto num_waves = size();
+
+    for (size_t i = 0; i < num_waves; ++i)
+    {
+        elapsed_[i] = float(t - reset_time_[i]);
+    }
 
-        auto chop = total_chop / (waves[i].freq() * waves[i].amplitude() * waves.size());
+    evaluate(0, num_waves);
 
-        shader.setVec2(var_name + idx + ".wave_dirs", waves[i].direction());
-        shader.setFloat(var_name + idx + ".freq", waves[i].freq());
-        shader.setFloat(var_name + idx + ".phase", waves[i].phase());
-        shader.setFloat(var_name + idx + ".phase_offset", waves[i].phase_offset());
-        shader.setFloat(var_name + idx + ".amplitude", waves[i].amplitude());
-        shader.setFloat(var_name + idx + ".chop", chop);
+    // expired waves are rare; redraw them and re-evaluate their lane
+    for (size_t i = 0; i < num_waves; ++i)
+    {
+        if (elapsed_[i] >= duration_[i])
+        {
+            resetWave(i, t);
+            elapsed_[i] = 0.f;
+            evaluate(i, i + 1);
+        }
+    }
+}
+
+void WaveSurface::resize(size_t count)
+{
+    for (auto channel : {&dx, &dy, &dz, &nx, &ny, &nz, &vx, &vy, &vz})
+    {
+        channel->resize(count);
+    }
+}
+
+void WaveField::set(const WaveBank& bank)
+{
+    auto num_waves = bank.size();
+    for (auto channel : {&kx_, &kz_, &base_phase_, &phase_offset_, &base_rate_, &amplitude_,
+                         &slope_x_, &slope_z_, &chop_x_, &chop_z_, &chop_y_})
+    {
+        channel->resize(num_waves);
+    }
+    steps_first_.resize(num_waves);
+    steps_last_.resize(num_waves);
+    depth_steps_.clear();
+
+    auto inv_count = 1.f / float(std::max<size_t>(1, num_waves));
+
+    for (size_t i = 0; i < num_waves; ++i)
+    {
+        auto freq = bank.freqs()[i];
+        auto amplitude = bank.amplitudes()[i];
+        auto dir_x = bank.dir_x()[i];
+        auto dir_y = bank.dir_y()[i];
+        auto offset = bank.phase_offsets()[i];
+
+        // the shaders take the direction against -z
+        kx_[i] = freq * dir_x;
+        kz_[i] = -freq * dir_y;
+        base_phase_[i] = (bank.phases()[i] - offset) / std::sqrt(freq * 9.8f);
+        base_rate_[i] = bank.phase_rates()[i] / std::sqrt(freq * 9.8f);
+        phase_offset_[i] = offset;
+
+        // per-wave chop is tot_chop / (freq * amplitude * NUM_WAVES), so the amplitude cancels
+        // out of the displacement; the shader divides by zero for a silent wave instead
+        auto live = amplitude > 0 ? inv_count : 0.f;
+        amplitude_[i] = amplitude;
+        slope_x_[i] = dir_x * freq * amplitude;
+        slope_z_[i] = -dir_y * freq * amplitude;
+        chop_x_[i] = live * dir_x / freq;
+        chop_z_[i] = -live * dir_y / freq;
+        chop_y_[i] = live;
+
+        // max(1, floor(sqrt(9.8 freq tanh(freq depth)))) reaches k once
+        // tanh(freq depth) >= k^2 / (9.8 freq)
+        steps_first_[i] = depth_steps_.size();
+        for (auto k = 2; float(k * k) < 9.8f * freq; ++k)
+        {
+            depth_steps_.push_back(float(std::atanh(k * k / (9.8 * freq)) / freq));
+        }
+        steps_last_[i] = depth_steps_.size();
     }
 }
 
-void updateWaves(Shader& shader, std::vector<Wave>& waves, std::string var_name, float total_chop)
+void WaveField::displace(const float* x, const float* z, const float* depth, size_t begin,
+                         size_t end, WaveSurface& surface, Jacobian* jacobian) const
 {
-    for (size_t i = 0; i < waves.size(); ++i)
+    auto num_waves = size();
+    auto deep = std::numeric_limits<float>::infinity();
+    auto i = begin;
+
+#ifdef MSB_WAVE_SSE2
+    for (; i + 4 <= end; i += 4)
     {
-        std::string idx = "[" + std::to_string(i) + "]";
+        auto px = _mm_loadu_ps(x + i);
+        auto pz = _mm_loadu_ps(z + i);
+        auto d = depth ? _mm_loadu_ps(depth + i) : _mm_set1_ps(deep);
+
+        auto dx = _mm_setzero_ps();
+        auto dy = _mm_setzero_ps();
+        auto dz = _mm_setzero_ps();
+        auto vx = _mm_setzero_ps();
+        auto vy = _mm_setzero_ps();
+        auto vz = _mm_setzero_ps();
+        auto jxx = _mm_setzero_ps();
+        auto jxz = _mm_setzero_ps();
+        auto jzx = _mm_setzero_ps();
+        auto jzz = _mm_setzero_ps();
+
+        for (size_t w = 0; w < num_waves; ++w)
+        {
+            auto factor = speedFactor(depth_steps_.data() + steps_first_[w],
+                                      depth_steps_.data() + steps_last_[w], d);
+            auto phase = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(base_phase_[w]), factor),
+                                    _mm_set1_ps(phase_offset_[w]));
+            auto angle = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(kx_[w]), px),
+                                               _mm_mul_ps(_mm_set1_ps(kz_[w]), pz)),
+                                    phase);
+            __m128 s, c;
+            sinCos(angle, s, c);
+
+            auto chop_x = _mm_set1_ps(chop_x_[w]);
+            auto chop_z = _mm_set1_ps(chop_z_[w]);
+            auto amplitude = _mm_set1_ps(amplitude_[w]);
+            dx = _mm_add_ps(dx, _mm_mul_ps(chop_x, c));
+            dz = _mm_add_ps(dz, _mm_mul_ps(chop_z, c));
+            dy = _mm_add_ps(dy, _mm_mul_ps(amplitude, s));
+
+            // the angle falls at rate * factor
+            auto rate = _mm_mul_ps(_mm_set1_ps(base_rate_[w]), factor);
+            auto rate_s = _mm_mul_ps(rate, s);
+            vx = _mm_add_ps(vx, _mm_mul_ps(chop_x, rate_s));
+            vz = _mm_add_ps(vz, _mm_mul_ps(chop_z, rate_s));
+            vy = _mm_sub_ps(vy, _mm_mul_ps(amplitude, _mm_mul_ps(rate, c)));
+
+            if (jacobian)
+            {
+                auto kx = _mm_set1_ps(kx_[w]);
+                auto kz = _mm_set1_ps(kz_[w]);
+                auto sx = _mm_mul_ps(chop_x, s);
+                auto sz = _mm_mul_ps(chop_z, s);
+                jxx = _mm_sub_ps(jxx, _mm_mul_ps(sx, kx));
+                jxz = _mm_sub_ps(jxz, _mm_mul_ps(sx, kz));
+                jzx = _mm_sub_ps(jzx, _mm_mul_ps(sz, kx));
+                jzz = _mm_sub_ps(jzz, _mm_mul_ps(sz, kz));
+            }
+        }
+
+        auto chop = totalChop(d);
+        _mm_storeu_ps(&surface.dx[i], _mm_mul_ps(chop, dx));
+        _mm_storeu_ps(&surface.dy[i], dy);
+        _mm_storeu_ps(&surface.dz[i], _mm_mul_ps(chop, dz));
+        _mm_storeu_ps(&surface.vx[i], _mm_mul_ps(chop, vx));
+        _mm_storeu_ps(&surface.vy[i], vy);
+        _mm_storeu_ps(&surface.vz[i], _mm_mul_ps(chop, vz));
 
-        auto amplitude = waves[i].amplitude();
+        if (jacobian)
+        {
+            _mm_storeu_ps(&jacobian->xx[i], _mm_mul_ps(chop, jxx));
+            _mm_storeu_ps(&jacobian->xz[i], _mm_mul_ps(chop, jxz));
+            _mm_storeu_ps(&jacobian->zx[i], _mm_mul_ps(chop, jzx));
+            _mm_storeu_ps(&jacobian->zz[i], _mm_mul_ps(chop, jzz));
+        }
+    }
+#endif
+
+    for (; i < end; ++i)
+    {
+        auto d = depth ? depth[i] : deep;
+        float dx = 0.f, dy = 0.f, dz = 0.f;
+        float vx = 0.f, vy = 0.f, vz = 0.f;
+        float jxx = 0.f, jxz = 0.f, jzx = 0.f, jzz = 0.f;
 
-        if (!amplitude)
+        for (size_t w = 0; w < num_waves; ++w)
         {
-            waves[i].resetWave();
-            amplitude = waves[i].amplitude();
-            shader.setVec2(var_name + idx + ".wave_dirs", waves[i].direction());
-            shader.setFloat(var_name + idx + ".freq", waves[i].freq());
+            auto factor = speedFactor(depth_steps_.data() + steps_first_[w],
+                                      depth_steps_.data() + steps_last_[w], d);
+            auto angle =
+                kx_[w] * x[i] + kz_[w] * z[i] - (base_phase_[w] * factor + phase_offset_[w]);
+            auto s = std::sin(angle);
+            auto c = std::cos(angle);
+
+            dx += chop_x_[w] * c;
+            dz += chop_z_[w] * c;
+            dy += amplitude_[w] * s;
+
+            auto rate = base_rate_[w] * factor;
+            vx += chop_x_[w] * rate * s;
+            vz += chop_z_[w] * rate * s;
+            vy -= amplitude_[w] * rate * c;
+
+            jxx -= chop_x_[w] * s * kx_[w];
+            jxz -= chop_x_[w] * s * kz_[w];
+            jzx -= chop_z_[w] * s * kx_[w];
+            jzz -= chop_z_[w] * s * kz_[w];
         }
 
+        auto chop = totalChop(d);
+        surface.dx[i] = chop * dx;
+        surface.dy[i] = dy;
+        surface.dz[i] = chop * dz;
+        surface.vx[i] = chop * vx;
+        surface.vy[i] = vy;
+        surface.vz[i] = chop * vz;
+
+        if (jacobian)
+        {
+            jacobian->xx[i] = chop * jxx;
+            jacobian->xz[i] = chop * jxz;
+            jacobian->zx[i] = chop * jzx;
+            jacobian->zz[i] = chop * jzz;
+        }
+    }
+}
+
+void WaveField::normals(const float* x, const float* z, const float* depth, size_t begin,
+                        size_t end, WaveSurface& surface) const
+{
+    auto num_waves = size();
+    auto deep = std::numeric_limits<float>::infinity();
+    auto i = begin;
+
+#ifdef MSB_WAVE_SSE2
+    for (; i + 4 <= end; i += 4)
+    {
+        auto px = _mm_add_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(&surface.dx[i]));
+        auto pz = _mm_add_ps(_mm_loadu_ps(z + i), _mm_loadu_ps(&surface.dz[i]));
+        auto d = depth ? _mm_loadu_ps(depth + i) : _mm_set1_ps(deep);
+
+        auto sx = _mm_setzero_ps();
+        auto sy = _mm_setzero_ps();
+        auto sz = _mm_setzero_ps();
+
+        for (size_t w = 0; w < num_waves; ++w)
+        {
+            auto factor = speedFactor(depth_steps_.data() + steps_first_[w],
+                                      depth_steps_.data() + steps_last_[w], d);
+            auto phase = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(base_phase_[w]), factor),
+                                    _mm_set1_ps(phase_offset_[w]));
+            auto angle = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(kx_[w]), px),
+                                               _mm_mul_ps(_mm_set1_ps(kz_[w]), pz)),
+                                    phase);
+            __m128 s, c;
+            sinCos(angle, s, c);
+
+            sx = _mm_add_ps(sx, _mm_mul_ps(_mm_set1_ps(slope_x_[w]), c));
+            sz = _mm_add_ps(sz, _mm_mul_ps(_mm_set1_ps(slope_z_[w]), c));
+            sy = _mm_add_ps(sy, _mm_mul_ps(_mm_set1_ps(chop_y_[w]), s));
+        }
+
+        // (0, 1, 0) - slope, normalized
+        auto nx = _mm_sub_ps(_mm_setzero_ps(), sx);
+        auto ny = _mm_sub_ps(_mm_set1_ps(1.f), _mm_mul_ps(totalChop(d), sy));
+        auto nz = _mm_sub_ps(_mm_setzero_ps(), sz);
+        auto length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)),
+                                             _mm_mul_ps(nz, nz)));
+        _mm_storeu_ps(&surface.nx[i], _mm_div_ps(nx, length));
+        _mm_storeu_ps(&surface.ny[i], _mm_div_ps(ny, length));
+        _mm_storeu_ps(&surface.nz[i], _mm_div_ps(nz, length));
+    }
+#endif
+
+    for (; i < end; ++i)
+    {
+        auto px = x[i] + surface.dx[i];
+        auto pz = z[i] + surface.dz[i];
+        auto d = depth ? depth[i] : deep;
+        float sx = 0.f, sy = 0.f, sz = 0.f;
+
+        for (size_t w = 0; w < num_waves; ++w)
+        {
+            auto factor = speedFactor(depth_steps_.data() + steps_first_[w],
+                                      depth_steps_.data() + steps_last_[w], d);
+            auto angle = kx_[w] * px + kz_[w] * pz - (base_phase_[w] * factor + phase_offset_[w]);
+
+            sx += slope_x_[w] * std::cos(angle);
+            sz += slope_z_[w] * std::cos(angle);
+            sy += chop_y_[w] * std::sin(angle);
+        }
+
+        auto normal = glm::normalize(glm::vec3(-sx, 1.f - totalChop(d) * sy, -sz));
+        surface.nx[i] = normal.x;
+        surface.ny[i] = normal.y;
+        surface.nz[i] = normal.z;
+    }
+}
+
+void WaveField::evaluate(const WavePoints& points, WaveSurface& surface) const
+{
+    surface.resize(points.size());
+    auto depth = points.depth.empty() ? nullptr : points.depth.data();
+
+    parallelFor(
+        0, points.size(),
+        [&](size_t first, size_t last) {
+            displace(points.x.data(), points.z.data(), depth, first, last, surface, nullptr);
+            normals(points.x.data(), points.z.data(), depth, first, last, surface);
+        },
+        2048);
+}
+
+void WaveField::heights(const WavePoints& points, WaveSurface& surface, HeightScratch& scratch,
+                        int iterations) const
+{
+    auto count = points.size();
+    surface.resize(count);
+    auto depth = points.depth.empty() ? nullptr : points.depth.data();
+
+    // rest positions, starting from the queries themselves
+    auto& rest_x = scratch.rest_x;
+    auto& rest_z = scratch.rest_z;
+    rest_x.assign(points.x.begin(), points.x.end());
+    rest_z.assign(points.z.begin(), points.z.end());
+    auto& jacobian = scratch.jacobian;
+    for (auto channel : {&jacobian.xx, &jacobian.xz, &jacobian.zx, &jacobian.zz})
+    {
+        channel->resize(count);
+    }
+
+    parallelFor(
+        0, count,
+        [&](size_t first, size_t last) {
+            for (auto iteration = 0; iteration < iterations; ++iteration)
+            {
+                displace(rest_x.data(), rest_z.data(), depth, first, last, surface, &jacobian);
+
+                // solve (I + J) step = query - (rest + displacement); the total chop stays
+                // below 1, which keeps I + J well away from singular
+                for (auto i = first; i < last; ++i)
+                {
+                    auto rx = points.x[i] - rest_x[i] - surface.dx[i];
+                    auto rz = points.z[i] - rest_z[i] - surface.dz[i];
+                    auto a = 1.f + jacobian.xx[i];
+                    auto b = jacobian.xz[i];
+                    auto c = jacobian.zx[i];
+                    auto d = 1.f + jacobian.zz[i];
+                    auto inv_det = 1.f / (a * d - b * c);
+                    rest_x[i] += (d * rx - b * rz) * inv_det;
+                    rest_z[i] += (a * rz - c * rx) * inv_det;
+                }
+            }
+
+            displace(rest_x.data(), rest_z.data(), depth, first, last, surface, nullptr);
+            normals(rest_x.data(), rest_z.data(), depth, first, last, surface);
+        },
+        2048);
+}
+
+WaveBlock::WaveBlock(std::string block_name, size_t num_waves, unsigned int binding)
+    : block_name_(block_name), num_waves_(num_waves), binding_(binding)
+{
+}
+
+void WaveBlock::attach(const Shader& shader) const
+{
+    auto index = glGetUniformBlockIndex(shader.id, block_name_.c_str());
+    if (index == GL_INVALID_INDEX)
+    {
+        std::cout << "Uniform block " << block_name_ << " is not active" << std::endl;
+        return;
+    }
+
+    int block_size = 0;
+    glGetActiveUniformBlockiv(shader.id, index, GL_UNIFORM_BLOCK_DATA_SIZE, &block_size);
+    if (size_t(block_size) > num_waves_ * sizeof(WaveStd140))
+    {
+        std::cout << "Uniform block " << block_name_ << " holds more waves than its buffer"
+                  << std::endl;
+    }
+
+    glUniformBlockBinding(shader.id, index, binding_);
+}
+
+void WaveBlock::pack(const WaveBank& bank, float total_chop, std::vector<WaveStd140>& packed)
+{
+    packed.resize(bank.size());
+
+    for (size_t i = 0; i < bank.size(); ++i)
+    {
+        auto amplitude = bank.amplitudes()[i];
+
         // auto chop = 1 / (waves[i].freq() * waves[i].amplitude() * waves.size());
         // chop = std::min(waves[i].chop, chop);
 
-        auto chop = total_chop / (waves[i].freq() * waves[i].amplitude() * waves.size());
-
-        shader.setFloat(var_name + idx + ".amplitude", amplitude);
-        shader.setFloat(var_name + idx + ".phase", waves[i].phase());
-        shader.setFloat(var_name + idx + ".phase_offset", waves[i].phase_offset());
-        shader.setFloat(var_name + idx + ".chop", chop);
+        auto& wave = packed[i];
+        wave.wave_dirs = glm::vec2(bank.dir_x()[i], bank.dir_y()[i]);
+        wave.freq = bank.freqs()[i];
+        wave.phase = bank.phases()[i];
+        wave.phase_offset = bank.phase_offsets()[i];
+        wave.amplitude = amplitude;
+        wave.chop = amplitude > 0 ? total_chop / (wave.freq * amplitude * bank.size()) : 0.f;
     }
 }
 
-std::vector<Wave> makeGeomWaves()
+std::vector<Wave> makeGeomWaves(WaveRng& rng, double t)
 {
     std::vector<Wave> waves;
-    waves.push_back(Wave(1., 35., 8, 1000., {1, 0.5}, 0.1));
+    waves.push_back(Wave(1., 35., 8, 1000., {1, 0.5}, 0.1, rng, t));
 
     // waves.push_back(Wave(.5f, 35., 16., 100., { 1,0 }, 0.));
     // waves.push_back(Wave(.2f, 30., 2., 100., { 1,.25 }, 0.25));
@@ -125,7 +726,7 @@ std::vector<Wave> makeGeomWaves()
     return waves;
 }
 
-std::vector<Wave> makeTexWaves(size_t num_waves)
+std::vector<Wave> makeTexWaves(size_t num_waves, WaveRng& rng, double t)
 {
     std::vector<Wave> tx_waves;
 
@@ -145,12 +746,13 @@ std::vector<Wave> makeTexWaves(size_t num_waves)
     {
         // auto lambda = i * .1 + .3;
         // auto lambda = i * i * .05 + 0.3;
-        auto r1 = (2 * float(std::rand()) / float(RAND_MAX) - 1.0) * .5;
-        auto r2 = (2 * float(std::rand()) / float(RAND_MAX) - 1.0) * .5;
-        auto r3 = (2 * float(std::rand()) / float(RAND_MAX) - 1.0) * 3;
-        // auto amp = float(std::rand()) / float(RAND_MAX) * 0.02 + .01;
-        auto lambda = float(std::rand()) / float(RAND_MAX) * 6.f + 0.3f;
-        tx_waves.push_back(Wave(.005 * lambda, lambda, 0, 1600., {1 + r1, 0.5 + r2}, 1 / 16.));
+        auto r1 = (2 * rng.uniform() - 1.0) * .5;
+        auto r2 = (2 * rng.uniform() - 1.0) * .5;
+        auto r3 = (2 * rng.uniform() - 1.0) * 3;
+        // auto amp = rng.uniform() * 0.02 + .01;
+        auto lambda = rng.uniform() * 6.f + 0.3f;
+        tx_waves.push_back(
+            Wave(.005 * lambda, lambda, 0, 1600., {1 + r1, 0.5 + r2}, 1 / 16., rng, t));
         // tx_waves.push_back(Wave(amp, lambda, r3, 1600., { 1 + r1, 0.5+r2 }, 1 / 16.));
     }
 
@@ -3,10 +3,10 @@
 #include "shader.hpp"
 
 #include <GLAD/glad.h>
-#include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <tuple>
@@ -15,6 +15,23 @@
 namespace msb
 {
 
+// xoshiro128++ generator seeded through splitmix64.  Float draws are derived from the raw bits
+// here rather than through <random> distributions, so a seed gives the same waves on every
+// standard library.
+class WaveRng
+{
+  public:
+    explicit WaveRng(uint64_t seed);
+
+    uint32_t next();
+
+    // uniform in [0, 1)
+    float uniform() { return float(next() >> 8) * (1.f / 16777216.f); }
+
+  private:
+    uint32_t state_[4];
+};
+
 class Wave
 {
   private:
@@ -36,21 +53,200 @@ class Wave
     float duration = 5;
     glm::vec2 avg_direction = {1, 1};
 
-    Wave();
-    Wave(float amp, float wl, float chop, float dur, glm::vec2 dir, double att_offset);
+    Wave(WaveRng& rng, double t);
+    Wave(float amp, float wl, float chop, float dur, glm::vec2 dir, double att_offset,
+         WaveRng& rng, double t);
 
-    void resetWave();
-    float amplitude();
+    // Draw a new instance around the average parameters, starting at time t
+    void resetWave(WaveRng& rng, double t);
+    float amplitude(double t);
     float wavelength() { return _wavelength; }
     float freq() { return _freq; }
-    float phase() { return float(_phi * (glfwGetTime() - _reset_time)) + _phase_offset; }
+    float phase(double t) { return float(_phi * (t - _reset_time)) + _phase_offset; }
     float phase_offset() { return _phase_offset; }
     glm::vec2 direction() { return _direction; }
+
+    friend class WaveBank;
+};
+
+// Structure-of-arrays state for a set of waves.  update() takes one clock sample and evaluates the
+// fade envelope and phase of every wave in a single vectorized pass, redrawing expired waves from
+// the bank's own seeded generator.
+class WaveBank
+{
+  public:
+    WaveBank(const std::vector<Wave>& waves, uint64_t seed);
+
+    void update(double t);
+
+    size_t size() const { return amplitude_.size(); }
+
+    // evaluated at the last update()
+    const std::vector<float>& amplitudes() const { return current_amplitude_; }
+    const std::vector<float>& phases() const { return phase_; }
+
+    const std::vector<float>& freqs() const { return freq_; }
+    const std::vector<float>& phase_rates() const { return phi_; } // d phase / dt
+    const std::vector<float>& phase_offsets() const { return phase_offset_; }
+    const std::vector<float>& dir_x() const { return dir_x_; }
+    const std::vector<float>& dir_y() const { return dir_y_; }
+
+  private:
+    // per-wave averages that new instances are drawn around
+    std::vector<float> avg_amplitude_;
+    std::vector<float> avg_wavelength_;
+    std::vector<glm::vec2> avg_direction_;
+    std::vector<float> duration_;
+
+    // current instance
+    std::vector<float> amplitude_;
+    std::vector<float> wavelength_;
+    std::vector<float> freq_;
+    std::vector<float> phi_;
+    std::vector<float> phase_offset_;
+    std::vector<float> dir_x_;
+    std::vector<float> dir_y_;
+    std::vector<double> reset_time_;
+
+    // outputs
+    std::vector<float> elapsed_;
+    std::vector<float> current_amplitude_;
+    std::vector<float> phase_;
+
+    float fade_in_time_ = 5; // seconds
+    WaveRng rng_;
+
+    void resetWave(size_t i, double t);
+    void evaluate(size_t begin, size_t end);
+};
+
+// Query points as structure of arrays.  depth is the still-water depth under each point, as
+// ocean.vert reads it from the bathymetry; leave it empty for deep water, otherwise give one per
+// point.
+struct WavePoints
+{
+    std::vector<float> x;
+    std::vector<float> z;
+    std::vector<float> depth;
+
+    size_t size() const { return x.size(); }
+};
+
+// Per point: displacement of the surface from its rest position, the unit normal and the
+// velocity of the water there
+struct WaveSurface
+{
+    std::vector<float> dx, dy, dz;
+    std::vector<float> nx, ny, nz;
+    std::vector<float> vx, vy, vz;
+
+    void resize(size_t count);
+};
+
+// CPU copy of the geometric wave surface of ocean.vert (getNewPosition / getNewNormal) for a
+// bank at its last update(), so physics and gameplay can query the water without a GPU
+// readback.  Points are evaluated four at a time with SSE2 and large batches are split across
+// threads.
+//
+// Not modelled: the clamp that keeps the surface above the terrain near the shore, the distance
+// fade of the clipmap and the texture waves that only perturb normals in ocean_pbr2.frag.
+class WaveField
+{
+  public:
+    WaveField() = default;
+    explicit WaveField(const WaveBank& bank) { set(bank); }
+
+    // d(dx, dz) / d(x, z) at the rest positions, for the Newton steps of heights()
+    struct Jacobian
+    {
+        std::vector<float> xx, xz, zx, zz;
+    };
+
+    // Working memory of heights(), kept by the caller so repeated queries do not allocate
+    struct HeightScratch
+    {
+        std::vector<float> rest_x, rest_z;
+        Jacobian jacobian;
+    };
+
+    // Take the amplitudes and phases of an updated bank
+    void set(const WaveBank& bank);
+
+    // Displacement, normal and velocity of the surface point resting at each (x, z).  The
+    // velocity leaves out the slow fade of the amplitudes.
+    void evaluate(const WavePoints& points, WaveSurface& surface) const;
+
+    // Surface over each (x, z) in world space.  Gerstner waves move points sideways, so the rest
+    // position under each query is found by Newton iteration before evaluating there;
+    // surface.dy is then the water height.  The depth of each query is used for its rest point.
+    void heights(const WavePoints& points, WaveSurface& surface, HeightScratch& scratch,
+                 int iterations = 5) const;
+
+    size_t size() const { return amplitude_.size(); }
+
+  private:
+    // angle = kx * x + kz * z - phase, the phase scaled by a depth-dependent speed factor
+    std::vector<float> kx_, kz_;
+    std::vector<float> base_phase_, phase_offset_;
+    std::vector<float> base_rate_; // d base_phase / dt
+    std::vector<float> amplitude_;
+    std::vector<float> slope_x_, slope_z_; // direction * freq * amplitude
+    // horizontal displacement and vertical slope per unit of the depth-dependent total chop,
+    // zero for silent waves
+    std::vector<float> chop_x_, chop_z_, chop_y_;
+
+    // the speed factor steps up by one at each of these depths; [first, last) per wave
+    std::vector<float> depth_steps_;
+    std::vector<size_t> steps_first_, steps_last_;
+
+    // Displacement and velocity of the points resting at (x[i], z[i]) for i in [begin, end), and
+    // the Jacobian of the displacement when one is given
+    void displace(const float* x, const float* z, const float* depth, size_t begin, size_t end,
+                  WaveSurface& surface, Jacobian* jacobian) const;
+
+    // Normals of the same points once displaced, taken at the displaced position as ocean.vert
+    // does; needs the displacement in surface
+    void normals(const float* x, const float* z, const float* depth, size_t begin, size_t end,
+                 WaveSurface& surface) const;
+};
+
+// std140 layout of the `Wave` struct in the ocean shaders, array stride of 32 bytes
+struct WaveStd140
+{
+    glm::vec2 wave_dirs;
+    float freq;
+    float phase;
+    float phase_offset;
+    float amplitude;
+    float chop;
+    float padding;
+};
+static_assert(sizeof(WaveStd140) == 32, "WaveStd140 must match the std140 array stride");
+
+// Binding point of a `Wave` array declared in a std140 uniform block.  The packed waves are
+// streamed into a uniform buffer range every frame (see StreamBuffer); the block is limited by
+// GL_MAX_UNIFORM_BLOCK_SIZE (at least 16KB, i.e. 512 waves).
+class WaveBlock
+{
+  public:
+    WaveBlock(std::string block_name, size_t num_waves, unsigned int binding);
+
+    // Bind the shader's uniform block to this block's binding point
+    void attach(const Shader& shader) const;
+
+    // Pack every wave of an updated bank in block layout; needs no GL context
+    static void pack(const WaveBank& bank, float total_chop, std::vector<WaveStd140>& packed);
+
+    unsigned int binding() const { return binding_; }
+    size_t size() const { return num_waves_; }
+
+  private:
+    std::string block_name_;
+    size_t num_waves_;
+    unsigned int binding_;
 };
 
-void initWaves(Shader& shader, std::vector<Wave>& waves, std::string var_name, float total_chop);
-void updateWaves(Shader& shader, std::vector<Wave>& waves, std::string var_name, float total_chop);
-std::vector<Wave> makeGeomWaves();
-std::vector<Wave> makeTexWaves(size_t num_waves);
+std::vector<Wave> makeGeomWaves(WaveRng& rng, double t);
+std::vector<Wave> makeTexWaves(size_t num_waves, WaveRng& rng, double t);
 
 } // namespace msb
\ No newline at end of file
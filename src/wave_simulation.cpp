@@ -0,0 +1,64 @@
+#include "wave_simulation.hpp"
+
+#include <algorithm>
+
+namespace msb
+{
+
+WaveSimulation::WaveSimulation(double start_time, OceanMode mode)
+    : rng_(1), geom_waves_(makeGeomWaves(rng_, start_time), 2),
+      tex_waves_(makeTexWaves(32, rng_, start_time), 3), last_request_(start_time)
+{
+    if (mode == OceanMode::Spectral)
+    {
+        spectrum_.emplace(spectrum_settings_);
+    }
+}
+
+void WaveSimulation::request(double t)
+{
+    last_request_ = std::max(t, last_request_);
+    auto sequence = ++requested_;
+    thread_.submit([this, t = last_request_, sequence] { simulate(t, sequence); });
+}
+
+const WaveFrame& WaveSimulation::acquire()
+{
+    // normally already published while the previous frame was drawn
+    {
+        std::unique_lock<std::mutex> lock(published_mutex_);
+        published_.wait(lock, [this] {
+            return frames_.front().sequence >= requested_ ||
+                   (frames_.fetch() && frames_.front().sequence >= requested_);
+        });
+    }
+    acquired_ = requested_;
+    return frames_.front();
+}
+
+void WaveSimulation::simulate(double t, uint64_t sequence)
+{
+    auto& frame = frames_.back();
+    frame.t = t;
+    frame.sequence = sequence;
+
+    geom_waves_.update(t);
+    tex_waves_.update(t);
+    WaveBlock::pack(geom_waves_, geom_chop_, frame.geom_waves);
+    WaveBlock::pack(tex_waves_, tex_chop_, frame.tex_waves);
+
+    if (spectrum_)
+    {
+        spectrum_->evaluate(t, frame.displacement, frame.normals);
+    }
+
+    frames_.publish();
+
+    // taking the lock orders the publish before a waiter's next check
+    {
+        std::lock_guard<std::mutex> lock(published_mutex_);
+    }
+    published_.notify_one();
+}
+
+} // namespace msb
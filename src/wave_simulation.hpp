@@ -0,0 +1,98 @@
+#pragma once
+
+#include "ocean_spectrum.hpp"
+#include "parallel.hpp"
+#include "triple_buffer.hpp"
+#include "wave.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace msb
+{
+
+// Gerstner sums a few geometric waves plus normal-only texture waves, with shoaling and breaker
+// foam; Spectral draws a wind sea from an FFT ocean spectrum instead
+enum class OceanMode
+{
+    Gerstner,
+    Spectral
+};
+
+// Everything the GL thread uploads to draw the waves at one time
+struct WaveFrame
+{
+    double t = 0.;
+    uint64_t sequence = 0; // the request that produced it
+
+    // std140 payloads of GeomWaveBlock and TexWaveBlock; both blocks stay live in spectral mode,
+    // where the clipmap still takes its LOD fade from the first geometric wave
+    std::vector<WaveStd140> geom_waves;
+    std::vector<WaveStd140> tex_waves;
+
+    // displacement and normal maps, OceanMode::Spectral
+    std::vector<float> displacement;
+    std::vector<float> normals;
+};
+
+// The CPU side of the waves on a thread of its own.  The GL thread request()s the time of the
+// frame after the one it is about to draw, then acquire()s the state it asked for one frame
+// earlier; the two frames overlap, so the simulation costs the GL thread nothing as long as it
+// is faster than a frame.  Finished frames cross over through a TripleBuffer.
+//
+// Frames are produced in request order and each request is simulated exactly once, so a fixed
+// sequence of requests always yields the same frames.
+class WaveSimulation
+{
+  public:
+    WaveSimulation(double start_time, OceanMode mode);
+
+    WaveSimulation(const WaveSimulation&) = delete;
+    WaveSimulation& operator=(const WaveSimulation&) = delete;
+
+    // Start simulating time t; times before an earlier request are raised to it, as the waves
+    // only run forward
+    void request(double t);
+
+    // Wait for the frame of the last request.  It stays valid until the next acquire().
+    const WaveFrame& acquire();
+
+    // no request since the last acquire()
+    bool idle() const { return requested_ == acquired_; }
+
+    OceanMode mode() const { return spectrum_ ? OceanMode::Spectral : OceanMode::Gerstner; }
+    size_t geomWaves() const { return geom_waves_.size(); }
+    size_t texWaves() const { return tex_waves_.size(); }
+    const SpectrumSettings& spectrumSettings() const { return spectrum_settings_; }
+
+  private:
+    // simulation thread state
+    WaveRng rng_;
+    WaveBank geom_waves_;
+    WaveBank tex_waves_;
+    float geom_chop_ = 0.5f;
+    float tex_chop_ = 0.0f;
+    SpectrumSettings spectrum_settings_;
+    std::optional<OceanSpectrum> spectrum_;
+
+    TripleBuffer<WaveFrame> frames_;
+
+    // notified after each publish; acquire() sleeps on it instead of spinning
+    std::mutex published_mutex_;
+    std::condition_variable published_;
+
+    // GL thread state
+    uint64_t requested_ = 0;
+    uint64_t acquired_ = 0;
+    double last_request_ = 0.;
+
+    // destroyed first, so a frame in flight finishes while the members above still exist
+    ThreadPool thread_{1};
+
+    void simulate(double t, uint64_t sequence);
+};
+
+} // namespace msb
@@ -1,5 +1,7 @@
 #include "window_management.hpp"
 
+#include "shader.hpp"
+
 #include <iostream>
 
 namespace msb
@@ -125,6 +127,9 @@ GLFWwindow* initializeWindow()
         exit(-1);
     }
 
+    // a new context starts with no program bound
+    Shader::resetBoundProgram();
+
     glViewport(0, 0, 800, 600);
 
     glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
@@ -134,4 +139,59 @@ GLFWwindow* initializeWindow()
     return window;
 }
 
-} // namespace msb
\ No newline at end of file
+GLFWwindow* initializeHeadless(int width, int height)
+{
+    auto create = [&](int context_api) {
+        glfwDefaultWindowHints();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, context_api);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        return glfwCreateWindow(width, height, "beach", NULL, NULL);
+    };
+
+    GLFWwindow* window = NULL;
+    if (glfwInit())
+    {
+        window = create(GLFW_NATIVE_CONTEXT_API);
+    }
+
+#ifdef GLFW_PLATFORM_NULL
+    if (window == NULL)
+    {
+        glfwTerminate();
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+        if (glfwInit())
+        {
+            window = create(GLFW_EGL_CONTEXT_API);
+            if (window == NULL)
+            {
+                window = create(GLFW_OSMESA_CONTEXT_API);
+            }
+        }
+    }
+#endif
+
+    if (window == NULL)
+    {
+        std::cout << "Failed to create a headless GL context" << std::endl;
+        glfwTerminate();
+        return NULL;
+    }
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        glfwTerminate();
+        return NULL;
+    }
+
+    // a new context starts with no program bound
+    Shader::resetBoundProgram();
+
+    return window;
+}
+
+} // namespace msb
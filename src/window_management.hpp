@@ -9,6 +9,11 @@ namespace msb
 {
 
 GLFWwindow* initializeWindow();
+
+// Invisible 3.3 core context for offscreen rendering.  Without a display, GLFW 3.4's null
+// platform is tried with an EGL context and then OSMesa, so Mesa's llvmpipe can render on nodes
+// with no GPU.  Returns nullptr if every option fails.
+GLFWwindow* initializeHeadless(int width, int height);
 void processInput(CameraState& state);
 
 } // namespace msb
\ No newline at end of file
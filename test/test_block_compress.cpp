@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include "block_compress.cpp"
+
+#include <cstdio>
+
+namespace
+{
+
+double blockRmse(const unsigned char* a, const unsigned char* b, int stride, int channels)
+{
+    double sum = 0.;
+    for (int i = 0; i < 16; ++i)
+    {
+        for (int c = 0; c < channels; ++c)
+        {
+            double d = a[stride * i + c] - b[stride * i + c];
+            sum += d * d;
+        }
+    }
+    return std::sqrt(sum / (16. * channels));
+}
+
+} // namespace
+
+TEST(BlockCompressTest, BC1GradientRoundTrip)
+{
+    unsigned char rgba[64];
+    for (int i = 0; i < 16; ++i)
+    {
+        rgba[4 * i] = static_cast<unsigned char>(40 + 10 * i);
+        rgba[4 * i + 1] = static_cast<unsigned char>(200 - 8 * i);
+        rgba[4 * i + 2] = static_cast<unsigned char>(90 + 3 * i);
+        rgba[4 * i + 3] = 255;
+    }
+
+    unsigned char block[8];
+    unsigned char decoded[64];
+    msb::encodeBlockBC1(rgba, block);
+    msb::decodeBlockBC1(block, decoded);
+
+    // sixteen ramp steps through four palette entries bottom out near 8
+    EXPECT_LT(blockRmse(rgba, decoded, 4, 3), 10.);
+    for (int i = 0; i < 16; ++i)
+    {
+        EXPECT_EQ(decoded[4 * i + 3], 255);
+    }
+}
+
+TEST(BlockCompressTest, BC1SolidColor)
+{
+    unsigned char rgba[64];
+    for (int i = 0; i < 16; ++i)
+    {
+        rgba[4 * i] = 255;
+        rgba[4 * i + 1] = 0;
+        rgba[4 * i + 2] = 132;
+        rgba[4 * i + 3] = 255;
+    }
+
+    unsigned char block[8];
+    unsigned char decoded[64];
+    msb::encodeBlockBC1(rgba, block);
+    msb::decodeBlockBC1(block, decoded);
+
+    // within 565 quantization
+    EXPECT_LT(blockRmse(rgba, decoded, 4, 3), 4.);
+}
+
+TEST(BlockCompressTest, BC4GradientRoundTrip)
+{
+    unsigned char values[16];
+    for (int i = 0; i < 16; ++i)
+    {
+        values[i] = static_cast<unsigned char>(17 * i);
+    }
+
+    unsigned char block[8];
+    unsigned char decoded[16];
+    msb::encodeBlockBC4(values, block);
+    msb::decodeBlockBC4(block, decoded);
+
+    for (int i = 0; i < 16; ++i)
+    {
+        // half a palette step of 255 / 7
+        EXPECT_LE(std::abs(values[i] - decoded[i]), 19);
+    }
+}
+
+TEST(BlockCompressTest, MipChainAndKtxRoundTrip)
+{
+    int width = 10;
+    int height = 6;
+    std::vector<unsigned char> rgba(4 * width * height);
+    for (size_t i = 0; i < rgba.size(); ++i)
+    {
+        rgba[i] = static_cast<unsigned char>(i * 37);
+    }
+
+    auto texture = msb::compressTexture(rgba.data(), width, height, msb::BlockFormat::BC5, false);
+    ASSERT_EQ(texture.levels.size(), 4u); // 10x6, 5x3, 2x1, 1x1
+    EXPECT_EQ(texture.internal_format, unsigned(GL_COMPRESSED_RG_RGTC2));
+    EXPECT_EQ(texture.levels[0].data.size(), 3u * 2 * 16);
+    EXPECT_EQ(texture.levels[3].width, 1);
+    EXPECT_EQ(texture.levels[3].data.size(), 16u);
+
+    auto path = std::string("test_texture.ktx");
+    ASSERT_TRUE(msb::writeKtx(path, texture));
+
+    msb::CompressedTexture loaded;
+    ASSERT_TRUE(msb::readKtx(path, loaded));
+    EXPECT_EQ(loaded.internal_format, texture.internal_format);
+    ASSERT_EQ(loaded.levels.size(), texture.levels.size());
+    for (size_t i = 0; i < loaded.levels.size(); ++i)
+    {
+        EXPECT_EQ(loaded.levels[i].width, texture.levels[i].width);
+        EXPECT_EQ(loaded.levels[i].height, texture.levels[i].height);
+        EXPECT_EQ(loaded.levels[i].data, texture.levels[i].data);
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST(BlockCompressTest, NormalMipsStayUnit)
+{
+    // two opposing tilts average to straight up
+    std::vector<unsigned char> rgba = {218, 128, 218, 255, 38, 128, 218, 255};
+    auto mips = msb::buildMipChain(rgba.data(), 2, 1, false, true);
+
+    ASSERT_EQ(mips.size(), 2u);
+    EXPECT_NEAR(mips[1].pixels[0], 128, 1);
+    EXPECT_NEAR(mips[1].pixels[1], 128, 1);
+    EXPECT_EQ(mips[1].pixels[2], 255);
+}
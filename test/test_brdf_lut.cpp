@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+
+#include "brdf_lut.cpp"
+
+#include <array>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+
+using Vec3 = std::array<float, 3>;
+
+float dot(const Vec3& a, const Vec3& b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+Vec3 cross(const Vec3& a, const Vec3& b)
+{
+    return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+}
+
+Vec3 normalize(const Vec3& a)
+{
+    auto len = std::sqrt(dot(a, a));
+    return {a[0] / len, a[1] / len, a[2] / len};
+}
+
+float vanDerCorpus(unsigned n)
+{
+    float inv_base = 0.5f;
+    float result = 0.f;
+    while (n > 0u)
+    {
+        result += float(n % 2u) * inv_base;
+        inv_base /= 2.f;
+        n /= 2u;
+    }
+    return result;
+}
+
+float geometryIbl(float n_dot_v, float roughness)
+{
+    auto k = roughness * roughness / 2.f;
+    return n_dot_v / (n_dot_v * (1.f - k) + k);
+}
+
+// Reference integration the way the old GPU pass did it, full tangent frame included
+std::array<float, 2> shaderIntegrateBrdf(float n_dot_v, float roughness, unsigned samples)
+{
+    Vec3 v = {std::sqrt(1.f - n_dot_v * n_dot_v), 0.f, n_dot_v};
+    Vec3 n = {0.f, 0.f, 1.f};
+
+    float a = 0.f;
+    float b = 0.f;
+    for (unsigned i = 0; i < samples; ++i)
+    {
+        auto alpha = roughness * roughness;
+        auto phi = 2.f * 3.14159265359f * float(i) / float(samples);
+        auto xi = vanDerCorpus(i);
+        auto cos_theta = std::sqrt((1.f - xi) / (1.f + (alpha * alpha - 1.f) * xi));
+        auto sin_theta = std::sqrt(1.f - cos_theta * cos_theta);
+        Vec3 h_local = {std::cos(phi) * sin_theta, std::sin(phi) * sin_theta, cos_theta};
+
+        Vec3 up = std::abs(n[2]) < 0.999f ? Vec3{0.f, 0.f, 1.f} : Vec3{1.f, 0.f, 0.f};
+        auto tangent = normalize(cross(up, n));
+        auto bitangent = cross(n, tangent);
+        Vec3 h;
+        for (int c = 0; c < 3; ++c)
+        {
+            h[c] = tangent[c] * h_local[0] + bitangent[c] * h_local[1] + n[c] * h_local[2];
+        }
+        h = normalize(h);
+
+        auto v_dot_h_raw = dot(v, h);
+        auto l = normalize({2.f * v_dot_h_raw * h[0] - v[0], 2.f * v_dot_h_raw * h[1] - v[1],
+                            2.f * v_dot_h_raw * h[2] - v[2]});
+
+        auto n_dot_l = std::max(l[2], 0.f);
+        auto n_dot_h = std::max(h[2], 0.f);
+        auto v_dot_h = std::max(v_dot_h_raw, 0.f);
+        if (n_dot_l > 0.f)
+        {
+            auto g = geometryIbl(n_dot_v, roughness) * geometryIbl(n_dot_l, roughness);
+            auto g_vis = g * v_dot_h / (n_dot_h * n_dot_v);
+            auto fc = std::pow(1.f - v_dot_h, 5.f);
+            a += (1.f - fc) * g_vis;
+            b += fc * g_vis;
+        }
+    }
+    return {a / float(samples), b / float(samples)};
+}
+
+} // namespace
+
+TEST(BrdfLutTest, SmoothSurfaceIsSchlick)
+{
+    // at zero roughness every half vector is the normal, so the integral is exactly Schlick's
+    // (1 - Fc, Fc) with Fc = (1 - NdotV)^5
+    for (auto n_dot_v : {0.1f, 0.4f, 0.75f, 1.f})
+    {
+        auto fc = std::pow(1.f - n_dot_v, 5.f);
+        auto ab = msb::integrateBrdf(n_dot_v, 0.f, 64);
+        EXPECT_NEAR(ab.x, 1.f - fc, 1e-5f);
+        EXPECT_NEAR(ab.y, fc, 1e-5f);
+    }
+}
+
+TEST(BrdfLutTest, MatchesShader)
+{
+    for (auto roughness : {0.1f, 0.5f, 0.9f})
+    {
+        for (auto n_dot_v : {0.05f, 0.5f, 0.95f})
+        {
+            auto ab = msb::integrateBrdf(n_dot_v, roughness, 256);
+            auto ref = shaderIntegrateBrdf(n_dot_v, roughness, 256);
+            EXPECT_NEAR(ab.x, ref[0], 1e-4f);
+            EXPECT_NEAR(ab.y, ref[1], 1e-4f);
+        }
+    }
+
+    // energy is lost, never gained, as roughness grows
+    auto prev = 1.f;
+    for (auto roughness : {0.f, 0.25f, 0.5f, 0.75f, 1.f})
+    {
+        auto ab = msb::integrateBrdf(0.5f, roughness);
+        EXPECT_LE(ab.x + ab.y, prev + 1e-4f);
+        prev = ab.x + ab.y;
+    }
+}
+
+TEST(BrdfLutTest, TableMatchesTexels)
+{
+    int size = 16;
+    auto lut = msb::computeBrdfLut(size, 128);
+    ASSERT_EQ(lut.size(), size_t(size * size * 2));
+
+    for (int row : {0, 7, 15})
+    {
+        for (int col : {0, 9, 15})
+        {
+            auto ab = msb::integrateBrdf((col + .5f) / size, (row + .5f) / size, 128);
+            EXPECT_FLOAT_EQ(lut[2 * (row * size + col)], ab.x);
+            EXPECT_FLOAT_EQ(lut[2 * (row * size + col) + 1], ab.y);
+        }
+    }
+}
+
+TEST(BrdfLutTest, FileRoundTrip)
+{
+    auto lut = msb::computeBrdfLut(8, 32);
+    auto path = std::string("test_brdf.lut");
+    ASSERT_TRUE(msb::writeBrdfLut(path, 8, 32, lut));
+
+    int size = 0;
+    std::vector<float> loaded;
+    ASSERT_TRUE(msb::readBrdfLut(path, size, loaded));
+    EXPECT_EQ(size, 8);
+    EXPECT_EQ(loaded, lut);
+
+    EXPECT_FALSE(msb::writeBrdfLut(path, 9, 32, lut));
+    EXPECT_FALSE(msb::readBrdfLut("missing.lut", size, loaded));
+
+    std::remove(path.c_str());
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include "buoyancy.cpp"
+
+#include <vector>
+
+TEST(BathymetryTest, SamplesLikeTexture)
+{
+    // 2 x 2 texels, rows along +v; elevations -3, 0, 1.2, 3
+    std::vector<unsigned char> pixels = {0, 0, 127, 0, 178, 0, 255, 0};
+    msb::Bathymetry bathymetry(msb::PixelView{pixels.data(), 2, 2, 2});
+
+    auto elevation = [](unsigned char value) { return (value / 255.f - .5f) * 6.f; };
+
+    // texel centers at u, v = 1/4 and 3/4, i.e. x = 37.5 and 62.5, z = -12.5 and -37.5
+    EXPECT_NEAR(bathymetry.elevation(37.5f, -12.5f), -3.f, 1e-5);
+    EXPECT_NEAR(bathymetry.elevation(62.5f, -12.5f), elevation(127), 1e-5);
+    EXPECT_NEAR(bathymetry.elevation(37.5f, -37.5f), elevation(178), 1e-5);
+    EXPECT_NEAR(bathymetry.elevation(50.f, -25.f),
+                (elevation(0) + elevation(127) + elevation(178) + elevation(255)) / 4, 1e-5);
+
+    // clamped past the edges
+    EXPECT_NEAR(bathymetry.elevation(-100.f, 100.f), -3.f, 1e-5);
+    EXPECT_NEAR(bathymetry.elevation(500.f, -500.f), 3.f, 1e-5);
+    EXPECT_FLOAT_EQ(bathymetry.depth(500.f, -500.f), 0.f);
+    EXPECT_NEAR(bathymetry.depth(37.5f, -12.5f), 3.f, 1e-5);
+
+    // nothing loaded is deep water
+    EXPECT_GT(msb::Bathymetry().depth(0.f, 0.f), 1e30f);
+}
+
+TEST(BuoyancyTest, GridMatchesWaveField)
+{
+    msb::WaveRng rng(5);
+    msb::WaveBank bank(msb::makeGeomWaves(rng, 0.), 6);
+    bank.update(30.);
+
+    msb::BuoyancyQueries queries{msb::Bathymetry()};
+    queries.update(bank, {{0.f, 0.f, 4.f}, {20.3f, -7.1f, 1.f}});
+
+    msb::WaveField field(bank);
+    msb::WaveField::HeightScratch scratch;
+    for (size_t body = 0; body < 2; ++body)
+    {
+        msb::WavePoints points;
+        for (auto i = 0; i < 200; ++i)
+        {
+            auto center = body == 0 ? 0.f : 20.3f;
+            points.x.push_back(center + 8.f * rng.uniform() - 4.f);
+            points.z.push_back((body == 0 ? 0.f : -7.1f) + 8.f * rng.uniform() - 4.f);
+        }
+
+        msb::WaveSurface exact;
+        field.heights(points, exact, scratch);
+        msb::WaterSamples samples;
+        queries.sample(body, points.x, points.z, samples);
+
+        // well inside body 0's grid; body 1's is smaller than the spread, so only check its core
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            if (body == 1 && (std::abs(points.x[i] - 20.3f) > 1.5f ||
+                              std::abs(points.z[i] + 7.1f) > 1.5f))
+            {
+                continue;
+            }
+            EXPECT_NEAR(samples.height[i], exact.dy[i], 1e-2);
+            EXPECT_NEAR(samples.ny[i], exact.ny[i], 1e-2);
+            EXPECT_NEAR(samples.vx[i], exact.vx[i], 1e-2);
+            EXPECT_NEAR(samples.vy[i], exact.vy[i], 1e-2);
+        }
+    }
+
+    // 4 m plus a 1 m margin each side at 50 cm is at least 21 x 21 nodes
+    EXPECT_GE(queries.gridPoints(), 21u * 21);
+}
+
+TEST(BuoyancyTest, StaysAboveSand)
+{
+    msb::WaveRng rng(5);
+    msb::WaveBank bank(msb::makeGeomWaves(rng, 0.), 6);
+    bank.update(30.);
+
+    // a flat beach 0.6 m above the still water level
+    std::vector<unsigned char> pixels(16, 153);
+    msb::BuoyancyQueries queries{msb::Bathymetry(msb::PixelView{pixels.data(), 4, 4, 1})};
+    queries.update(bank, {{40.f, -20.f, 2.f}});
+
+    msb::WaterSamples samples;
+    queries.sample(0, {39.f, 40.f, 41.5f}, {-20.f, -21.f, -19.f}, samples);
+    for (size_t i = 0; i < 3; ++i)
+    {
+        EXPECT_NEAR(samples.height[i], .75f, 1e-5);
+        EXPECT_FLOAT_EQ(samples.vy[i], 0.f);
+    }
+}
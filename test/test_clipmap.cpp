@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include "clipmap.cpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <utility>
+
+namespace
+{
+
+msb::ClipmapSettings smallClipmap() { return {.5f, 4, 4}; }
+
+} // namespace
+
+TEST(ClipmapTest, VertexCount)
+{
+    auto settings = smallClipmap();
+    auto [vertices, indices] = msb::getClipmap(settings);
+
+    // a full 17 x 17 level 0, then the 17 x 17 lattice minus the 9 x 9 finer square per ring
+    EXPECT_EQ(vertices.size(), 3u * (17 * 17 + 3 * (17 * 17 - 9 * 9)));
+    EXPECT_FLOAT_EQ(msb::clipmapExtent(settings), 32.f);
+    EXPECT_EQ(indices.primitive, unsigned(GL_TRIANGLES));
+    EXPECT_TRUE(indices.indices16.empty());
+}
+
+TEST(ClipmapTest, VerticesOnTheirLevelLattice)
+{
+    auto [vertices, indices] = msb::getClipmap(smallClipmap());
+
+    std::map<float, size_t> per_step;
+    for (size_t v = 0; v < vertices.size(); v += 3)
+    {
+        auto step = vertices[v + 1];
+        ++per_step[step];
+        EXPECT_FLOAT_EQ(vertices[v] / step, std::round(vertices[v] / step));
+        EXPECT_FLOAT_EQ(vertices[v + 2] / step, std::round(vertices[v + 2] / step));
+    }
+
+    ASSERT_EQ(per_step.size(), 4u);
+    EXPECT_EQ(per_step[.5f], 17u * 17);
+    EXPECT_EQ(per_step[4.f], 17u * 17 - 9 * 9);
+}
+
+TEST(ClipmapTest, WatertightAndCounterClockwise)
+{
+    auto settings = smallClipmap();
+    auto [vertices, index_data] = msb::getClipmap(settings);
+    auto& indices = index_data.indices32;
+    ASSERT_EQ(indices.size() % 3, 0u);
+
+    // each interior edge is used once in each direction; only the outer square is open
+    std::map<std::pair<unsigned, unsigned>, int> edges;
+    double area = 0.;
+    for (size_t t = 0; t < indices.size(); t += 3)
+    {
+        auto p = [&](size_t k) { return &vertices[3 * size_t(indices[t + k % 3])]; };
+        auto cross = (p(1)[2] - p(0)[2]) * (p(2)[0] - p(0)[0]) -
+                     (p(1)[0] - p(0)[0]) * (p(2)[2] - p(0)[2]);
+        EXPECT_GT(cross, 0.f);
+        area += cross / 2.;
+
+        for (size_t k = 0; k < 3; ++k)
+        {
+            ++edges[{indices[t + k], indices[t + (k + 1) % 3]}];
+        }
+    }
+
+    auto extent = msb::clipmapExtent(settings);
+    EXPECT_NEAR(area, 4. * extent * extent, 1e-3);
+
+    for (auto& [edge, count] : edges)
+    {
+        EXPECT_EQ(count, 1);
+        if (edges.count({edge.second, edge.first}) == 0)
+        {
+            auto a = &vertices[3 * size_t(edge.first)];
+            auto b = &vertices[3 * size_t(edge.second)];
+            auto outer = [extent](const float* v) {
+                return std::max(std::abs(v[0]), std::abs(v[2])) == extent;
+            };
+            EXPECT_TRUE(outer(a) && outer(b)) << a[0] << ", " << a[2];
+        }
+    }
+}
+
+TEST(ClipmapTest, FewerVerticesThanUniformPlane)
+{
+    // the default clipmap reaches past a kilometer with about a third of the vertices of the
+    // 65 x 50 m plane at 10 cm it replaces, keeping that spacing near the camera
+    auto [vertices, indices] = msb::getClipmap();
+    size_t plane_vertices = 650 * 500;
+
+    EXPECT_LT(vertices.size() / 3 * 2, plane_vertices);
+    EXPECT_GT(msb::clipmapExtent({}), 1000.f);
+}
@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+
+#include "environment_map.cpp"
+
+#include <cstdio>
+
+namespace
+{
+
+// Equirectangular image, rows bottom to top, of fn(direction) at each pixel center
+template <typename Fn> std::vector<float> makeEquirect(int width, int height, Fn&& fn)
+{
+    std::vector<float> rgb(size_t(width) * height * 3);
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            // inverse of the equirectToCube mapping
+            auto phi = ((float(x) + .5f) / float(width) - .5f) * 2.f * msb::pi;
+            auto theta = ((float(y) + .5f) / float(height) - .5f) * msb::pi;
+            glm::vec3 dir(-std::cos(theta) * std::cos(phi), std::sin(theta),
+                          std::cos(theta) * std::sin(phi));
+            auto color = fn(dir);
+            for (int c = 0; c < 3; ++c)
+            {
+                rgb[3 * (size_t(y) * width + x) + c] = color[c];
+            }
+        }
+    }
+    return rgb;
+}
+
+} // namespace
+
+TEST(EnvironmentMapTest, SampleInvertsDirection)
+{
+    // every texel holds its own face and position, so a lookup through its center returns it
+    msb::CubeLevel level = {4, std::vector<float>(6 * 4 * 4 * 3)};
+    for (int face = 0; face < 6; ++face)
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            auto p = &level.texels[3 * (face * 16 + i)];
+            p[0] = float(face);
+            p[1] = float(i % 4);
+            p[2] = float(i / 4);
+        }
+    }
+
+    for (int face = 0; face < 6; ++face)
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            auto dir = msb::cubeDirection(face, (i % 4 + .5f) / 4.f, (i / 4 + .5f) / 4.f);
+            auto texel = msb::sampleCube(level, dir);
+            EXPECT_FLOAT_EQ(texel.x, float(face));
+            EXPECT_FLOAT_EQ(texel.y, float(i % 4));
+            EXPECT_FLOAT_EQ(texel.z, float(i / 4));
+        }
+    }
+}
+
+TEST(EnvironmentMapTest, EquirectFollowsDirection)
+{
+    // store the direction itself and check the cube reproduces it
+    auto rgb = makeEquirect(256, 128, [](const glm::vec3& dir) { return dir; });
+    auto cube = msb::equirectToCube(rgb.data(), 256, 128, 16);
+
+    for (int face = 0; face < 6; ++face)
+    {
+        auto dir = glm::normalize(msb::cubeDirection(face, .3f, .6f));
+        auto color = msb::sampleCube(cube, dir);
+        EXPECT_NEAR(color.x, dir.x, 0.05f);
+        EXPECT_NEAR(color.y, dir.y, 0.05f);
+        EXPECT_NEAR(color.z, dir.z, 0.05f);
+    }
+}
+
+TEST(EnvironmentMapTest, ConstantSkyStaysConstant)
+{
+    auto rgb = makeEquirect(64, 32, [](const glm::vec3&) { return glm::vec3(2.f, 1.f, .5f); });
+
+    msb::EnvironmentSizes sizes;
+    sizes.skybox = 32;
+    sizes.irradiance = 8;
+    sizes.prefiltered = 16;
+    sizes.prefiltered_levels = 4;
+    sizes.samples = 64;
+    auto maps = msb::buildEnvironmentMaps(rgb.data(), 64, 32, sizes);
+
+    ASSERT_EQ(maps.skybox.levels.size(), 6u);
+    ASSERT_EQ(maps.irradiance.levels.size(), 1u);
+    ASSERT_EQ(maps.prefiltered.levels.size(), 4u);
+    EXPECT_EQ(maps.prefiltered.levels[3].size, 2);
+
+    // a uniform sky of radiance L gives irradiance / pi = L and any prefilter returns L, up to
+    // the discretization of the cosine lobe over an 8x8 source
+    for (auto cube : {&maps.irradiance, &maps.prefiltered})
+    {
+        for (auto& level : cube->levels)
+        {
+            for (size_t i = 0; i < level.texels.size(); i += 3)
+            {
+                EXPECT_NEAR(level.texels[i], 2.f, 2e-2f);
+                EXPECT_NEAR(level.texels[i + 1], 1.f, 1e-2f);
+                EXPECT_NEAR(level.texels[i + 2], .5f, 5e-3f);
+            }
+        }
+    }
+}
+
+TEST(EnvironmentMapTest, IrradianceOfHalfSky)
+{
+    // light from the upper hemisphere only: full irradiance facing up, none facing down and
+    // half at the horizon
+    auto rgb = makeEquirect(128, 64, [](const glm::vec3& dir) {
+        return glm::vec3(dir.y > 0.f ? 1.f : 0.f);
+    });
+    auto cube = msb::equirectToCube(rgb.data(), 128, 64, 32);
+    auto irradiance = msb::convolveIrradiance(cube, 8);
+
+    EXPECT_NEAR(msb::sampleCube(irradiance, {0.f, 1.f, 0.f}).x, 1.f, 0.05f);
+    EXPECT_NEAR(msb::sampleCube(irradiance, {0.f, -1.f, 0.f}).x, 0.f, 0.05f);
+    EXPECT_NEAR(msb::sampleCube(irradiance, {1.f, 0.f, 0.f}).x, .5f, 0.05f);
+}
+
+TEST(EnvironmentMapTest, CacheRoundTrip)
+{
+    auto rgb = makeEquirect(32, 16, [](const glm::vec3& dir) { return dir * dir; });
+
+    msb::EnvironmentSizes sizes;
+    sizes.skybox = 8;
+    sizes.irradiance = 4;
+    sizes.prefiltered = 8;
+    sizes.prefiltered_levels = 3;
+    sizes.samples = 16;
+    auto maps = msb::buildEnvironmentMaps(rgb.data(), 32, 16, sizes);
+
+    auto path = std::string("test_environment.cache");
+    ASSERT_TRUE(msb::writeEnvironmentCache(path, 7, maps));
+
+    msb::EnvironmentMaps loaded;
+    ASSERT_TRUE(msb::readEnvironmentCache(path, 7, loaded));
+    ASSERT_EQ(loaded.skybox.levels.size(), maps.skybox.levels.size());
+    ASSERT_EQ(loaded.prefiltered.levels.size(), 3u);
+    EXPECT_EQ(loaded.prefiltered.levels[2].size, 2);
+    EXPECT_EQ(loaded.skybox.levels[0].texels, maps.skybox.levels[0].texels);
+    EXPECT_EQ(loaded.irradiance.levels[0].texels, maps.irradiance.levels[0].texels);
+    EXPECT_EQ(loaded.prefiltered.levels[1].texels, maps.prefiltered.levels[1].texels);
+
+    EXPECT_FALSE(msb::readEnvironmentCache(path, 8, loaded));
+
+    std::remove(path.c_str());
+}
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include "fft.cpp"
+
+#include <cmath>
+#include <complex>
+#include <vector>
+
+namespace
+{
+
+std::vector<std::complex<float>> randomGrids(size_t size, size_t grids, unsigned seed)
+{
+    std::vector<std::complex<float>> data(grids * size * size);
+    for (auto& value : data)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        auto re = float(seed >> 8) / 16777216.f - .5f;
+        seed = seed * 1664525u + 1013904223u;
+        auto im = float(seed >> 8) / 16777216.f - .5f;
+        value = {re, im};
+    }
+    return data;
+}
+
+// X(u, v) = sum x(r, c) e^(sign 2 pi i (u r + v c) / N), one grid
+std::vector<std::complex<double>> directSum(const std::complex<float>* x, size_t n, double sign)
+{
+    std::vector<std::complex<double>> result(n * n);
+    for (size_t u = 0; u < n; ++u)
+    {
+        for (size_t v = 0; v < n; ++v)
+        {
+            std::complex<double> sum = 0.;
+            for (size_t r = 0; r < n; ++r)
+            {
+                for (size_t c = 0; c < n; ++c)
+                {
+                    auto angle = sign * 2. * 3.14159265358979323846 * double((u * r + v * c) % n) /
+                                 double(n);
+                    sum += std::complex<double>(x[r * n + c]) * std::polar(1., angle);
+                }
+            }
+            result[u * n + v] = sum;
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+TEST(FftTest, MatchesDirectSum)
+{
+    const size_t n = 16;
+    msb::Fft2d fft(n);
+
+    for (auto sign : {-1., 1.})
+    {
+        auto input = randomGrids(n, 3, 7);
+        auto output = input;
+        if (sign < 0)
+        {
+            fft.forward(output.data(), 3);
+        }
+        else
+        {
+            fft.inverse(output.data(), 3);
+        }
+
+        for (size_t grid = 0; grid < 3; ++grid)
+        {
+            auto expected = directSum(input.data() + grid * n * n, n, sign);
+            for (size_t i = 0; i < n * n; ++i)
+            {
+                EXPECT_NEAR(output[grid * n * n + i].real(), expected[i].real(), 1e-4);
+                EXPECT_NEAR(output[grid * n * n + i].imag(), expected[i].imag(), 1e-4);
+            }
+        }
+    }
+}
+
+TEST(FftTest, RoundTrip)
+{
+    const size_t n = 256;
+    msb::Fft2d fft(n);
+
+    auto input = randomGrids(n, 2, 3);
+    auto data = input;
+    fft.forward(data.data(), 2);
+    fft.inverse(data.data(), 2);
+
+    auto scale = 1.f / float(n * n);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        EXPECT_NEAR(data[i].real() * scale, input[i].real(), 1e-5);
+        EXPECT_NEAR(data[i].imag() * scale, input[i].imag(), 1e-5);
+    }
+}
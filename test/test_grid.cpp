@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+
+#include "grid.cpp"
+
+#include <algorithm>
+#include <array>
+
+namespace
+{
+
+using Triangle = std::array<unsigned int, 3>;
+
+// Rotate so the smallest index leads, keeping the winding
+Triangle canonical(Triangle tri)
+{
+    std::rotate(tri.begin(), std::min_element(tri.begin(), tri.end()), tri.end());
+    return tri;
+}
+
+// Expand every draw of an IndexData into absolute triangles, the way GL would assemble them
+std::vector<Triangle> assemble(const msb::IndexData& data)
+{
+    std::vector<Triangle> triangles;
+
+    if (data.indices16.empty())
+    {
+        for (size_t k = 0; k + 2 < data.indices32.size(); k += 3)
+        {
+            triangles.push_back(
+                canonical({data.indices32[k], data.indices32[k + 1], data.indices32[k + 2]}));
+        }
+        return triangles;
+    }
+
+    for (auto& chunk : data.chunks)
+    {
+        auto first = data.indices16.begin() + chunk.first;
+        auto last = first + chunk.count;
+        auto base = static_cast<unsigned int>(chunk.base_vertex);
+
+        if (data.primitive == GL_TRIANGLES)
+        {
+            for (auto it = first; it != last; it += 3)
+            {
+                triangles.push_back(canonical({base + it[0], base + it[1], base + it[2]}));
+            }
+            continue;
+        }
+
+        // strips, restarting at each restart index
+        while (first != last)
+        {
+            auto end = std::find(first, last, msb::restart_index16);
+            for (auto it = first; end - it >= 3; ++it)
+            {
+                Triangle tri = {base + it[0], base + it[1], base + it[2]};
+                if ((it - first) % 2 == 1)
+                {
+                    std::swap(tri[0], tri[1]);
+                }
+                if (tri[0] != tri[1] && tri[1] != tri[2] && tri[0] != tri[2])
+                {
+                    triangles.push_back(canonical(tri));
+                }
+            }
+            first = end == last ? last : end + 1;
+        }
+    }
+
+    return triangles;
+}
+
+} // namespace
+
+TEST(GridTest, SixteenBitModesMatchTriangleList)
+{
+    // wide enough that the 16-bit modes need several bands
+    size_t rows = 500;
+    size_t cols = 300;
+
+    auto reference = assemble(msb::getGridIndices(rows, cols, msb::IndexMode::Triangles32));
+    ASSERT_EQ(reference.size(), 2 * (rows - 1) * (cols - 1));
+
+    for (auto mode : {msb::IndexMode::Triangles16, msb::IndexMode::Strips16})
+    {
+        auto data = msb::getGridIndices(rows, cols, mode);
+        EXPECT_TRUE(data.indices32.empty());
+        EXPECT_GT(data.chunks.size(), 1u);
+
+        auto triangles = assemble(data);
+        ASSERT_EQ(triangles.size(), reference.size());
+
+        // same triangles and winding, in the same order
+        EXPECT_TRUE(std::equal(triangles.begin(), triangles.end(), reference.begin()));
+    }
+}
+
+TEST(GridTest, StripsUseFewerIndices)
+{
+    size_t rows = 650;
+    size_t cols = 500;
+
+    auto list = msb::getGridIndices(rows, cols, msb::IndexMode::Triangles32);
+    auto strips = msb::getGridIndices(rows, cols, msb::IndexMode::Strips16);
+
+    EXPECT_LT(strips.indices16.size() * sizeof(unsigned short),
+              list.indices32.size() * sizeof(unsigned int) / 4);
+}
+
+TEST(GridTest, OversizedRowsFallBackTo32Bit)
+{
+    auto data = msb::getGridIndices(3, 40000, msb::IndexMode::Strips16);
+
+    EXPECT_TRUE(data.indices16.empty());
+    EXPECT_EQ(data.indices32.size(), 6u * 2 * 39999);
+    EXPECT_EQ(data.primitive, unsigned(GL_TRIANGLES));
+}
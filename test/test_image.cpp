@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include "image.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// 1x2 binary PPM, red on the top row and blue on the bottom one
+std::string writeImage(const std::string& path)
+{
+    std::ofstream(path, std::ios::binary) << "P6\n1 2\n255\n"
+                                          << std::string("\xff\x00\x00\x00\x00\xff", 6);
+    return path;
+}
+
+} // namespace
+
+TEST(ImageTest, FlipIsPerCall)
+{
+    auto path = writeImage("test_image.ppm");
+
+    Image top_down(path, false);
+    ASSERT_NE(top_down.data, nullptr);
+    EXPECT_EQ(top_down.width, 1);
+    EXPECT_EQ(top_down.height, 2);
+    EXPECT_EQ(top_down.nrChannels, 3);
+    EXPECT_EQ(top_down.data[0], 255);
+    EXPECT_EQ(top_down.data[2], 0);
+
+    Image flipped(path);
+    ASSERT_NE(flipped.data, nullptr);
+    EXPECT_EQ(flipped.data[0], 0);
+    EXPECT_EQ(flipped.data[2], 255);
+
+    std::remove(path.c_str());
+}
+
+TEST(ImageTest, RequestedChannelsAndTypes)
+{
+    auto path = writeImage("test_image_types.ppm");
+
+    Image rgba(path, ImageOptions{false, 4});
+    ASSERT_NE(rgba.data, nullptr);
+    EXPECT_EQ(rgba.nrChannels, 4);
+    EXPECT_EQ(rgba.data[3], 255);
+    EXPECT_EQ(rgba.sizeBytes(), 8u);
+
+    Image wide(path, ImageOptions{false, 0, PixelType::UInt16});
+    ASSERT_NE(wide.data, nullptr);
+    EXPECT_EQ(wide.sizeBytes(), 12u);
+    EXPECT_EQ(wide.data16()[0], 65535);
+    EXPECT_EQ(wide.data16()[1], 0);
+
+    Image hdr(path, ImageOptions{false, 0, PixelType::Float});
+    ASSERT_NE(hdr.data, nullptr);
+    EXPECT_EQ(hdr.sizeBytes(), 24u);
+    EXPECT_FLOAT_EQ(hdr.dataf()[0], 1.f);
+    EXPECT_FLOAT_EQ(hdr.dataf()[1], 0.f);
+
+    std::remove(path.c_str());
+}
+
+TEST(ImageTest, MappedMatchesStdio)
+{
+    auto path = writeImage("test_image_mapped.ppm");
+
+    Image read(path, ImageOptions{true, 4});
+    Image mapped(path, ImageOptions{true, 4, PixelType::UInt8, true});
+    ASSERT_NE(mapped.data, nullptr);
+    ASSERT_EQ(mapped.sizeBytes(), read.sizeBytes());
+    EXPECT_TRUE(std::equal(read.data, read.data + read.sizeBytes(), mapped.data));
+
+    std::remove(path.c_str());
+}
+
+TEST(ImageTest, MoveTransfersOwnership)
+{
+    auto path = writeImage("test_image_move.ppm");
+
+    Image a(path);
+    auto pixels = a.data;
+    Image b(std::move(a));
+    EXPECT_EQ(a.data, nullptr);
+    EXPECT_EQ(b.data, pixels);
+
+    Image c("missing.ppm");
+    EXPECT_EQ(c.data, nullptr);
+    EXPECT_EQ(c.sizeBytes(), 0u);
+    c = std::move(b);
+    EXPECT_EQ(c.data, pixels);
+    EXPECT_EQ(b.data, nullptr);
+
+    std::remove(path.c_str());
+}
+
+TEST(ImageTest, ConcurrentLoadsKeepTheirOwnFlip)
+{
+    auto path = writeImage("test_image_threads.ppm");
+
+    std::vector<int> wrong(8, 0);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < wrong.size(); ++t)
+    {
+        threads.emplace_back([&, t] {
+            auto flip = t % 2 == 0;
+            for (int i = 0; i < 200; ++i)
+            {
+                Image img(path, ImageOptions{flip, 0, PixelType::UInt8, i % 2 == 0});
+                auto top_is_red = img.data && img.data[0] == 255;
+                wrong[t] += top_is_red == flip;
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    for (auto count : wrong)
+    {
+        EXPECT_EQ(count, 0);
+    }
+
+    std::remove(path.c_str());
+}
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include "mesh_optimize.cpp"
+
+#include <algorithm>
+#include <array>
+#include <random>
+
+namespace
+{
+
+using Triangle = std::array<float, 9>;
+
+// rows x cols grid with one float3 position per vertex and its triangles in random order
+void makeShuffledGrid(size_t rows, size_t cols, std::vector<float>& vertices,
+                      std::vector<unsigned int>& indices)
+{
+    for (size_t i = 0; i < rows; ++i)
+    {
+        for (size_t j = 0; j < cols; ++j)
+        {
+            vertices.insert(vertices.end(), {float(j), 0.f, -float(i)});
+        }
+    }
+
+    std::vector<std::array<unsigned int, 3>> triangles;
+    for (size_t i = 0; i + 1 < rows; ++i)
+    {
+        for (size_t j = 0; j + 1 < cols; ++j)
+        {
+            auto idx = static_cast<unsigned int>(i * cols + j);
+            auto c = static_cast<unsigned int>(cols);
+            triangles.push_back({idx, idx + c, idx + c + 1});
+            triangles.push_back({idx, idx + c + 1, idx + 1});
+        }
+    }
+
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(7));
+    for (auto& tri : triangles)
+    {
+        indices.insert(indices.end(), tri.begin(), tri.end());
+    }
+}
+
+// Triangles by position, each rotated to a fixed starting corner so winding is kept
+std::vector<Triangle> positions(const std::vector<float>& vertices,
+                                const std::vector<unsigned int>& indices)
+{
+    std::vector<Triangle> triangles;
+    for (size_t k = 0; k < indices.size(); k += 3)
+    {
+        std::array<std::array<float, 3>, 3> corners;
+        for (size_t c = 0; c < 3; ++c)
+        {
+            auto v = &vertices[3 * indices[k + c]];
+            corners[c] = {v[0], v[1], v[2]};
+        }
+        std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()),
+                    corners.end());
+
+        Triangle tri;
+        for (size_t c = 0; c < 3; ++c)
+        {
+            std::copy(corners[c].begin(), corners[c].end(), tri.begin() + 3 * c);
+        }
+        triangles.push_back(tri);
+    }
+
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+} // namespace
+
+TEST(MeshOptimizeTest, AcmrOfSingleTriangles)
+{
+    // disjoint triangles miss every vertex; a repeated triangle hits the cache
+    EXPECT_DOUBLE_EQ(msb::computeAcmr({0, 1, 2, 3, 4, 5}, 6), 3.);
+    EXPECT_DOUBLE_EQ(msb::computeAcmr({0, 1, 2, 0, 1, 2}, 3), 1.5);
+}
+
+TEST(MeshOptimizeTest, ImprovesShuffledGrid)
+{
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    makeShuffledGrid(60, 80, vertices, indices);
+
+    auto before = positions(vertices, indices);
+    auto stats = msb::optimizeMesh(vertices, 3, indices);
+
+    EXPECT_GT(stats.acmr_before, 2.);
+    EXPECT_LT(stats.acmr_after, 0.8);
+    EXPECT_DOUBLE_EQ(stats.acmr_after, msb::computeAcmr(indices, vertices.size() / 3));
+
+    // same triangles and winding, only reordered
+    EXPECT_EQ(positions(vertices, indices), before);
+}
+
+TEST(MeshOptimizeTest, FetchOrderFollowsFirstUse)
+{
+    std::vector<float> vertices = {0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3};
+    std::vector<unsigned int> indices = {3, 1, 2, 2, 1, 3};
+
+    msb::optimizeVertexFetch(vertices, 3, indices);
+
+    // vertex 0 is unreferenced and dropped
+    EXPECT_EQ(indices, (std::vector<unsigned int>{0, 1, 2, 2, 1, 0}));
+    EXPECT_EQ(vertices, (std::vector<float>{3, 3, 3, 1, 1, 1, 2, 2, 2}));
+}
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include "ocean_spectrum.cpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+// a smooth sea: 25 cm samples and no waves under a couple of meters
+msb::SpectrumSettings smoothSea()
+{
+    msb::SpectrumSettings settings;
+    settings.size = 64;
+    settings.patch = 16.f;
+    settings.wind = {3.f, -1.f};
+    settings.small_waves = 1.f;
+    return settings;
+}
+
+} // namespace
+
+TEST(OceanSpectrumTest, NormalsMatchHeightDifferences)
+{
+    msb::OceanSpectrum spectrum(smoothSea());
+    spectrum.evaluate(12.5);
+
+    auto n = size_t(smoothSea().size);
+    auto spacing = smoothSea().patch / float(n);
+    auto& displacement = spectrum.displacement();
+    auto& normals = spectrum.normals();
+    auto height = [&](size_t i, size_t j) { return displacement[3 * ((i % n) * n + j % n) + 1]; };
+
+    float max_slope = 0.f;
+    float max_error = 0.f;
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (size_t j = 0; j < n; ++j)
+        {
+            // the maps tile, so differences wrap around
+            auto slope_x = (height(i, j + 1) - height(i, j + n - 1)) / (2.f * spacing);
+            auto slope_z = (height(i + 1, j) - height(i + n - 1, j)) / (2.f * spacing);
+
+            auto normal = &normals[3 * (i * n + j)];
+            EXPECT_NEAR(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2], 1.f,
+                        1e-5);
+            max_slope = std::max({max_slope, std::abs(slope_x), std::abs(slope_z)});
+            max_error = std::max({max_error, std::abs(-normal[0] / normal[1] - slope_x),
+                                  std::abs(-normal[2] / normal[1] - slope_z)});
+        }
+    }
+
+    EXPECT_GT(max_slope, 1e-3f);
+    EXPECT_LT(max_error, .05f * max_slope);
+}
+
+TEST(OceanSpectrumTest, RealZeroMeanAndMoving)
+{
+    msb::OceanSpectrum spectrum;
+    spectrum.evaluate(3.);
+    auto before = spectrum.displacement();
+    spectrum.evaluate(3.);
+    EXPECT_EQ(spectrum.displacement(), before);
+    spectrum.evaluate(3.5);
+    EXPECT_NE(spectrum.displacement(), before);
+
+    double mean = 0.;
+    double variance = 0.;
+    auto count = before.size() / 3;
+    for (size_t i = 0; i < count; ++i)
+    {
+        mean += before[3 * i + 1];
+        variance += double(before[3 * i + 1]) * before[3 * i + 1];
+    }
+    mean /= double(count);
+    variance /= double(count);
+
+    // no constant term; the default sea is about a meter high, i.e. a deviation near 25 cm
+    EXPECT_NEAR(mean, 0., 1e-4);
+    EXPECT_GT(std::sqrt(variance), .1);
+    EXPECT_LT(std::sqrt(variance), .5);
+}
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include "offscreen.cpp"
+
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+
+// 2x2 RGBA frame as glReadPixels returns it, bottom row first
+std::vector<unsigned char> makeFrame(unsigned char shade)
+{
+    return {shade, 0, 0, 255, shade, 1, 0, 255, 0, shade, 2, 255, 0, shade, 3, 255};
+}
+
+std::string readFile(const std::filesystem::path& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+} // namespace
+
+TEST(FrameWriterTest, PpmSequence)
+{
+    auto dir = std::filesystem::path("test_frames_ppm");
+    {
+        msb::FrameWriter writer(dir.string(), msb::FrameWriter::Format::Ppm, 2, 2);
+        EXPECT_TRUE(writer.write(makeFrame(10)));
+        EXPECT_TRUE(writer.write(makeFrame(20)));
+        EXPECT_FALSE(writer.write(std::vector<unsigned char>(3)));
+        EXPECT_EQ(writer.frames(), 2u);
+    }
+
+    // top row first and alpha dropped
+    auto expected = std::string("P6\n2 2\n255\n") + std::string("\0\x14\x02\0\x14\x03", 6) +
+                    std::string("\x14\0\0\x14\x01\0", 6);
+    EXPECT_EQ(readFile(dir / "frame_00001.ppm"), expected);
+    EXPECT_TRUE(std::filesystem::exists(dir / "frame_00000.ppm"));
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST(FrameWriterTest, RawStream)
+{
+    auto dir = std::filesystem::path("test_frames_raw");
+    {
+        msb::FrameWriter writer(dir.string(), msb::FrameWriter::Format::Raw, 2, 2);
+        for (unsigned char shade = 0; shade < 3; ++shade)
+        {
+            EXPECT_TRUE(writer.write(makeFrame(shade)));
+        }
+    }
+
+    auto raw = readFile(dir / "frames.rgb");
+    ASSERT_EQ(raw.size(), 3u * 2 * 2 * 3);
+    EXPECT_EQ(raw[12 + 1], 1); // second frame, top-left green
+
+    std::filesystem::remove_all(dir);
+}
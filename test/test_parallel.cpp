@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+
+#include "parallel.hpp"
+
+#include <atomic>
+#include <vector>
+
+TEST(ParallelForTest, CoversEveryIndexOnce)
+{
+    for (size_t count : {0, 1, 7, 1000, 100003})
+    {
+        std::vector<std::atomic<int>> hits(count);
+        msb::parallelFor(0, count, [&](size_t first, size_t last) {
+            for (auto i = first; i < last; ++i)
+            {
+                ++hits[i];
+            }
+        });
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            ASSERT_EQ(hits[i].load(), 1) << "index " << i << " of " << count;
+        }
+    }
+}
+
+TEST(ParallelForTest, NestedCallsRunInline)
+{
+    std::atomic<size_t> total{0};
+    msb::parallelFor(0, 64, [&](size_t first, size_t last) {
+        for (auto i = first; i < last; ++i)
+        {
+            msb::parallelFor(0, 100, [&](size_t a, size_t b) { total += b - a; });
+        }
+    });
+    EXPECT_EQ(total.load(), 6400u);
+}
+
+// repeated small calls reuse the pool rather than starting threads
+TEST(ParallelForTest, ManySmallCalls)
+{
+    std::atomic<size_t> total{0};
+    for (int call = 0; call < 2000; ++call)
+    {
+        msb::parallelFor(0, 64, [&](size_t first, size_t last) { total += last - first; });
+    }
+    EXPECT_EQ(total.load(), 2000u * 64u);
+}
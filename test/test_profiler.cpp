@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include "profiler.cpp"
+
+#include <fstream>
+#include <iterator>
+
+TEST(ProfilerTest, Percentiles)
+{
+    msb::FrameTimes times(100);
+    EXPECT_EQ(times.percentile(.5), 0.);
+
+    for (int ms = 100; ms >= 1; --ms)
+    {
+        times.add(ms);
+    }
+
+    EXPECT_EQ(times.size(), 100u);
+    EXPECT_EQ(times.percentile(0.), 1.);
+    EXPECT_EQ(times.percentile(.5), 51.);
+    EXPECT_EQ(times.percentile(.99), 99.);
+    EXPECT_EQ(times.percentile(1.), 100.);
+    EXPECT_DOUBLE_EQ(times.mean(), 50.5);
+}
+
+TEST(ProfilerTest, RollingWindow)
+{
+    msb::FrameTimes times(4);
+    for (auto ms : {50., 50., 50., 50., 1., 2., 3.})
+    {
+        times.add(ms);
+    }
+
+    // only the last four samples remain
+    EXPECT_EQ(times.size(), 4u);
+    EXPECT_EQ(times.percentile(1.), 50.);
+    EXPECT_EQ(times.percentile(0.), 1.);
+    EXPECT_DOUBLE_EQ(times.mean(), 14.);
+}
+
+TEST(ProfilerTest, NestedCpuZones)
+{
+    msb::Profiler profiler;
+    profiler.beginFrame();
+    {
+        msb::CpuZone outer(profiler, "update");
+        msb::CpuZone inner(profiler, "waves");
+    }
+    profiler.beginFrame();
+
+    auto& events = profiler.events();
+    ASSERT_EQ(events.size(), 3u);
+    EXPECT_EQ(events[0].name, "waves");
+    EXPECT_EQ(events[1].name, "update");
+    EXPECT_EQ(events[2].name, "frame");
+
+    EXPECT_GE(events[0].start_us, events[1].start_us);
+    EXPECT_LE(events[0].start_us + events[0].duration_us,
+              events[1].start_us + events[1].duration_us);
+    EXPECT_GE(profiler.zoneMedian("waves", false), 0.);
+    EXPECT_EQ(profiler.zoneMedian("waves", true), -1.);
+    EXPECT_EQ(profiler.frameTimes().size(), 1u);
+}
+
+TEST(ProfilerTest, EventLimit)
+{
+    msb::Profiler profiler(2);
+    for (int i = 0; i < 5; ++i)
+    {
+        msb::CpuZone zone(profiler, "draw");
+    }
+
+    EXPECT_EQ(profiler.events().size(), 2u);
+}
+
+TEST(ProfilerTest, ChromeTrace)
+{
+    msb::Profiler profiler;
+    {
+        msb::CpuZone zone(profiler, "say \"hi\"");
+    }
+
+    std::string path = "test_trace.json";
+    ASSERT_TRUE(profiler.writeChromeTrace(path));
+
+    std::ifstream in(path);
+    std::string json((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    std::remove(path.c_str());
+
+    EXPECT_EQ(json.rfind("{\"traceEvents\": [", 0), 0u);
+    EXPECT_NE(json.find("\"name\": \"say \\\"hi\\\"\", \"ph\": \"X\""), std::string::npos);
+    EXPECT_NE(json.find("\"tid\": 0}"), std::string::npos);
+    EXPECT_EQ(json.substr(json.size() - 4), "\n]}\n");
+}
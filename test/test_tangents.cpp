@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include "tangents.cpp"
+
+#include <cmath>
+
+namespace
+{
+
+// rows x cols grid in the getTerrain layout over a bumpy height field
+std::vector<float> makeGrid(size_t rows, size_t cols)
+{
+    std::vector<float> vertices(rows * cols * msb::tbn_layout.stride, 0.f);
+
+    for (size_t i = 0; i < rows; ++i)
+    {
+        for (size_t j = 0; j < cols; ++j)
+        {
+            auto vert = &vertices[(i * cols + j) * msb::tbn_layout.stride];
+            vert[0] = float(j);
+            vert[1] = std::sin(0.7f * j) * std::cos(0.3f * i);
+            vert[2] = -float(i);
+            vert[4] = 1.f;
+            vert[6] = 15.f * j / (cols - 1.f);
+            vert[7] = 15.f * i / (rows - 1.f);
+        }
+    }
+
+    return vertices;
+}
+
+std::vector<unsigned int> makeGridIndices(size_t rows, size_t cols)
+{
+    std::vector<unsigned int> indices;
+    for (size_t i = 0; i + 1 < rows; ++i)
+    {
+        for (size_t j = 0; j + 1 < cols; ++j)
+        {
+            auto idx = static_cast<unsigned int>(i * cols + j);
+            auto c = static_cast<unsigned int>(cols);
+            indices.insert(indices.end(), {idx, idx + c, idx + c + 1, idx, idx + c + 1, idx + 1});
+        }
+    }
+    return indices;
+}
+
+} // namespace
+
+TEST(TangentTest, GridGatherMatchesIndexedGather)
+{
+    size_t rows = 37;
+    size_t cols = 53;
+    auto grid = makeGrid(rows, cols);
+    auto indexed = grid;
+
+    msb::computeGridTangents(grid.data(), rows, cols, msb::tbn_layout);
+    msb::computeTangents(indexed.data(), rows * cols, msb::tbn_layout,
+                         makeGridIndices(rows, cols));
+
+    for (size_t v = 0; v < rows * cols; ++v)
+    {
+        for (size_t k = 8; k < 11; ++k)
+        {
+            EXPECT_NEAR(grid[v * 11 + k], indexed[v * 11 + k], 1e-5);
+        }
+    }
+}
+
+TEST(TangentTest, TangentsAreUnitAndOrthogonal)
+{
+    size_t rows = 20;
+    size_t cols = 30;
+    auto grid = makeGrid(rows, cols);
+    msb::computeGridTangents(grid.data(), rows, cols, msb::tbn_layout);
+
+    for (size_t v = 0; v < rows * cols; ++v)
+    {
+        auto vert = &grid[v * 11];
+        auto normal = glm::make_vec3(vert + 3);
+        auto tangent = glm::make_vec3(vert + 8);
+
+        EXPECT_NEAR(glm::length(tangent), 1.f, 1e-5);
+        EXPECT_NEAR(glm::dot(tangent, normal), 0.f, 1e-5);
+
+        // u runs along +x on this grid
+        EXPECT_GT(tangent.x, 0.f);
+    }
+}
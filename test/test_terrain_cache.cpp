@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+
+#include "terrain_cache.cpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+
+std::string writeFile(const std::string& path, const std::string& contents)
+{
+    std::ofstream(path, std::ios::binary) << contents;
+    return path;
+}
+
+} // namespace
+
+TEST(TerrainCacheTest, RoundTrip)
+{
+    std::vector<float> vertices(11 * 40 * 30);
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        vertices[i] = 0.25f * float(i);
+    }
+    msb::IndexData indices;
+    indices.primitive = GL_TRIANGLE_STRIP;
+    for (unsigned short i = 0; i < 1000; ++i)
+    {
+        indices.indices16.push_back(i % 7 == 6 ? msb::restart_index16 : i);
+    }
+    indices.chunks = {{0, 600, 0}, {600, 400, 480}};
+
+    // stands in for packed bytes; the cache stores them as given
+    msb::PackedVertexView packed = {vertices.data(), vertices.size() * sizeof(float),
+                                    glm::vec3(2.f, 3.f, 4.f), glm::vec3(-1.f), glm::vec2(.5f),
+                                    glm::vec2(.25f)};
+
+    auto path = std::string("test_terrain.cache");
+    ASSERT_TRUE(msb::writeTerrainCache(path, 42, packed, msb::VertexPacking::Compact,
+                                       {3, 3, 2, 3}, indices));
+
+    msb::TerrainCache cache(path, 42, msb::VertexPacking::Compact);
+    ASSERT_TRUE(cache.valid());
+
+    auto& cached_vertices = cache.vertices();
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(cached_vertices.data) % msb::terrain_cache_alignment,
+              0u);
+    EXPECT_EQ(cache.layout(), (std::vector<unsigned int>{3, 3, 2, 3}));
+    ASSERT_EQ(cached_vertices.bytes, packed.bytes);
+    EXPECT_EQ(std::memcmp(cached_vertices.data, packed.data, packed.bytes), 0);
+    EXPECT_EQ(cached_vertices.position_scale, packed.position_scale);
+    EXPECT_EQ(cached_vertices.position_offset, packed.position_offset);
+    EXPECT_EQ(cached_vertices.uv_scale, packed.uv_scale);
+    EXPECT_EQ(cached_vertices.uv_offset, packed.uv_offset);
+
+    auto& view = cache.indices();
+    EXPECT_EQ(view.primitive, unsigned(GL_TRIANGLE_STRIP));
+    EXPECT_EQ(view.type, unsigned(GL_UNSIGNED_SHORT));
+    ASSERT_EQ(view.count, indices.indices16.size());
+    auto cached = static_cast<const unsigned short*>(view.data);
+    EXPECT_TRUE(std::equal(indices.indices16.begin(), indices.indices16.end(), cached));
+    ASSERT_EQ(view.chunks.size(), indices.chunks.size());
+    EXPECT_EQ(view.chunks[1].first, 600u);
+    EXPECT_EQ(view.chunks[1].count, 400u);
+    EXPECT_EQ(view.chunks[1].base_vertex, 480);
+
+    // a different key or packing is a miss
+    EXPECT_FALSE(msb::TerrainCache(path, 43, msb::VertexPacking::Compact).valid());
+    EXPECT_FALSE(msb::TerrainCache(path, 42, msb::VertexPacking::Float).valid());
+
+    std::remove(path.c_str());
+}
+
+TEST(TerrainCacheTest, KeyFollowsSourcesAndParameters)
+{
+    auto ht = writeFile("test_ht.bin", "height pixels");
+    auto norm = writeFile("test_norm.bin", "normal pixels");
+
+    auto strips = msb::IndexMode::Strips16;
+    auto floats = msb::VertexPacking::Float;
+    auto key = msb::terrainCacheKey(ht, norm, 50, 50, strips, floats);
+    EXPECT_EQ(key, msb::terrainCacheKey(ht, norm, 50, 50, strips, floats));
+    EXPECT_NE(key, msb::terrainCacheKey(ht, norm, 50, 40, strips, floats));
+    EXPECT_NE(key, msb::terrainCacheKey(ht, norm, 50, 50, msb::IndexMode::Triangles32, floats));
+    EXPECT_NE(key, msb::terrainCacheKey(ht, norm, 50, 50, strips, msb::VertexPacking::Compact));
+
+    writeFile(ht, "height pixelz");
+    EXPECT_NE(key, msb::terrainCacheKey(ht, norm, 50, 50, strips, floats));
+
+    std::remove(ht.c_str());
+    std::remove(norm.c_str());
+}
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include "triple_buffer.hpp"
+
+#include <thread>
+
+TEST(TripleBufferTest, FetchesNewestPublished)
+{
+    msb::TripleBuffer<int> buffer;
+    EXPECT_FALSE(buffer.fetch());
+
+    buffer.back() = 1;
+    buffer.publish();
+    buffer.back() = 2;
+    buffer.publish();
+
+    // 1 was never fetched, so 2 replaced it
+    EXPECT_TRUE(buffer.fetch());
+    EXPECT_EQ(buffer.front(), 2);
+    EXPECT_FALSE(buffer.fetch());
+    EXPECT_EQ(buffer.front(), 2);
+
+    buffer.back() = 3;
+    buffer.publish();
+    EXPECT_TRUE(buffer.fetch());
+    EXPECT_EQ(buffer.front(), 3);
+}
+
+TEST(TripleBufferTest, HandsOverWholeValuesAcrossThreads)
+{
+    struct Value
+    {
+        int first = 0;
+        int payload[63] = {};
+        int last = 0;
+    };
+
+    const int count = 100000;
+    msb::TripleBuffer<Value> buffer;
+
+    std::thread producer([&] {
+        for (int i = 1; i <= count; ++i)
+        {
+            auto& value = buffer.back();
+            value.first = i;
+            for (auto& p : value.payload)
+            {
+                p = i;
+            }
+            value.last = i;
+            buffer.publish();
+        }
+    });
+
+    // a torn value would mix two publishes; values only move forward
+    int seen = 0;
+    bool torn = false;
+    while (seen < count)
+    {
+        if (!buffer.fetch())
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        auto& value = buffer.front();
+        torn = torn || value.first != value.last || value.payload[31] != value.first;
+        EXPECT_GT(value.first, seen);
+        seen = value.first;
+    }
+    producer.join();
+
+    EXPECT_FALSE(torn);
+    EXPECT_EQ(seen, count);
+}
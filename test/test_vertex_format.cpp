@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include "vertex_format.cpp"
+
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+
+float decodeUnorm16(const unsigned char* data)
+{
+    uint16_t q;
+    std::memcpy(&q, data, sizeof(q));
+    return q / 65535.f;
+}
+
+glm::vec3 decodeSnorm10(const unsigned char* data)
+{
+    uint32_t q;
+    std::memcpy(&q, data, sizeof(q));
+
+    glm::vec3 v;
+    for (int c = 0; c < 3; ++c)
+    {
+        // sign extend the 10-bit field
+        auto field = static_cast<int32_t>((q >> (10 * c)) & 0x3FF);
+        field = field >= 512 ? field - 1024 : field;
+        v[c] = std::max(field / 511.f, -1.f);
+    }
+    return v;
+}
+
+} // namespace
+
+TEST(VertexFormatTest, CompactTerrainVertexIs20Bytes)
+{
+    EXPECT_EQ(msb::attributeOffsets(msb::compactFormat({3, 3, 2, 3})).back(), 20u);
+    EXPECT_EQ(msb::attributeOffsets(msb::compactFormat({3, 3, 2})).back(), 16u);
+    EXPECT_EQ(msb::attributeOffsets(msb::floatFormat({3, 3, 2, 3})).back(), 44u);
+}
+
+TEST(VertexFormatTest, CompactRoundTrip)
+{
+    std::vector<unsigned int> layout = {3, 3, 2, 3};
+    std::vector<float> vertices;
+    for (int i = 0; i < 100; ++i)
+    {
+        auto a = 0.37f * i;
+        auto n = glm::normalize(glm::vec3(std::sin(a), 2.f, std::cos(a)));
+        auto t = glm::normalize(glm::vec3(1.f, std::sin(2.f * a), 0.f));
+        vertices.insert(vertices.end(), {25.f + 0.5f * i, 3.f * std::sin(a), -0.5f * i, n.x, n.y,
+                                         n.z, 0.15f * i, 15.f - 0.15f * i, t.x, t.y, t.z});
+    }
+
+    auto format = msb::compactFormat(layout);
+    auto offsets = msb::attributeOffsets(format);
+    auto packed = msb::packVertices(vertices.data(), vertices.size(), layout, format);
+    ASSERT_EQ(packed.data.size(), 100 * offsets.back());
+
+    for (size_t v = 0; v < 100; ++v)
+    {
+        auto src = &vertices[v * 11];
+        auto dst = packed.data.data() + v * offsets.back();
+
+        for (int c = 0; c < 3; ++c)
+        {
+            auto pos = decodeUnorm16(dst + offsets[0] + 2 * c) * packed.position_scale[c] +
+                       packed.position_offset[c];
+            EXPECT_NEAR(pos, src[c], 1e-3);
+        }
+
+        for (int c = 0; c < 2; ++c)
+        {
+            auto uv = decodeUnorm16(dst + offsets[2] + 2 * c) * packed.uv_scale[c] +
+                      packed.uv_offset[c];
+            EXPECT_NEAR(uv, src[6 + c], 1e-3);
+        }
+
+        auto normal = decodeSnorm10(dst + offsets[1]);
+        auto tangent = decodeSnorm10(dst + offsets[3]);
+        for (int c = 0; c < 3; ++c)
+        {
+            EXPECT_NEAR(normal[c], src[3 + c], 2e-3);
+            EXPECT_NEAR(tangent[c], src[8 + c], 2e-3);
+        }
+    }
+}
@@ -0,0 +1,249 @@
+#include <gtest/gtest.h>
+
+#include "sim_clock.hpp"
+#include "wave.cpp"
+
+TEST(WaveTest, SeededRngRepeats)
+{
+    msb::WaveRng a(42);
+    msb::WaveRng b(42);
+    msb::WaveRng c(43);
+
+    auto same = true;
+    auto differs = false;
+    for (auto i = 0; i < 1000; ++i)
+    {
+        auto x = a.next();
+        same = same && x == b.next();
+        differs = differs || x != c.next();
+    }
+
+    EXPECT_TRUE(same);
+    EXPECT_TRUE(differs);
+
+    for (auto i = 0; i < 1000; ++i)
+    {
+        auto u = a.uniform();
+        EXPECT_GE(u, 0.f);
+        EXPECT_LT(u, 1.f);
+    }
+}
+
+TEST(WaveTest, BankMatchesScalarWaves)
+{
+    auto clock = msb::SimClock::fixedStep(0.25, 100.);
+    msb::WaveRng rng(7);
+    auto waves = msb::makeTexWaves(37, rng, clock.now());
+    msb::WaveBank bank(waves, 8);
+
+    // stay inside the first lifetime so neither side redraws
+    for (auto step = 0; step < 1000; ++step)
+    {
+        auto t = clock.tick();
+        bank.update(t);
+
+        for (size_t i = 0; i < waves.size(); ++i)
+        {
+            EXPECT_NEAR(bank.amplitudes()[i], waves[i].amplitude(t), 1e-5);
+            EXPECT_NEAR(bank.phases()[i], waves[i].phase(t), 1e-5 * waves[i].phase(t));
+        }
+    }
+}
+
+TEST(WaveTest, FixedStepRunsAreBitIdentical)
+{
+    auto run = [] {
+        auto clock = msb::SimClock::fixedStep(1. / 60.);
+        msb::WaveRng rng(1);
+        msb::WaveBank bank(msb::makeTexWaves(64, rng, clock.now()), 2);
+
+        // long enough for every wave to expire and be redrawn
+        std::vector<float> trace;
+        for (auto step = 0; step < 60 * 1700; ++step)
+        {
+            bank.update(clock.tick());
+        }
+        trace.insert(trace.end(), bank.amplitudes().begin(), bank.amplitudes().end());
+        trace.insert(trace.end(), bank.phases().begin(), bank.phases().end());
+        trace.insert(trace.end(), bank.dir_x().begin(), bank.dir_x().end());
+        return trace;
+    };
+
+    EXPECT_EQ(run(), run());
+}
+
+namespace
+{
+
+// ocean.vert in double precision, without the terrain clamp and the clipmap fade
+double referenceSpeed(double freq, double phase, double depth)
+{
+    phase = phase / std::sqrt(freq * 9.8);
+    return phase * std::max(1., std::floor(std::sqrt(9.8 * freq *
+                                                      std::max(0., std::tanh(freq * depth)))));
+}
+
+glm::dvec3 referencePosition(const msb::WaveBank& bank, double x, double z, double depth)
+{
+    glm::dvec3 new_pos(0.);
+    double tot_chop = 0.4 + std::clamp(2 - depth, 0., 1.) / 2;
+    auto num_waves = double(bank.size());
+
+    for (size_t i = 0; i < bank.size(); ++i)
+    {
+        double amp = bank.amplitudes()[i];
+        double freq = bank.freqs()[i];
+        glm::dvec2 dirs(bank.dir_x()[i], bank.dir_y()[i]);
+
+        auto phi = referenceSpeed(freq, double(bank.phases()[i]) - bank.phase_offsets()[i],
+                                  depth);
+        phi += bank.phase_offsets()[i];
+        auto chop = tot_chop / (freq * amp * num_waves);
+
+        auto angle = freq * glm::dot(dirs, glm::dvec2(x, -z)) - phi;
+        new_pos.x += amp * chop * dirs.x * std::cos(angle);
+        new_pos.z += amp * chop * -dirs.y * std::cos(angle);
+        new_pos.y += amp * std::sin(angle);
+    }
+
+    return {x + new_pos.x, new_pos.y, z + new_pos.z};
+}
+
+glm::dvec3 referenceNormal(const msb::WaveBank& bank, glm::dvec3 new_pos, double depth)
+{
+    glm::dvec3 slope(0.);
+    double tot_chop = 0.4 + std::clamp(2 - depth, 0., 1.) / 2;
+    auto num_waves = double(bank.size());
+
+    for (size_t i = 0; i < bank.size(); ++i)
+    {
+        double amp = bank.amplitudes()[i];
+        double freq = bank.freqs()[i];
+        glm::dvec2 dirs(bank.dir_x()[i], bank.dir_y()[i]);
+        auto chop = tot_chop / (freq * amp * num_waves);
+
+        auto phi = referenceSpeed(freq, double(bank.phases()[i]) - bank.phase_offsets()[i],
+                                  depth);
+        phi += bank.phase_offsets()[i];
+
+        auto angle = freq * glm::dot(dirs, glm::dvec2(new_pos.x, -new_pos.z)) - phi;
+        slope.x += dirs.x * freq * amp * std::cos(angle);
+        slope.z += -dirs.y * freq * amp * std::cos(angle);
+        slope.y += chop * freq * amp * std::sin(angle);
+    }
+
+    return glm::normalize(glm::dvec3(0, 1, 0) - slope);
+}
+
+// scattered over the beach and out to sea, with depths from dry sand to past every speed step
+msb::WavePoints randomPoints(size_t count, msb::WaveRng& rng)
+{
+    msb::WavePoints points;
+    for (size_t i = 0; i < count; ++i)
+    {
+        points.x.push_back(100.f * rng.uniform() - 50.f);
+        points.z.push_back(100.f * rng.uniform() - 50.f);
+        points.depth.push_back(rng.uniform() < .5f ? 3.f * rng.uniform() : 20.f * rng.uniform());
+    }
+    return points;
+}
+
+} // namespace
+
+TEST(WaveFieldTest, MatchesShader)
+{
+    msb::WaveRng rng(3);
+    msb::WaveBank geom_bank(msb::makeGeomWaves(rng, 0.), 4);
+    msb::WaveBank tex_bank(msb::makeTexWaves(32, rng, 0.), 5);
+
+    // odd count so the scalar tail runs, large enough to split across threads
+    auto points = randomPoints(10001, rng);
+    auto deep = points;
+    deep.depth.clear();
+
+    for (auto bank : {&geom_bank, &tex_bank})
+    {
+        bank->update(70.);
+        msb::WaveField field(*bank);
+
+        for (auto query : {&points, &deep})
+        {
+            msb::WaveSurface surface;
+            field.evaluate(*query, surface);
+
+            for (size_t i = 0; i < query->size(); ++i)
+            {
+                auto depth = query->depth.empty() ? 1e30 : double(query->depth[i]);
+                auto position = referencePosition(*bank, query->x[i], query->z[i], depth);
+                auto normal = referenceNormal(*bank, position, depth);
+
+                EXPECT_NEAR(query->x[i] + surface.dx[i], position.x, 1e-3);
+                EXPECT_NEAR(surface.dy[i], position.y, 1e-3);
+                EXPECT_NEAR(query->z[i] + surface.dz[i], position.z, 1e-3);
+                EXPECT_NEAR(surface.nx[i], normal.x, 1e-3);
+                EXPECT_NEAR(surface.ny[i], normal.y, 1e-3);
+                EXPECT_NEAR(surface.nz[i], normal.z, 1e-3);
+            }
+        }
+    }
+}
+
+TEST(WaveFieldTest, HeightsInvertDisplacement)
+{
+    msb::WaveRng rng(9);
+    msb::WaveBank bank(msb::makeGeomWaves(rng, 0.), 10);
+    bank.update(40.);
+    msb::WaveField field(bank);
+
+    // the shallowest water chops hardest and converges slowest
+    auto queries = randomPoints(1001, rng);
+    std::fill(queries.depth.begin(), queries.depth.end(), 0.f);
+
+    msb::WaveSurface above;
+    msb::WaveField::HeightScratch scratch;
+    field.heights(queries, above, scratch);
+
+    // the rest points found must be displaced onto the queries
+    auto rest = queries;
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        rest.x[i] -= above.dx[i];
+        rest.z[i] -= above.dz[i];
+    }
+    msb::WaveSurface surface;
+    field.evaluate(rest, surface);
+
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        EXPECT_NEAR(rest.x[i] + surface.dx[i], queries.x[i], 1e-3);
+        EXPECT_NEAR(rest.z[i] + surface.dz[i], queries.z[i], 1e-3);
+        EXPECT_NEAR(surface.dy[i], above.dy[i], 1e-3);
+        EXPECT_NEAR(surface.ny[i], above.ny[i], 1e-3);
+    }
+}
+
+TEST(WaveFieldTest, VelocityIsRateOfDisplacement)
+{
+    msb::WaveRng rng(11);
+    msb::WaveBank bank(msb::makeTexWaves(32, rng, 0.), 12);
+    auto points = randomPoints(101, rng);
+
+    // central difference of the displacement of fixed rest points, away from any fade
+    auto displaced = [&](double t) {
+        bank.update(t);
+        msb::WaveSurface surface;
+        msb::WaveField(bank).evaluate(points, surface);
+        return surface;
+    };
+    auto dt = 1e-3;
+    auto before = displaced(50. - dt);
+    auto after = displaced(50. + dt);
+    auto now = displaced(50.);
+
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        EXPECT_NEAR(now.vx[i], (after.dx[i] - before.dx[i]) / (2 * dt), 2e-2);
+        EXPECT_NEAR(now.vy[i], (after.dy[i] - before.dy[i]) / (2 * dt), 2e-2);
+        EXPECT_NEAR(now.vz[i], (after.dz[i] - before.dz[i]) / (2 * dt), 2e-2);
+    }
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include "wave_simulation.cpp"
+
+#include "sim_clock.hpp"
+
+#include <cstring>
+
+namespace
+{
+
+bool samePayload(const std::vector<msb::WaveStd140>& a, const std::vector<msb::WaveStd140>& b)
+{
+    return a.size() == b.size() &&
+           std::memcmp(a.data(), b.data(), a.size() * sizeof(msb::WaveStd140)) == 0;
+}
+
+} // namespace
+
+// Driven the way Scene drives it, the background thread must produce exactly what Scene used to
+// compute inline at each tick
+TEST(WaveSimulationTest, MatchesSerialUpdates)
+{
+    auto clock = msb::SimClock::fixedStep(1. / 60.);
+    msb::WaveSimulation simulation(clock.now(), msb::OceanMode::Gerstner);
+
+    msb::WaveRng rng(1);
+    msb::WaveBank geom(msb::makeGeomWaves(rng, 0.), 2);
+    msb::WaveBank tex(msb::makeTexWaves(32, rng, 0.), 3);
+    std::vector<msb::WaveStd140> geom_payload;
+    std::vector<msb::WaveStd140> tex_payload;
+
+    EXPECT_TRUE(simulation.idle());
+    for (int frame = 1; frame <= 600; ++frame)
+    {
+        auto t = clock.tick();
+        if (simulation.idle())
+        {
+            simulation.request(t);
+        }
+        auto& waves = simulation.acquire();
+        simulation.request(clock.next());
+
+        geom.update(t);
+        tex.update(t);
+        msb::WaveBlock::pack(geom, .5f, geom_payload);
+        msb::WaveBlock::pack(tex, 0.f, tex_payload);
+
+        ASSERT_EQ(waves.t, t);
+        ASSERT_EQ(waves.sequence, uint64_t(frame));
+        ASSERT_TRUE(samePayload(waves.geom_waves, geom_payload)) << "frame " << frame;
+        ASSERT_TRUE(samePayload(waves.tex_waves, tex_payload)) << "frame " << frame;
+    }
+    EXPECT_FALSE(simulation.idle());
+}
+
+TEST(WaveSimulationTest, TimeOnlyRunsForward)
+{
+    msb::WaveSimulation simulation(5., msb::OceanMode::Gerstner);
+
+    simulation.request(2.);
+    EXPECT_EQ(simulation.acquire().t, 5.);
+    EXPECT_TRUE(simulation.idle());
+
+    simulation.request(7.);
+    simulation.request(6.);
+    EXPECT_EQ(simulation.acquire().t, 7.);
+}
+
+TEST(WaveSimulationTest, SpectralFramesCarryTheMaps)
+{
+    msb::WaveSimulation simulation(0., msb::OceanMode::Spectral);
+    EXPECT_EQ(simulation.mode(), msb::OceanMode::Spectral);
+
+    msb::OceanSpectrum spectrum(simulation.spectrumSettings());
+    spectrum.evaluate(2.5);
+
+    simulation.request(2.5);
+    auto& waves = simulation.acquire();
+    EXPECT_EQ(waves.displacement, spectrum.displacement());
+    EXPECT_EQ(waves.normals, spectrum.normals());
+
+    // the wave blocks are still bound in spectral mode
+    EXPECT_EQ(waves.geom_waves.size(), simulation.geomWaves());
+    EXPECT_EQ(waves.tex_waves.size(), simulation.texWaves());
+}
@@ -0,0 +1,41 @@
+#include "brdf_lut.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+// Offline bake of the split-sum BRDF table that loadBrdfLut otherwise builds on first run
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cout << "usage: bake_brdf_lut <output> [size] [samples]\n"
+                     "  defaults: size "
+                  << msb::brdf_lut_size << ", samples " << msb::brdf_lut_samples << "\n";
+        return 1;
+    }
+
+    std::string output = argv[1];
+    auto size = argc > 2 ? std::stoi(argv[2]) : msb::brdf_lut_size;
+    auto samples = argc > 3 ? unsigned(std::stoul(argv[3])) : msb::brdf_lut_samples;
+    if (size <= 0 || samples == 0)
+    {
+        std::cout << "Error: size and samples must be positive\n";
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto lut = msb::computeBrdfLut(size, samples);
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+    if (!msb::writeBrdfLut(output, size, samples, lut))
+    {
+        std::cout << "Error: could not write " << output << "\n";
+        return 1;
+    }
+
+    std::cout << output << ": " << size << "x" << size << ", " << samples << " samples, "
+              << elapsed.count() << " s\n";
+
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include "block_compress.hpp"
+#include "image.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace
+{
+
+void usage()
+{
+    std::cout << "usage: compress_textures <input image> <output.ktx> <bc1|bc3|bc4|bc5> [--srgb]\n"
+                 "  bc1  opaque color          bc3  color with alpha\n"
+                 "  bc4  single channel (red)  bc5  normal map xy\n";
+}
+
+// Error of the base level against the source, decoding the blocks back
+double rmse(const unsigned char* rgba, int width, int height, msb::BlockFormat format,
+            const msb::CompressedLevel& level)
+{
+    auto blocks_x = (width + 3) / 4;
+    auto block_bytes = msb::blockBytes(format);
+
+    double sum = 0.;
+    size_t count = 0;
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            auto block = &level.data[(size_t(y / 4) * blocks_x + x / 4) * block_bytes];
+            auto texel = 4 * (y % 4) + x % 4;
+            auto src = &rgba[4 * (size_t(y) * width + x)];
+
+            unsigned char decoded[64];
+            unsigned char values[16];
+            auto compare = [&](int channel, int value) {
+                double d = src[channel] - value;
+                sum += d * d;
+                ++count;
+            };
+
+            switch (format)
+            {
+            case msb::BlockFormat::BC1:
+                msb::decodeBlockBC1(block, decoded);
+                for (int c = 0; c < 3; ++c)
+                {
+                    compare(c, decoded[4 * texel + c]);
+                }
+                break;
+            case msb::BlockFormat::BC3:
+                msb::decodeBlockBC4(block, values);
+                msb::decodeBlockBC1(block + 8, decoded);
+                for (int c = 0; c < 3; ++c)
+                {
+                    compare(c, decoded[4 * texel + c]);
+                }
+                compare(3, values[texel]);
+                break;
+            case msb::BlockFormat::BC4:
+                msb::decodeBlockBC4(block, values);
+                compare(0, values[texel]);
+                break;
+            case msb::BlockFormat::BC5:
+                for (int c = 0; c < 2; ++c)
+                {
+                    msb::decodeBlockBC4(block + 8 * c, values);
+                    compare(c, values[texel]);
+                }
+                break;
+            }
+        }
+    }
+
+    return count ? std::sqrt(sum / double(count)) : 0.;
+}
+
+} // namespace
+
+// Offline encoder for the texture cache: TextureLoader picks up <name>.ktx next to <name>.png/jpg
+int main(int argc, char** argv)
+{
+    if (argc < 4)
+    {
+        usage();
+        return 1;
+    }
+
+    std::string input = argv[1];
+    std::string output = argv[2];
+    std::string mode = argv[3];
+    bool srgb = argc > 4 && std::strcmp(argv[4], "--srgb") == 0;
+
+    msb::BlockFormat format;
+    if (mode == "bc1")
+    {
+        format = msb::BlockFormat::BC1;
+    }
+    else if (mode == "bc3")
+    {
+        format = msb::BlockFormat::BC3;
+    }
+    else if (mode == "bc4")
+    {
+        format = msb::BlockFormat::BC4;
+    }
+    else if (mode == "bc5")
+    {
+        format = msb::BlockFormat::BC5;
+    }
+    else
+    {
+        usage();
+        return 1;
+    }
+
+    // flipped like every texture the renderer loads
+    Image img(input, ImageOptions{true, 4});
+    if (img.data == nullptr)
+    {
+        std::cout << "Error: could not load " << input << ": " << stbi_failure_reason() << "\n";
+        return 1;
+    }
+
+    auto width = img.width;
+    auto height = img.height;
+    auto texture = msb::compressTexture(img.data, width, height, format, srgb);
+    auto error = rmse(img.data, width, height, format, texture.levels[0]);
+
+    if (!msb::writeKtx(output, texture))
+    {
+        std::cout << "Error: could not write " << output << "\n";
+        return 1;
+    }
+
+    size_t bytes = 0;
+    for (auto& level : texture.levels)
+    {
+        bytes += level.data.size();
+    }
+
+    std::cout << input << " -> " << output << ": " << width << "x" << height << ", "
+              << texture.levels.size() << " levels, " << bytes << " bytes, base level RMSE "
+              << error << "\n";
+
+    return 0;
+}